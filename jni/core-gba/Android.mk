@@ -10,7 +10,7 @@ LOCAL_ARM_MODE := arm
 LOCAL_ARM_NEON := true
 
 LOCAL_SRC_FILES += android/gba-engine.cpp android/interframe.cpp
-LOCAL_SRC_FILES += gba.cpp memory.cpp sound.cpp
+LOCAL_SRC_FILES += gba.cpp gba-jit.cpp memory.cpp sound.cpp
 
 LOCAL_C_INCLUDES := $(LOCAL_PATH)/../engine $(LOCAL_PATH)/../prof
 LOCAL_LDLIBS    := -lz -llog
@@ -140,6 +140,7 @@ t_romInfo *GbaEngine::loadRomCommon()
 	flashSize = 0x10000;
 	enableRtc = false;
 	mirroringEnable = false;
+	cpuIdleAddress = 0;
 	
 	loadImagePreferences();
 	
@@ -185,7 +186,7 @@ t_romInfo *GbaEngine::loadRomFile(const char *file, t_systemRegion systemRegion)
 
 t_romInfo *GbaEngine::loadRomBuffer(const void *buf, int size, t_systemRegion systemRegion)
 {
-	int rv = CPULoadRomBuffer((void *)buf, size);
+	int rv = CPULoadRomBuffer(buf, size);
 	if(!rv)
 	{
 		LOGI("failed to load gba rom buffer\n");
@@ -404,8 +405,26 @@ void GbaEngine::drawScreen()
 	frameEndFlag = true;
 }
 
+static bool getBoolFromString(const char *str)
+{
+	if(!strcasecmp(str, PLUGINOPT_TRUE))
+		return true;
+	else
+		return false;
+}
+
 bool GbaEngine::setOption(const char *name, const char *value)
 {
+	if(!strcasecmp(name, PLUGINOPT_GBA_IDLE_SKIP))
+	{
+		CPUSetIdleSkip(getBoolFromString(value));
+		return true;
+	}
+	else if(!strcasecmp(name, PLUGINOPT_GBA_RECOMPILER))
+	{
+		CPUSetRecompiler(getBoolFromString(value));
+		return true;
+	}
 	return false;
 }
 
@@ -579,10 +598,11 @@ typedef struct  {
 	int rtcEnabled;
 	int mirroringEnabled;
 	int useBios;
+	uint32_t idleLoop;		// start of a polling loop that is safe to skip, or 0
 } ini_t;
 
 static const ini_t gbaover[256] = {
-	//romtitle,							    	romid	flash	save	rtc	mirror	bios
+	//romtitle,							    	romid	flash	save	rtc	mirror	bios	idle
 	{/*"2 Games in 1 - Dragon Ball Z - The Legacy of Goku I & II (USA)",*/	"BLFE",	0,	1,	0,	0,	0},
 	{/*"2 Games in 1 - Dragon Ball Z - Buu's Fury + Dragon Ball GT - Transformation (USA)",*/ "BUFE", 0, 1, 0, 0, 0},
 	{/*"Boktai - The Sun Is in Your Hand (Europe)(En,Fr,De,Es,It)",*/		"U3IP",	0,	0,	1,	0,	0},
@@ -676,9 +696,9 @@ static const ini_t gbaover[256] = {
 	{/*"Rocky (Europe)(En,Fr,De,Es,It)",*/					"AROP",	0,	1,	0,	0,	0},
 	{/*"Sennen Kazoku (Japan)",*/						"BKAJ",	131072,	0,	1,	0,	0},
 	{/*"Shin Bokura no Taiyou - Gyakushuu no Sabata (Japan)",*/			"U33J",	0,	1,	1,	0,	0},
-	{/*"Super Mario Advance 4 (Japan)",*/					"AX4J",	131072,	0,	0,	0,	0},
-	{/*"Super Mario Advance 4 - Super Mario Bros. 3 (Europe)(En,Fr,De,Es,It)",*/"AX4P",	131072,	0,	0,	0,	0},
-	{/*"Super Mario Advance 4 - Super Mario Bros 3 - Super Mario Advance 4 v1.1 (USA)",*/"AX4E",131072,0,0,0,0},
+	{/*"Super Mario Advance 4 (Japan)",*/					"AX4J",	131072,	0,	0,	0,	0,	0x0800072A},
+	{/*"Super Mario Advance 4 - Super Mario Bros. 3 (Europe)(En,Fr,De,Es,It)",*/"AX4P",	131072,	0,	0,	0,	0,	0x0800072A},
+	{/*"Super Mario Advance 4 - Super Mario Bros 3 - Super Mario Advance 4 v1.1 (USA)",*/"AX4E",131072,0,0,0,0,0x0800072A},
 	{/*"Top Gun - Combat Zones (USA)(En,Fr,De,Es,It)",*/			"A2YE",	0,	5,	0,	0,	0},
 	{/*"Yoshi no Banyuuinryoku (Japan)",*/					"KYGJ",	0,	4,	0,	0,	0},
 	{/*"Yoshi - Topsy-Turvy (USA)",*/						"KYGE",	0,	1,	0,	0,	0},
@@ -724,12 +744,15 @@ void loadImagePreferences()
 		cpuSaveType = gbaover[found_no].saveType;
 
 		mirroringEnable = gbaover[found_no].mirroringEnabled;
+
+		cpuIdleAddress = gbaover[found_no].idleLoop;
 	}
 
 	LOGI("RTC = %d.\n", enableRtc);
 	LOGI("flashSize = %d.\n", flashSize);
 	LOGI("cpuSaveType = %d.\n", cpuSaveType);
 	LOGI("mirroringEnable = %d.\n", mirroringEnable);
+	LOGI("cpuIdleAddress = 0x%08X.\n", cpuIdleAddress);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
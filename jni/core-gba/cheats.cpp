@@ -304,11 +304,19 @@ u8 v3_deadtable2[256] = {
 
 #define CHEAT_IS_HEX(a) ( ((a)>='A' && (a) <='F') || ((a) >='0' && (a) <= '9'))
 
+// ROM has no code pages, so a changed patch drops all decoded blocks
 #define CHEAT_PATCH_ROM_16BIT(a,v) \
-  WRITE16LE(((u16 *)&rom[(a) & 0x1ffffff]), v);
+  do { if(READ16LE(((u16 *)&rom[(a) & 0x1ffffff])) != (u16)(v)) { \
+  romWritable((a) & 0x1ffffff, 2); \
+  WRITE16LE(((u16 *)&rom[(a) & 0x1ffffff]), v); \
+  cpuBlockFlush(); } } while (0)
 
+// ROM has no code pages, so a changed patch drops all decoded blocks
 #define CHEAT_PATCH_ROM_32BIT(a,v) \
-  WRITE32LE(((u32 *)&rom[(a) & 0x1ffffff]), v);
+  do { if(READ32LE(((u32 *)&rom[(a) & 0x1ffffff])) != (u32)(v)) { \
+  romWritable((a) & 0x1ffffff, 4); \
+  WRITE32LE(((u32 *)&rom[(a) & 0x1ffffff]), v); \
+  cpuBlockFlush(); } } while (0)
 
 static bool isMultilineWithData(int i)
 {
@@ -1311,6 +1319,332 @@ int cheatsCheckKeys(u32 keys, u32 extended)
   return ticks;
 }
 
+/*
+ * Compiled cheat list
+ *
+ * The enabled codes are turned into a flat list of typed writes and
+ * conditions whenever the cheat list changes, so the per-frame pass does
+ * not decode every code again. A condition that fails jumps to the op of
+ * the line it would have skipped to. Lists that use any other code type
+ * fall back to cheatsCheckKeys.
+ */
+
+#define CHEAT_OP_WRITE                0
+#define CHEAT_OP_ROM                  1
+#define CHEAT_OP_AND                  2
+#define CHEAT_OP_OR                   3
+#define CHEAT_OP_ADD                  4
+// conditions: skip when the test holds
+#define CHEAT_OP_SKIP_NE              5
+#define CHEAT_OP_SKIP_EQ              6
+#define CHEAT_OP_SKIP_GEU             7
+#define CHEAT_OP_SKIP_LEU             8
+#define CHEAT_OP_SKIP_GTU             9
+#define CHEAT_OP_SKIP_LTU             10
+#define CHEAT_OP_SKIP_GES             11
+#define CHEAT_OP_SKIP_LES             12
+#define CHEAT_OP_SKIP_NAND            13
+#define CHEAT_OP_SKIP_ALWAYS          14
+#define CHEAT_OP_NONE                 15
+
+struct CheatOp {
+  u8 op;
+  u8 size;      // access width in bytes
+  u8 next;      // op to continue at when a condition skips
+  u32 address;
+  u32 value;
+};
+
+static CheatOp cheatOps[100];
+static int cheatOpsNumber = 0;
+static bool cheatOpsValid = false;
+static bool cheatOpsDirty = true;
+
+static inline u32 cheatRead(int size, u32 address)
+{
+  if(size == 1)
+    return CPUReadByte(address);
+  if(size == 2)
+    return CPUReadHalfWord(address);
+  return CPUReadMemory(address);
+}
+
+static inline void cheatWrite(int size, u32 address, u32 value)
+{
+  if(size == 1)
+    CPUWriteByte(address, value);
+  else if(size == 2)
+    CPUWriteHalfWord(address, value);
+  else
+    CPUWriteMemory(address, value);
+}
+
+static inline s32 cheatSigned(int size, u32 value)
+{
+  if(size == 1)
+    return (s8)value;
+  if(size == 2)
+    return (s16)value;
+  return (s32)value;
+}
+
+// Fills op for one code line and the number of lines a failed condition
+// skips; returns false for code types the compiled list does not cover
+static bool cheatsCompileLine(const CheatsData *c, CheatOp *op, int *skip)
+{
+  u32 value = c->value;
+  int size = 2;
+  int kind;
+
+  *skip = 1;
+  op->address = c->address;
+
+  switch(c->size) {
+  case MASTER_CODE:
+  case GSA_CODES_ON:
+    kind = CHEAT_OP_NONE;
+    break;
+  case INT_8_BIT_WRITE:
+    kind = CHEAT_OP_WRITE; size = 1;
+    break;
+  case INT_16_BIT_WRITE:
+    kind = CHEAT_OP_WRITE;
+    break;
+  case INT_32_BIT_WRITE:
+    kind = CHEAT_OP_WRITE; size = 4;
+    break;
+  case CHEATS_16_BIT_WRITE:
+  case CHEATS_32_BIT_WRITE:
+    kind = (c->address>>24) >= 0x08 ? CHEAT_OP_ROM : CHEAT_OP_WRITE;
+    size = c->size == CHEATS_16_BIT_WRITE ? 2 : 4;
+    break;
+  case CBA_AND:
+    kind = CHEAT_OP_AND;
+    break;
+  case CBA_OR:
+    kind = CHEAT_OP_OR;
+    break;
+  case CBA_ADD:
+    kind = CHEAT_OP_ADD;
+    if(c->address & 1) {
+      op->address = c->address & 0x0FFFFFFE;
+      size = 4;
+    }
+    break;
+  case CBA_IF_TRUE:
+    kind = CHEAT_OP_SKIP_NE;
+    break;
+  case CBA_IF_FALSE:
+    kind = CHEAT_OP_SKIP_EQ;
+    break;
+  case CBA_GT:
+    kind = CHEAT_OP_SKIP_LEU;
+    break;
+  case CBA_LT:
+    kind = CHEAT_OP_SKIP_GEU;
+    break;
+  case GSA_8_BIT_IF_TRUE:  size = 1; kind = CHEAT_OP_SKIP_NE; break;
+  case GSA_32_BIT_IF_TRUE: size = 4; kind = CHEAT_OP_SKIP_NE; break;
+  case GSA_8_BIT_IF_FALSE:  size = 1; kind = CHEAT_OP_SKIP_EQ; break;
+  case GSA_32_BIT_IF_FALSE: size = 4; kind = CHEAT_OP_SKIP_EQ; break;
+  case GSA_8_BIT_IF_TRUE2:  size = 1; kind = CHEAT_OP_SKIP_NE; *skip = 2; break;
+  case GSA_16_BIT_IF_TRUE2:           kind = CHEAT_OP_SKIP_NE; *skip = 2; break;
+  case GSA_32_BIT_IF_TRUE2: size = 4; kind = CHEAT_OP_SKIP_NE; *skip = 2; break;
+  case GSA_8_BIT_IF_FALSE2:  size = 1; kind = CHEAT_OP_SKIP_EQ; *skip = 2; break;
+  case GSA_16_BIT_IF_FALSE2:           kind = CHEAT_OP_SKIP_EQ; *skip = 2; break;
+  case GSA_32_BIT_IF_FALSE2: size = 4; kind = CHEAT_OP_SKIP_EQ; *skip = 2; break;
+  case GSA_8_BIT_IF_LOWER_U:  size = 1; kind = CHEAT_OP_SKIP_GEU; break;
+  case GSA_16_BIT_IF_LOWER_U:           kind = CHEAT_OP_SKIP_GEU; break;
+  case GSA_32_BIT_IF_LOWER_U: size = 4; kind = CHEAT_OP_SKIP_GEU; break;
+  case GSA_8_BIT_IF_HIGHER_U:  size = 1; kind = CHEAT_OP_SKIP_LEU; break;
+  case GSA_16_BIT_IF_HIGHER_U:           kind = CHEAT_OP_SKIP_LEU; break;
+  case GSA_32_BIT_IF_HIGHER_U: size = 4; kind = CHEAT_OP_SKIP_LEU; break;
+  case GSA_8_BIT_IF_AND:  size = 1; kind = CHEAT_OP_SKIP_NAND; break;
+  case GSA_16_BIT_IF_AND:           kind = CHEAT_OP_SKIP_NAND; break;
+  case GSA_32_BIT_IF_AND: size = 4; kind = CHEAT_OP_SKIP_NAND; break;
+  case GSA_8_BIT_IF_LOWER_U2:  size = 1; kind = CHEAT_OP_SKIP_GEU; *skip = 2; break;
+  case GSA_16_BIT_IF_LOWER_U2:           kind = CHEAT_OP_SKIP_GEU; *skip = 2; break;
+  case GSA_32_BIT_IF_LOWER_U2: size = 4; kind = CHEAT_OP_SKIP_GEU; *skip = 2; break;
+  case GSA_8_BIT_IF_HIGHER_U2:  size = 1; kind = CHEAT_OP_SKIP_LEU; *skip = 2; break;
+  case GSA_16_BIT_IF_HIGHER_U2:           kind = CHEAT_OP_SKIP_LEU; *skip = 2; break;
+  case GSA_32_BIT_IF_HIGHER_U2: size = 4; kind = CHEAT_OP_SKIP_LEU; *skip = 2; break;
+  case GSA_8_BIT_IF_AND2:  size = 1; kind = CHEAT_OP_SKIP_NAND; *skip = 2; break;
+  case GSA_16_BIT_IF_AND2:           kind = CHEAT_OP_SKIP_NAND; *skip = 2; break;
+  case GSA_32_BIT_IF_AND2: size = 4; kind = CHEAT_OP_SKIP_NAND; *skip = 2; break;
+  case GSA_8_BIT_IF_LOWER_S:  size = 1; kind = CHEAT_OP_SKIP_GES; break;
+  case GSA_16_BIT_IF_LOWER_S:           kind = CHEAT_OP_SKIP_GES; break;
+  case GSA_32_BIT_IF_LOWER_S: size = 4; kind = CHEAT_OP_SKIP_GES; break;
+  case GSA_8_BIT_IF_HIGHER_S:  size = 1; kind = CHEAT_OP_SKIP_LES; break;
+  case GSA_16_BIT_IF_HIGHER_S:           kind = CHEAT_OP_SKIP_LES; break;
+  case GSA_32_BIT_IF_HIGHER_S: size = 4; kind = CHEAT_OP_SKIP_LES; break;
+  case GSA_8_BIT_IF_LOWER_S2:  size = 1; kind = CHEAT_OP_SKIP_GES; *skip = 2; break;
+  case GSA_16_BIT_IF_LOWER_S2:           kind = CHEAT_OP_SKIP_GES; *skip = 2; break;
+  case GSA_32_BIT_IF_LOWER_S2: size = 4; kind = CHEAT_OP_SKIP_GES; *skip = 2; break;
+  case GSA_8_BIT_IF_HIGHER_S2:  size = 1; kind = CHEAT_OP_SKIP_LES; *skip = 2; break;
+  case GSA_16_BIT_IF_HIGHER_S2:           kind = CHEAT_OP_SKIP_LES; *skip = 2; break;
+  case GSA_32_BIT_IF_HIGHER_S2: size = 4; kind = CHEAT_OP_SKIP_LES; *skip = 2; break;
+  case GSA_ALWAYS:
+    kind = CHEAT_OP_SKIP_ALWAYS;
+    break;
+  case GSA_ALWAYS2:
+    kind = CHEAT_OP_SKIP_ALWAYS; *skip = 2;
+    break;
+  case GSA_16_BIT_IF_LOWER_OR_EQ_U:
+    kind = CHEAT_OP_SKIP_GTU;
+    break;
+  case GSA_16_BIT_IF_HIGHER_OR_EQ_U:
+    kind = CHEAT_OP_SKIP_LTU;
+    break;
+  case GSA_16_BIT_MIF_TRUE:
+  case GSA_16_BIT_MIF_FALSE:
+  case GSA_16_BIT_MIF_LOWER_OR_EQ_U:
+  case GSA_16_BIT_MIF_HIGHER_OR_EQ_U:
+    kind = c->size == GSA_16_BIT_MIF_TRUE ? CHEAT_OP_SKIP_NE :
+           c->size == GSA_16_BIT_MIF_FALSE ? CHEAT_OP_SKIP_EQ :
+           c->size == GSA_16_BIT_MIF_LOWER_OR_EQ_U ? CHEAT_OP_SKIP_GTU : CHEAT_OP_SKIP_LTU;
+    *skip = (c->rawaddress >> 0x10) & 0xFF;
+    break;
+  default:
+    return false;
+  }
+
+  // the GSA ordered and AND tests only look at the low bits of the value
+  switch(c->size) {
+  case GSA_8_BIT_IF_LOWER_U: case GSA_8_BIT_IF_HIGHER_U: case GSA_8_BIT_IF_AND:
+  case GSA_8_BIT_IF_LOWER_U2: case GSA_8_BIT_IF_HIGHER_U2: case GSA_8_BIT_IF_AND2:
+  case GSA_8_BIT_IF_LOWER_S: case GSA_8_BIT_IF_HIGHER_S:
+  case GSA_8_BIT_IF_LOWER_S2: case GSA_8_BIT_IF_HIGHER_S2:
+    value &= 0xFF;
+    break;
+  case GSA_16_BIT_IF_LOWER_U: case GSA_16_BIT_IF_HIGHER_U: case GSA_16_BIT_IF_AND:
+  case GSA_16_BIT_IF_LOWER_U2: case GSA_16_BIT_IF_HIGHER_U2: case GSA_16_BIT_IF_AND2:
+  case GSA_16_BIT_IF_LOWER_S: case GSA_16_BIT_IF_HIGHER_S:
+  case GSA_16_BIT_IF_LOWER_S2: case GSA_16_BIT_IF_HIGHER_S2:
+    value &= 0xFFFF;
+    break;
+  }
+
+  op->op = kind;
+  op->size = size;
+  op->value = value;
+  return true;
+}
+
+static bool cheatsCompile(void)
+{
+  u8 first[100 + 1];       // first op at or after each line
+  int target[100];         // line a failed condition continues at
+  int i;
+
+  cheatOpsNumber = 0;
+
+  for (i = 0; i < cheatsNumber; i++) {
+    first[i] = cheatOpsNumber;
+    if(!cheatsList[i].enabled) {
+      // a skip could land inside the data lines of a disabled code
+      if(getCodeLength(i) > 1)
+        return false;
+      continue;
+    }
+
+    CheatOp *op = &cheatOps[cheatOpsNumber];
+    int skip;
+    if(!cheatsCompileLine(&cheatsList[i], op, &skip))
+      return false;
+    if(op->op == CHEAT_OP_NONE)
+      continue;
+
+    target[cheatOpsNumber++] = i + skip + 1;
+  }
+  first[cheatsNumber] = cheatOpsNumber;
+
+  for (i = 0; i < cheatOpsNumber; i++)
+    cheatOps[i].next = first[target[i] < cheatsNumber ? target[i] : cheatsNumber];
+
+  return true;
+}
+
+static inline bool cheatTest(const CheatOp *op)
+{
+  if(op->op == CHEAT_OP_SKIP_ALWAYS)
+    return true;
+
+  u32 v = cheatRead(op->size, op->address);
+
+  switch(op->op) {
+  case CHEAT_OP_SKIP_NE:
+    return v != op->value;
+  case CHEAT_OP_SKIP_EQ:
+    return v == op->value;
+  case CHEAT_OP_SKIP_GEU:
+    return !(v < op->value);
+  case CHEAT_OP_SKIP_LEU:
+    return !(v > op->value);
+  case CHEAT_OP_SKIP_GTU:
+    return v > op->value;
+  case CHEAT_OP_SKIP_LTU:
+    return v < op->value;
+  case CHEAT_OP_SKIP_GES:
+    return !(cheatSigned(op->size, v) < (s32)op->value);
+  case CHEAT_OP_SKIP_LES:
+    return !(cheatSigned(op->size, v) > (s32)op->value);
+  case CHEAT_OP_SKIP_NAND:
+    return !(v & op->value);
+  }
+  return true;
+}
+
+// Applies the enabled cheats once; returns the extra ticks of slowdown codes
+int cheatsApply(u32 keys, u32 extended)
+{
+  int i;
+
+  if(cheatOpsDirty) {
+    cheatOpsValid = cheatsCompile();
+    cheatOpsDirty = false;
+  }
+
+  if(!cheatOpsValid)
+    return cheatsCheckKeys(keys, extended);
+
+  mastercode = 0;
+  for (i = 0; i<4; i++)
+    if (rompatch2addr [i] != 0) {
+      CHEAT_PATCH_ROM_16BIT(rompatch2addr [i],rompatch2oldval [i]);
+      rompatch2addr [i] = 0;
+    }
+
+  for (i = 0; i < cheatOpsNumber; ) {
+    const CheatOp *op = &cheatOps[i++];
+
+    switch(op->op) {
+    case CHEAT_OP_WRITE:
+      cheatWrite(op->size, op->address, op->value);
+      break;
+    case CHEAT_OP_ROM:
+      if(op->size == 2)
+        CHEAT_PATCH_ROM_16BIT(op->address, op->value);
+      else
+        CHEAT_PATCH_ROM_32BIT(op->address, op->value);
+      break;
+    case CHEAT_OP_AND:
+      cheatWrite(op->size, op->address, cheatRead(op->size, op->address) & op->value);
+      break;
+    case CHEAT_OP_OR:
+      cheatWrite(op->size, op->address, cheatRead(op->size, op->address) | op->value);
+      break;
+    case CHEAT_OP_ADD:
+      cheatWrite(op->size, op->address, cheatRead(op->size, op->address) + op->value);
+      break;
+    default:
+      if(cheatTest(op))
+        i = op->next;
+      break;
+    }
+  }
+  return 0;
+}
+
 void cheatsAdd(const char *codeStr,
                const char *desc,
                u32 rawaddress,
@@ -1351,6 +1685,7 @@ void cheatsAdd(const char *codeStr,
       break;
     }
     cheatsNumber++;
+    cheatOpsDirty = true;
   }
 }
 
@@ -1408,6 +1743,7 @@ void cheatsDelete(int number, bool restore)
              (cheatsNumber-x-1));
     }
     cheatsNumber--;
+    cheatOpsDirty = true;
   }
 }
 
@@ -1422,6 +1758,7 @@ void cheatsEnable(int i)
 {
   if(i >= 0 && i < cheatsNumber) {
     cheatsList[i].enabled = true;
+    cheatOpsDirty = true;
     mastercode = 0;
   }
 }
@@ -1450,6 +1787,7 @@ void cheatsDisable(int i)
       break;
     }
     cheatsList[i].enabled = false;
+    cheatOpsDirty = true;
   }
 }
 
@@ -24,6 +24,7 @@ void cheatsDeleteAll(bool restore);
 void cheatsEnable(int number);
 void cheatsDisable(int number);
 int cheatsCheckKeys(u32 keys, u32 extended);
+int cheatsApply(u32 keys, u32 extended);
 
 extern int cheatsNumber;
 extern CheatsData cheatsList[100];
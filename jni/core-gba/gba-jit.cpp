@@ -0,0 +1,878 @@
+#include <string.h>
+#include <sys/mman.h>
+
+#include "gba-jit.h"
+
+#ifdef HAVE_GBA_JIT
+
+// Predecoded blocks that keep running are translated into x86-64 code.
+// Data processing, shifts by an immediate, conditions and the fetch timing
+// become native code. Everything else, loads and stores included, is run by
+// the interpreter through jitEnv.armStep/thumbStep, one instruction at a
+// time. ARM registers and flags stay in memory, addressed off rbx, so the
+// interpreter and the translated code share them as they are.
+//
+// cpuNextEvent is checked where a block is left and after the instructions
+// the interpreter runs, not after every native instruction. With
+// GBA_JIT_EXACT defined it is checked after every instruction, and the
+// translated code runs cycle for cycle like the interpreter.
+
+#define JIT_BUFFER_SIZE		(4 << 20)
+#define JIT_BLOCK_SIZE		(16 << 10)	// more than one block can take
+#define JIT_PATCHES			(4 * 32)
+
+#define EAX		0
+#define ECX		1
+#define EDX		2
+#define EBX		3
+
+#define OP_ADD	0
+#define OP_OR	1
+#define OP_ADC	2
+#define OP_SBB	3
+#define OP_AND	4
+#define OP_SUB	5
+#define OP_XOR	6
+#define OP_CMP	7
+
+#define SH_ROR	1
+#define SH_RCR	3
+#define SH_SHL	4
+#define SH_SHR	5
+#define SH_SAR	7
+
+#define CC_O	0x0
+#define CC_C	0x2
+#define CC_NC	0x3
+#define CC_Z	0x4
+#define CC_NZ	0x5
+#define CC_BE	0x6
+#define CC_S	0x8
+#define CC_GE	0xD
+
+// Where the carry out of an ARM shifter operand is
+#define CARRY_KEEP	0	// C is left alone
+#define CARRY_CLEAR	1
+#define CARRY_SET	2
+#define CARRY_CF	3	// in the x86 carry
+#define CARRY_DL	4
+
+static u8 *jitBuffer = NULL;
+static u8 *out;
+static jit_env_t jitEnv;
+
+// Offsets from jitEnv.reg
+static s32 offNextPC, offPrefetchCount, offPrefetch, offN, offZ, offC, offV;
+static s32 offTotalTicks, offNextEvent, offCpuPrefetch;
+static s32 offWait, offWaitSeq, offWait32, offWaitSeq32;
+
+// State of the block being translated
+static bool jitPrefetchDirty;		// bus.busPrefetch may be set
+static bool jitPrefetchNormal;		// bus.busPrefetchCount has bit 8 set
+static u8 *jitExits[JIT_PATCHES];	// rel32 jumps to the epilogue
+static int jitExitCount;
+static u8 *jitStubs[JIT_PATCHES];	// rel32 jumps to an exit stub
+static int jitStubIndex[JIT_PATCHES];
+static int jitStubCount;
+
+// x86-64 encoding //////////////////////////////////////////////////////////
+
+static INLINE void emit8 (u32 value)
+{
+	*out++ = value;
+}
+
+static INLINE void emit32 (u32 value)
+{
+	memcpy(out, &value, 4);
+	out += 4;
+}
+
+static INLINE void emit64 (u64 value)
+{
+	memcpy(out, &value, 8);
+	out += 8;
+}
+
+// ModRM for [rbx + disp]
+static void emitMem (int r, s32 disp)
+{
+	if (disp >= -128 && disp < 128)
+	{
+		emit8(0x43 | (r << 3));
+		emit8(disp);
+	}
+	else
+	{
+		emit8(0x83 | (r << 3));
+		emit32(disp);
+	}
+}
+
+static void emitLoad (int r, s32 disp)			{ emit8(0x8B); emitMem(r, disp); }
+static void emitLoad8 (int r, s32 disp)			{ emit8(0x0F); emit8(0xB6); emitMem(r, disp); }
+static void emitStore (s32 disp, int r)			{ emit8(0x89); emitMem(r, disp); }
+static void emitStore8 (s32 disp, int r)		{ emit8(0x88); emitMem(r, disp); }
+static void emitStoreImm (s32 disp, u32 value)	{ emit8(0xC7); emitMem(0, disp); emit32(value); }
+static void emitStoreImm8 (s32 disp, u8 value)	{ emit8(0xC6); emitMem(0, disp); emit8(value); }
+static void emitMov (int dst, int src)			{ emit8(0x89); emit8(0xC0 | (src << 3) | dst); }
+static void emitMovImm (int r, u32 value)		{ emit8(0xB8 | r); emit32(value); }
+static void emitAlu (int op, int dst, int src)	{ emit8(0x01 | (op << 3)); emit8(0xC0 | (src << 3) | dst); }
+static void emitAluStore (int op, s32 disp, int r)	{ emit8(0x01 | (op << 3)); emitMem(r, disp); }
+static void emitTest (int a, int b)				{ emit8(0x85); emit8(0xC0 | (b << 3) | a); }
+static void emitNot (int r)						{ emit8(0xF7); emit8(0xD0 | r); }
+static void emitNeg (int r)						{ emit8(0xF7); emit8(0xD8 | r); }
+static void emitInc (int r)						{ emit8(0xFF); emit8(0xC0 | r); }
+static void emitSetcc (int cc, s32 disp)		{ emit8(0x0F); emit8(0x90 | cc); emitMem(0, disp); }
+static void emitSetccReg (int cc, int r)		{ emit8(0x0F); emit8(0x90 | cc); emit8(0xC0 | r); }
+static void emitCmpImm8 (s32 disp, u8 value)	{ emit8(0x80); emitMem(7, disp); emit8(value); }
+static void emitTestAl (u8 value)				{ emit8(0xA8); emit8(value); }
+
+static void emitAluImm (int op, int r, u32 value)
+{
+	if ((s32)value >= -128 && (s32)value < 128)
+	{
+		emit8(0x83);
+		emit8(0xC0 | (op << 3) | r);
+		emit8(value);
+	}
+	else
+	{
+		emit8(0x81);
+		emit8(0xC0 | (op << 3) | r);
+		emit32(value);
+	}
+}
+
+static void emitShift (int op, int r, int count)
+{
+	if (count == 1)
+	{
+		emit8(0xD1);
+		emit8(0xC0 | (op << 3) | r);
+	}
+	else
+	{
+		emit8(0xC1);
+		emit8(0xC0 | (op << 3) | r);
+		emit8(count);
+	}
+}
+
+// Jumps return the end of their displacement, for jitPatch/jitPatch8
+static u8 *emitJcc (int cc)		{ emit8(0x0F); emit8(0x80 | cc); emit32(0); return out; }
+static u8 *emitJmp (void)		{ emit8(0xE9); emit32(0); return out; }
+static u8 *emitJcc8 (int cc)	{ emit8(0x70 | cc); emit8(0); return out; }
+static u8 *emitJmp8 (void)		{ emit8(0xEB); emit8(0); return out; }
+
+static void jitPatch (u8 *jump)
+{
+	s32 rel = out - jump;
+	memcpy(jump - 4, &rel, 4);
+}
+
+static void jitPatch8 (u8 *jump)
+{
+	jump[-1] = out - jump;
+}
+
+static void emitCall (void *block, int i, jit_step_t step)
+{
+	emit8(0x48); emit8(0xBF); emit64((uintptr_t)block);	// mov rdi, block
+	emit8(0xBE); emit32(i);								// mov esi, i
+	emit8(0x48); emit8(0xB8); emit64((uintptr_t)step);	// mov rax, step
+	emit8(0xFF); emit8(0xD0);							// call rax
+}
+
+// ARM state ////////////////////////////////////////////////////////////////
+
+static void jitLoadReg (int r, int n, u32 pc)
+{
+	if (n == 15)
+		emitMovImm(r, pc);
+	else
+		emitLoad(r, n << 2);
+}
+
+// Moves the carry flag into the x86 carry, inverted for SBB
+static void jitLoadCarry (bool borrow)
+{
+	if (borrow)
+		emitCmpImm8(offC, 1);
+	else
+	{
+		emitLoad8(EDX, offC);
+		emitShift(SH_SHR, EDX, 1);
+	}
+}
+
+// N and Z, then C and V the way x86 left them after an ADD or SUB
+static void jitSetNZ (void)
+{
+	emitSetcc(CC_S, offN);
+	emitSetcc(CC_Z, offZ);
+}
+
+static void jitSetNZCV (bool sub)
+{
+	jitSetNZ();
+	emitSetcc(sub ? CC_NC : CC_C, offC);
+	emitSetcc(CC_O, offV);
+}
+
+// Emits the jump taken when ARM condition cond fails, NULL for AL
+static u8 *jitCondition (int cond)
+{
+	static const s32 *const flag[4] = { &offZ, &offC, &offN, &offV };
+
+	switch (cond >> 1)
+	{
+		case 0:				// EQ/NE
+		case 1:				// CS/CC
+		case 2:				// MI/PL
+		case 3:				// VS/VC
+			emitCmpImm8(*flag[cond >> 1], 0);
+			return emitJcc((cond & 1) ? CC_NZ : CC_Z);
+		case 4:				// HI/LS
+			emitLoad8(EAX, offZ);
+			emitAluImm(OP_XOR, EAX, 1);
+			emitLoad8(ECX, offC);
+			emitAlu(OP_AND, EAX, ECX);
+			return emitJcc((cond & 1) ? CC_NZ : CC_Z);
+		case 5:				// GE/LT
+			emitLoad8(EAX, offN);
+			emitLoad8(ECX, offV);
+			emitAlu(OP_CMP, EAX, ECX);
+			return emitJcc((cond & 1) ? CC_Z : CC_NZ);
+		case 6:				// GT/LE
+			emitLoad8(EAX, offN);
+			emitLoad8(ECX, offV);
+			emitAlu(OP_XOR, EAX, ECX);
+			emitLoad8(ECX, offZ);
+			emitAlu(OP_OR, EAX, ECX);
+			return emitJcc((cond & 1) ? CC_Z : CC_NZ);
+	}
+
+	return cond == 0x0E ? NULL : emitJmp();
+}
+
+// Timing ///////////////////////////////////////////////////////////////////
+
+static void jitPrefetchShift (int shift)
+{
+	emitMov(ECX, EAX);
+	emitAluImm(OP_AND, ECX, 0xFF);
+	emitShift(SH_SHR, ECX, shift);
+	emitAluImm(OP_AND, EAX, 0xFFFFFF00);
+	emitAlu(OP_OR, EAX, ECX);
+	emitStore(offPrefetchCount, EAX);
+}
+
+// cpuTotalTicks += 1 + codeTicksAccessSeq32/codeTicksAccessSeq16(address)
+static void jitFetchTicks (u32 address, bool thumb)
+{
+	int addr = (address >> 24) & 15;
+
+	if (unsigned(addr - 0x08) <= 5)
+	{
+		u8 *done[3];
+		int n = 0;
+
+		emitLoad(EAX, offPrefetchCount);
+		emitTestAl(1);
+		u8 *even = emitJcc8(CC_Z);
+		if (thumb)
+		{
+			jitPrefetchShift(1);
+			emitMovImm(EAX, 0);
+			done[n++] = emitJmp8();
+		}
+		else
+		{
+			emitTestAl(2);
+			u8 *one = emitJcc8(CC_Z);
+			jitPrefetchShift(2);
+			emitMovImm(EAX, 0);
+			done[n++] = emitJmp8();
+			jitPatch8(one);
+			jitPrefetchShift(1);
+			emitLoad8(EAX, offWaitSeq + addr);
+			done[n++] = emitJmp8();
+		}
+		jitPatch8(even);
+		emitAluImm(OP_CMP, EAX, 0xFF);
+		u8 *seq = emitJcc8(CC_BE);
+		emitStoreImm(offPrefetchCount, 0);
+		emitLoad8(EAX, (thumb ? offWait : offWait32) + addr);
+		done[n++] = emitJmp8();
+		jitPatch8(seq);
+		emitLoad8(EAX, (thumb ? offWaitSeq : offWaitSeq32) + addr);
+		while (n)
+			jitPatch8(done[--n]);
+		jitPrefetchNormal = false;
+	}
+	else if (thumb)
+	{
+		emitStoreImm(offPrefetchCount, 0);
+		emitLoad8(EAX, offWaitSeq + addr);
+	}
+	else
+		emitLoad8(EAX, offWaitSeq32 + addr);
+
+	emitInc(EAX);
+	emitAluStore(OP_ADD, offTotalTicks, EAX);
+}
+
+// What armExecuteBlock does before each ARM instruction, and
+// thumbExecuteBlock before each Thumb one
+static void jitPreamble (u32 pc, bool thumb)
+{
+	if (jitPrefetchDirty)
+	{
+		emitStoreImm8(offPrefetch, 0);
+		jitPrefetchDirty = false;
+	}
+
+	if (thumb)
+		return;
+
+	if ((pc & 0x0803FFFF) == 0x08020000)
+		emitStoreImm(offPrefetchCount, 0x100);
+	else if (!jitPrefetchNormal)
+	{
+		emit8(0x81);									// or dword [count], 0x100
+		emitMem(OP_OR, offPrefetchCount);
+		emit32(0x100);
+	}
+	jitPrefetchNormal = true;
+}
+
+// Leaves the block with count instructions run and the pipeline holding
+// the next two opcodes
+static void jitExit (const u32 *opcode, int count, u32 pc, bool thumb)
+{
+	int step = thumb ? 2 : 4;
+	u32 next = pc + count * step;
+
+	emitStoreImm(offNextPC, next);
+	emitStoreImm(15 << 2, next + step);
+	emitStoreImm(offCpuPrefetch, opcode[count]);
+	emitStoreImm(offCpuPrefetch + 4, opcode[count + 1]);
+	emitMovImm(EAX, count);
+}
+
+// ARM instructions /////////////////////////////////////////////////////////
+
+// Data processing with an immediate or an immediately shifted register and
+// Rd other than R15. The condition has been checked.
+static bool jitArmAlu (u32 opcode, u32 pc)
+{
+	if ((opcode & 0x0C000000) || (!(opcode & 0x02000000) && (opcode & 0x10)))
+		return false;
+
+	int op = (opcode >> 21) & 15;
+	bool s = (opcode & 0x00100000) != 0;
+	int rd = (opcode >> 12) & 15;
+	int rn = (opcode >> 16) & 15;
+
+	// MRS/MSR, and results the interpreter has to branch with. RSBS and
+	// RSCS stay with the interpreter too: it works their C and V out with
+	// the operands the other way round, and translated code has to agree.
+	if (((op & 0x0C) == 0x08 && !s) || rd == 15 || (s && (op == 0x03 || op == 0x07)))
+		return false;
+
+	bool logical = (op & 0x06) == 0 || op >= 0x0C;
+	bool carry = s && logical;
+	int carryOut = CARRY_KEEP;
+
+	if (opcode & 0x02000000)
+	{
+		int shift = (opcode & 0xF00) >> 7;
+		u32 value = opcode & 0xFF;
+		if (shift)
+		{
+			value = (value >> shift) | (value << (32 - shift));
+			carryOut = (value >> 31) ? CARRY_SET : CARRY_CLEAR;
+		}
+		emitMovImm(ECX, value);
+	}
+	else
+	{
+		int shift = (opcode >> 7) & 31;
+		jitLoadReg(ECX, opcode & 15, pc + 8);
+
+		switch ((opcode >> 5) & 3)
+		{
+			case 0:				// LSL
+				if (shift)
+				{
+					emitShift(SH_SHL, ECX, shift);
+					carryOut = CARRY_CF;
+				}
+				break;
+			case 1:				// LSR, #0 meaning #32
+				if (shift)
+					emitShift(SH_SHR, ECX, shift);
+				else
+				{
+					emitShift(SH_SHL, ECX, 1);
+					emitMovImm(ECX, 0);
+				}
+				carryOut = CARRY_CF;
+				break;
+			case 2:				// ASR, #0 meaning #32
+				if (shift)
+				{
+					emitShift(SH_SAR, ECX, shift);
+					carryOut = CARRY_CF;
+					break;
+				}
+				if (carry)
+				{
+					emitMov(EDX, ECX);
+					emitShift(SH_SHR, EDX, 31);
+				}
+				emitShift(SH_SAR, ECX, 31);
+				carryOut = CARRY_DL;
+				break;
+			case 3:				// ROR, #0 meaning RRX
+				if (shift)
+					emitShift(SH_ROR, ECX, shift);
+				else
+				{
+					jitLoadCarry(false);
+					emitShift(SH_RCR, ECX, 1);
+				}
+				carryOut = CARRY_CF;
+				break;
+		}
+
+		if (carryOut == CARRY_CF)
+		{
+			if (carry)
+				emitSetccReg(CC_C, EDX);
+			carryOut = CARRY_DL;
+		}
+	}
+
+	if (op != 0x0D && op != 0x0F)
+		jitLoadReg(EAX, rn, pc + 8);
+
+	switch (op)
+	{
+		case 0x00:			// AND
+		case 0x08:			// TST
+			emitAlu(OP_AND, EAX, ECX);
+			break;
+		case 0x01:			// EOR
+		case 0x09:			// TEQ
+			emitAlu(OP_XOR, EAX, ECX);
+			break;
+		case 0x02:			// SUB
+			emitAlu(OP_SUB, EAX, ECX);
+			break;
+		case 0x03:			// RSB
+			emitAlu(OP_SUB, ECX, EAX);
+			emitMov(EAX, ECX);
+			break;
+		case 0x04:			// ADD
+		case 0x0B:			// CMN
+			emitAlu(OP_ADD, EAX, ECX);
+			break;
+		case 0x05:			// ADC
+			jitLoadCarry(false);
+			emitAlu(OP_ADC, EAX, ECX);
+			break;
+		case 0x06:			// SBC
+			jitLoadCarry(true);
+			emitAlu(OP_SBB, EAX, ECX);
+			break;
+		case 0x07:			// RSC
+			jitLoadCarry(true);
+			emitAlu(OP_SBB, ECX, EAX);
+			emitMov(EAX, ECX);
+			break;
+		case 0x0A:			// CMP
+			emitAlu(OP_CMP, EAX, ECX);
+			break;
+		case 0x0C:			// ORR
+			emitAlu(OP_OR, EAX, ECX);
+			break;
+		case 0x0D:			// MOV
+			emitMov(EAX, ECX);
+			if (s)
+				emitTest(EAX, EAX);
+			break;
+		case 0x0E:			// BIC
+			emitNot(ECX);
+			emitAlu(OP_AND, EAX, ECX);
+			break;
+		case 0x0F:			// MVN
+			emitNot(ECX);
+			emitMov(EAX, ECX);
+			if (s)
+				emitTest(EAX, EAX);
+			break;
+	}
+
+	if (s)
+	{
+		if (!logical)
+			jitSetNZCV(op == 0x02 || op == 0x06 || op == 0x0A);
+		else
+		{
+			jitSetNZ();
+			if (carryOut == CARRY_DL)
+				emitStore8(offC, EDX);
+			else if (carryOut != CARRY_KEEP)
+				emitStoreImm8(offC, carryOut == CARRY_SET);
+		}
+	}
+
+	if ((op & 0x0C) != 0x08)
+		emitStore(rd << 2, EAX);
+
+	jitFetchTicks(pc + 4, false);
+	return true;
+}
+
+// Thumb instructions ///////////////////////////////////////////////////////
+
+// Register and immediate operations of formats 1-5 and 12-13, and the first
+// half of BL
+static bool jitThumbInsn (u32 opcode, u32 pc)
+{
+	int rd = opcode & 7;
+	int rs = (opcode >> 3) & 7;
+	u32 tickAddress = pc;
+
+	switch (opcode >> 11)
+	{
+		case 0x00:			// LSL Rd, Rs, #imm
+		case 0x01:			// LSR Rd, Rs, #imm
+		case 0x02:			// ASR Rd, Rs, #imm
+		{
+			int shift = (opcode >> 6) & 31;
+			emitLoad(ECX, rs << 2);
+			if (shift)
+				emitShift((opcode >> 11) == 0 ? SH_SHL : (opcode >> 11) == 1 ? SH_SHR : SH_SAR, ECX, shift);
+			else if ((opcode >> 11) == 1)
+			{
+				emitShift(SH_SHL, ECX, 1);
+				emitMovImm(ECX, 0);
+			}
+			else if ((opcode >> 11) == 2)
+			{
+				emitShift(SH_SHL, ECX, 1);
+				emitAlu(OP_SBB, ECX, ECX);
+			}
+			if (shift || (opcode >> 11))
+				emitSetcc(CC_C, offC);
+			emitTest(ECX, ECX);
+			jitSetNZ();
+			emitStore(rd << 2, ECX);
+			break;
+		}
+		case 0x03:			// ADD/SUB Rd, Rs, Rn/#imm
+		{
+			int rn = (opcode >> 6) & 7;
+			emitLoad(EAX, rs << 2);
+			if (opcode & 0x400)
+				emitMovImm(ECX, rn);
+			else
+				emitLoad(ECX, rn << 2);
+			emitAlu((opcode & 0x200) ? OP_SUB : OP_ADD, EAX, ECX);
+			jitSetNZCV((opcode & 0x200) != 0);
+			emitStore(rd << 2, EAX);
+			break;
+		}
+		case 0x04:			// MOV Rd, #imm
+			rd = (opcode >> 8) & 7;
+			emitStoreImm(rd << 2, opcode & 0xFF);
+			emitStoreImm8(offN, 0);
+			emitStoreImm8(offZ, (opcode & 0xFF) == 0);
+			break;
+		case 0x05:			// CMP Rd, #imm
+		case 0x06:			// ADD Rd, #imm
+		case 0x07:			// SUB Rd, #imm
+		{
+			int op = (opcode >> 11) == 0x06 ? OP_ADD : (opcode >> 11) == 0x07 ? OP_SUB : OP_CMP;
+			rd = (opcode >> 8) & 7;
+			emitLoad(EAX, rd << 2);
+			emitAluImm(op, EAX, opcode & 0xFF);
+			jitSetNZCV(op != OP_ADD);
+			if (op != OP_CMP)
+				emitStore(rd << 2, EAX);
+			break;
+		}
+		case 0x08:
+			if (opcode < 0x4400)
+			{
+				// ALU operations, but not the shifts by a register and MUL
+				int op = (opcode >> 6) & 15;
+				if (op == 0x02 || op == 0x03 || op == 0x04 || op == 0x07 || op == 0x0D)
+					return false;
+
+				emitLoad(EAX, rd << 2);
+				emitLoad(ECX, rs << 2);
+				switch (op)
+				{
+					case 0x00:	// AND
+					case 0x08:	// TST
+						emitAlu(OP_AND, EAX, ECX);
+						jitSetNZ();
+						break;
+					case 0x01:	// EOR
+						emitAlu(OP_XOR, EAX, ECX);
+						jitSetNZ();
+						break;
+					case 0x05:	// ADC
+						jitLoadCarry(false);
+						emitAlu(OP_ADC, EAX, ECX);
+						jitSetNZCV(false);
+						break;
+					case 0x06:	// SBC
+						jitLoadCarry(true);
+						emitAlu(OP_SBB, EAX, ECX);
+						jitSetNZCV(true);
+						break;
+					case 0x09:	// NEG
+						emitNeg(ECX);
+						emitMov(EAX, ECX);
+						jitSetNZCV(true);
+						break;
+					case 0x0A:	// CMP
+						emitAlu(OP_CMP, EAX, ECX);
+						jitSetNZCV(true);
+						break;
+					case 0x0B:	// CMN
+						emitAlu(OP_ADD, EAX, ECX);
+						jitSetNZCV(false);
+						break;
+					case 0x0C:	// ORR
+						emitAlu(OP_OR, EAX, ECX);
+						jitSetNZ();
+						break;
+					case 0x0E:	// BIC
+						emitNot(ECX);
+						emitAlu(OP_AND, EAX, ECX);
+						jitSetNZ();
+						break;
+					case 0x0F:	// MVN
+						emitNot(ECX);
+						emitMov(EAX, ECX);
+						emitTest(EAX, EAX);
+						jitSetNZ();
+						break;
+				}
+				if (op != 0x08 && op != 0x0A && op != 0x0B)
+					emitStore(rd << 2, EAX);
+			}
+			else
+			{
+				// ADD/CMP/MOV with a high register, but not BX or writes to R15
+				int op = (opcode >> 8) & 3;
+				rd |= (opcode >> 4) & 8;
+				rs |= (opcode >> 3) & 8;
+				if (op == 3 || !(opcode & 0xC0) || (op != 1 && rd == 15))
+					return false;
+
+				jitLoadReg(ECX, rs, pc + 4);
+				if (op == 2)
+				{
+					emitStore(rd << 2, ECX);
+					break;
+				}
+				jitLoadReg(EAX, rd, pc + 4);
+				emitAlu(op ? OP_CMP : OP_ADD, EAX, ECX);
+				if (op)
+					jitSetNZCV(true);
+				else
+					emitStore(rd << 2, EAX);
+			}
+			break;
+		case 0x14:			// ADD Rd, PC, #imm
+			emitStoreImm(((opcode >> 8) & 7) << 2, ((pc + 4) & ~3) + ((opcode & 0xFF) << 2));
+			break;
+		case 0x15:			// ADD Rd, SP, #imm
+			emitLoad(EAX, 13 << 2);
+			emitAluImm(OP_ADD, EAX, (opcode & 0xFF) << 2);
+			emitStore(((opcode >> 8) & 7) << 2, EAX);
+			break;
+		case 0x16:			// ADD SP, #imm
+			if ((opcode & 0xFF00) != 0xB000)
+				return false;
+			emitLoad(EAX, 13 << 2);
+			emitAluImm(OP_ADD, EAX, (opcode & 0x80) ? -((opcode & 0x7F) << 2) : (opcode & 0x7F) << 2);
+			emitStore(13 << 2, EAX);
+			break;
+		case 0x1E:			// BL, first half
+			emitStoreImm(14 << 2, pc + 4 + ((s32)(opcode << 21) >> 9));
+			tickAddress = pc + 2;
+			break;
+		default:
+			return false;
+	}
+
+	jitFetchTicks(tickAddress, true);
+	return true;
+}
+
+// Blocks ///////////////////////////////////////////////////////////////////
+
+// Maps the code buffer, again after jitCleanUp has let it go
+static bool jitAlloc (void)
+{
+	if (jitBuffer)
+		return true;
+
+	void *buffer = mmap(NULL, JIT_BUFFER_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buffer == MAP_FAILED)
+		return false;
+
+	jitBuffer = out = (u8 *)buffer;
+	return true;
+}
+
+jit_block_t jitTranslate (void *block, const u32 *opcode, int count, u32 pc, bool thumb)
+{
+	if (!jitAlloc() || out + JIT_BLOCK_SIZE > jitBuffer + JIT_BUFFER_SIZE)
+		return NULL;
+
+	jit_block_t code = (jit_block_t)out;
+	jit_step_t step = thumb ? jitEnv.thumbStep : jitEnv.armStep;
+	int size = thumb ? 2 : 4;
+
+	emit8(0x53);										// push rbx
+	emit8(0x48); emit8(0xBB); emit64((uintptr_t)jitEnv.reg);	// mov rbx, reg
+
+	jitPrefetchDirty = true;
+	jitPrefetchNormal = false;
+	jitExitCount = 0;
+	jitStubCount = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		u32 address = pc + i * size;
+		int cond;
+
+		if (thumb)
+			cond = (opcode[i] & 0xF000) == 0xD000 ? (opcode[i] >> 8) & 15 : 0x0E;
+		else
+			cond = opcode[i] >> 28;
+
+		// the interpreter runs SWI and the undefined Thumb branches itself
+		if (thumb && cond >= 0x0E && (opcode[i] & 0xF000) == 0xD000)
+			cond = 0x0E;
+
+		jitPreamble(address, thumb);
+
+		u8 *fail = jitCondition(cond);
+		bool native;
+
+		if (fail && cond == 0x0F)
+			native = true;		// never runs
+		else if (thumb)
+			native = (opcode[i] & 0xF000) != 0xD000 && jitThumbInsn(opcode[i], address);
+		else
+			native = jitArmAlu(opcode[i], address);
+
+		if (!native)
+		{
+			emitCall(block, i, step);
+			emitTest(EAX, EAX);
+			jitExits[jitExitCount++] = emitJcc(CC_GE);
+			jitPrefetchDirty = true;
+			jitPrefetchNormal = false;
+		}
+
+		if (fail)
+		{
+			bool normal = jitPrefetchNormal;
+			u8 *join = emitJmp();
+			jitPatch(fail);
+			jitFetchTicks(address, thumb);
+			jitPatch(join);
+			jitPrefetchNormal &= normal;
+		}
+
+#ifdef GBA_JIT_EXACT
+		if ((native || fail) && i + 1 < count)
+		{
+			emitLoad(EAX, offTotalTicks);
+			emitLoad(ECX, offNextEvent);
+			emitAlu(OP_CMP, EAX, ECX);
+			jitStubIndex[jitStubCount] = i + 1;
+			jitStubs[jitStubCount++] = emitJcc(CC_GE);
+		}
+#endif
+	}
+
+	jitExit(opcode, count, pc, thumb);
+	u8 *epilogue = out;
+	emit8(0x5B);										// pop rbx
+	emit8(0xC3);										// ret
+
+	for (int i = 0; i < jitStubCount; i++)
+	{
+		jitPatch(jitStubs[i]);
+		jitExit(opcode, jitStubIndex[i], pc, thumb);
+		s32 rel = epilogue - (out + 5);
+		emit8(0xE9);
+		emit32(rel);
+	}
+
+	u8 *end = out;
+	out = epilogue;
+	for (int i = 0; i < jitExitCount; i++)
+		jitPatch(jitExits[i]);
+	out = end;
+
+	return code;
+}
+
+// Buffer ///////////////////////////////////////////////////////////////////
+
+static bool jitOffset (s32 *offset, const void *p)
+{
+	intptr_t d = (const u8 *)p - (const u8 *)jitEnv.reg;
+	*offset = (s32)d;
+	return d == *offset;
+}
+
+bool jitInit (const jit_env_t *env)
+{
+	jitEnv = *env;
+
+	if (!jitOffset(&offNextPC, env->armNextPC) ||
+		!jitOffset(&offPrefetchCount, env->busPrefetchCount) ||
+		!jitOffset(&offPrefetch, env->busPrefetch) ||
+		!jitOffset(&offN, env->N) || !jitOffset(&offZ, env->Z) ||
+		!jitOffset(&offC, env->C) || !jitOffset(&offV, env->V) ||
+		!jitOffset(&offTotalTicks, env->cpuTotalTicks) ||
+		!jitOffset(&offNextEvent, env->cpuNextEvent) ||
+		!jitOffset(&offCpuPrefetch, env->cpuPrefetch) ||
+		!jitOffset(&offWait, env->memoryWait) ||
+		!jitOffset(&offWaitSeq, env->memoryWaitSeq) ||
+		!jitOffset(&offWait32, env->memoryWait32) ||
+		!jitOffset(&offWaitSeq32, env->memoryWaitSeq32))
+		return false;
+
+	return jitAlloc();
+}
+
+// Drops every translation; the blocks must have dropped their code already
+void jitReset (void)
+{
+	out = jitBuffer;
+}
+
+void jitCleanUp (void)
+{
+	if (jitBuffer)
+		munmap(jitBuffer, JIT_BUFFER_SIZE);
+	jitBuffer = NULL;
+}
+
+#endif // HAVE_GBA_JIT
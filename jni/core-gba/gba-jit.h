@@ -0,0 +1,46 @@
+#ifndef GBA_JIT_H
+#define GBA_JIT_H
+
+#include "types.h"
+
+#if defined(__x86_64__)
+#define HAVE_GBA_JIT
+#endif
+
+// Translated blocks return what armExecuteBlock/thumbExecuteBlock would:
+// the number of instructions run, or 0 when the execute loop has to return
+typedef int (*jit_block_t)(void);
+
+// Runs instruction i of a block through the interpreter. Returns -1 to go
+// on with the next instruction, else the result of the block.
+typedef int (*jit_step_t)(void *block, int i);
+
+// CPU state the translated code works on. Everything is addressed relative
+// to reg, so it all has to lie within 2GB of it.
+typedef struct
+{
+	u32 *reg;
+	u32 *armNextPC;
+	u32 *busPrefetchCount;
+	bool *busPrefetch;
+	bool *N;
+	bool *Z;
+	bool *C;
+	bool *V;
+	int *cpuTotalTicks;
+	int *cpuNextEvent;
+	u32 *cpuPrefetch;
+	const u8 *memoryWait;
+	const u8 *memoryWaitSeq;
+	const u8 *memoryWait32;
+	const u8 *memoryWaitSeq32;
+	jit_step_t armStep;
+	jit_step_t thumbStep;
+} jit_env_t;
+
+extern bool jitInit(const jit_env_t *env);
+extern void jitReset(void);
+extern void jitCleanUp(void);
+extern jit_block_t jitTranslate(void *block, const u32 *opcode, int count, u32 pc, bool thumb);
+
+#endif // GBA_JIT_H
@@ -4,6 +4,20 @@
 #include <math.h>
 #include <stddef.h>
 
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// The line compositor runs 8 pixels at a time where the target has NEON
+// or SSE2. Define GFX_NO_SIMD to force the scalar renderers.
+#if !defined(GFX_NO_SIMD) && defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define GFX_NEON 1
+#elif !defined(GFX_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define GFX_SSE2 1
+#endif
+
 #include "system.h"
 #include "globals.h"
 
@@ -16,6 +30,7 @@
 #include "gba-memory.h"
 #include "sound.h" 
 #include "cheats.h"
+#include "gba-jit.h"
 
 #ifdef ELF
 #include "elf.h"
@@ -235,15 +250,6 @@ static int gbaSaveType = 0; // used to remember the save type on reset
 
 bool cheatsEnabled = false;
 static u32 mastercode = 0;
-static inline void cpuMasterCodeCheck()
-{
-#if 0
-  if((mastercode) && (mastercode == bus.armNextPC))
-  {
-    /*cpuTotalTicks += */cheatsCheckKeys(joy & 0x3FF, joy >> 10);
-  }
-#endif
-}
 
 //static int gfxLastVCOUNT = 0;
 
@@ -654,15 +660,139 @@ unreadable:
 	}
 }
 
+/*============================================================
+	GBA DECODE CACHE
+============================================================ */
+
+// Basic blocks are predecoded from BIOS, EWRAM, IWRAM and ROM. Code in RAM
+// is tracked in 256-byte pages: a write to a page holding decoded code bumps
+// the page generation, which retires every block decoded from it.
+
+#define CODE_PAGE_SHIFT			8
+#define CODE_PAGE_SIZE			(1 << CODE_PAGE_SHIFT)
+#define CODE_PAGES			((0x40000 + 0x8000) >> CODE_PAGE_SHIFT)
+#define CODE_PAGE_NONE			CODE_PAGES
+
+#define CODE_PAGE_EWRAM(address)	(((address) & 0x3FFFF) >> CODE_PAGE_SHIFT)
+#define CODE_PAGE_IWRAM(address)	((0x40000 + ((address) & 0x7FFF)) >> CODE_PAGE_SHIFT)
+
+static uint8_t codePageUsed[CODE_PAGES];
+static uint32_t codePageGen[CODE_PAGES + 1];	// CODE_PAGE_NONE never changes
+static bool codeWritten = false;
+
+#define CODE_PAGE_WRITE(page) \
+  if (codePageUsed[page]) \
+  { \
+    codePageUsed[page] = 0; \
+    codePageGen[page]++; \
+    codeWritten = true; \
+  }
+
+// Used when RAM is modified without going through CPUWrite*
+static void codePageWriteAll (void)
+{
+	for (int i = 0; i < CODE_PAGES; i++)
+		CODE_PAGE_WRITE(i);
+}
+
+#define CPU_BLOCK_INSNS			32
+#define CPU_BLOCK_COUNT			1024
+#define CPU_BLOCK_HOT			8		// runs before a block is translated
+
+#define CPU_IDLE_UNKNOWN		0
+#define CPU_IDLE_NONE			1	// not a polling loop
+
+typedef  void (*insnfunc_t)(u32 opcode);
+
+typedef struct
+{
+	u32 key;				// pc | thumb, ~0 when the slot is empty
+	u32 pc;
+	u32 gen;				// generation of the RAM page when decoded
+	u16 page;				// RAM page, or CODE_PAGE_NONE for BIOS/ROM
+	u8 count;
+	u8 idle;				// CPU_IDLE_*, see cpuIdleCheck
+	u32 opcode[CPU_BLOCK_INSNS + 2];	// followed by the two prefetched opcodes
+	insnfunc_t func[CPU_BLOCK_INSNS];
+#ifdef HAVE_GBA_JIT
+	jit_block_t code;		// translation, made once the block is hot
+	int runs;
+#endif
+} cpu_block_t;
+
+static cpu_block_t cpuBlocks[CPU_BLOCK_COUNT];
+static bool cpuDecodeCache = true;
+static bool cpuIdleSkip = true;
+#ifdef HAVE_GBA_JIT
+static bool cpuRecompiler = false;
+#endif
+
+// Last pass through a polling loop, see cpuIdleCheck
+u32 cpuIdleAddress = 0;		// per-game loop start, trusted without analysis
+
+static struct
+{
+	cpu_block_t *block;
+	u32 reg[16];
+	bool N, Z, C, V;
+	u32 busPrefetchCount;
+	int ticks;
+} cpuIdle;
+
+static cpu_block_t *cpuBlockDecode (cpu_block_t *block, u32 pc, bool thumb);
+static void cpuIdleCheck (cpu_block_t *block, int count);
+#ifdef HAVE_GBA_JIT
+static jit_block_t cpuBlockTranslate (cpu_block_t *block);
+#endif
+
+static INLINE cpu_block_t *cpuBlockGet (u32 pc, bool thumb)
+{
+	cpu_block_t *block = &cpuBlocks[(pc >> (thumb ? 1 : 2)) & (CPU_BLOCK_COUNT - 1)];
+
+	if (block->key == (pc | thumb) && block->gen == codePageGen[block->page])
+		return block;
+
+	return cpuBlockDecode(block, pc, thumb);
+}
+
+static void cpuBlockFlush (void)
+{
+	for (int i = 0; i < CPU_BLOCK_COUNT; i++)
+	{
+		cpuBlocks[i].key = ~0;
+#ifdef HAVE_GBA_JIT
+		cpuBlocks[i].code = NULL;
+#endif
+	}
+
+	memset(codePageUsed, 0, sizeof(codePageUsed));
+#ifdef HAVE_GBA_JIT
+	jitReset();
+#endif
+}
+
+void CPUSetDecodeCache (bool enable)
+{
+	cpuDecodeCache = enable;
+	cpuBlockFlush();
+}
+
+void CPUSetIdleSkip (bool enable)
+{
+	cpuIdleSkip = enable;
+}
+
 static INLINE void CPUWriteMemory(u32 address, u32 value)
 {
 	switch(address >> 24)
 	{
 		case 0x02:
 			WRITE32LE(((u32 *)&workRAM[address & 0x3FFFC]), value);
+			CODE_PAGE_WRITE(CODE_PAGE_EWRAM(address));
 			break;
 		case 0x03:
 			WRITE32LE(((u32 *)&internalRAM[address & 0x7ffC]), value);
+			CODE_PAGE_WRITE(CODE_PAGE_IWRAM(address));
 			break;
 		case 0x04:
 			if(address < 0x4000400)
@@ -708,9 +838,11 @@ static INLINE void CPUWriteHalfWord(u32 address, u16 value)
 	{
 		case 2:
 			WRITE16LE(((u16 *)&workRAM[address & 0x3FFFE]),value);
+			CODE_PAGE_WRITE(CODE_PAGE_EWRAM(address));
 			break;
 		case 3:
 			WRITE16LE(((u16 *)&internalRAM[address & 0x7ffe]), value);
+			CODE_PAGE_WRITE(CODE_PAGE_IWRAM(address));
 			break;
 		case 4:
 			if(address < 0x4000400)
@@ -755,9 +887,11 @@ static INLINE void CPUWriteByte(u32 address, u8 b)
 	{
 		case 2:
 			workRAM[address & 0x3FFFF] = b;
+			CODE_PAGE_WRITE(CODE_PAGE_EWRAM(address));
 			break;
 		case 3:
 			internalRAM[address & 0x7fff] = b;
+			CODE_PAGE_WRITE(CODE_PAGE_IWRAM(address));
 			break;
 		case 4:
 			if(address < 0x4000400)
@@ -867,6 +1001,50 @@ static INLINE void CPUWriteByte(u32 address, u8 b)
 }
 
 
+// Host memory behind a GBA address and the bytes left before its mapping
+// changes; NULL for regions that need the per-access handlers (I/O,
+// mirrored OBJ VRAM, save memory...)
+static uint8_t *cpuHostAddress(u32 address, bool write, u32 &span)
+{
+	u32 offset;
+
+	switch(address >> 24)
+	{
+		case 0x02:
+			offset = address & 0x3FFFF;
+			span = 0x40000 - offset;
+			return &workRAM[offset];
+		case 0x03:
+			offset = address & 0x7FFF;
+			span = 0x8000 - offset;
+			return &internalRAM[offset];
+		case 0x05:
+			offset = address & 0x3FF;
+			span = 0x400 - offset;
+			return &graphics.paletteRAM[offset];
+		case 0x06:
+			offset = address & 0x1FFFF;
+			if(offset >= 0x18000)
+				return NULL;
+			span = 0x18000 - offset;
+			return &vram[offset];
+		case 0x07:
+			offset = address & 0x3FF;
+			span = 0x400 - offset;
+			return &oam[offset];
+		case 0x08:
+		case 0x09:
+		case 0x0A:
+		case 0x0B:
+		case 0x0C:
+			if(write)
+				return NULL;
+			span = 0x1000000 - (address & 0xFFFFFF);
+			return &rom[address & 0x1FFFFFF];
+	}
+	return NULL;
+}
+
 /*============================================================
 	BIOS
 ============================================================ */
@@ -906,6 +1084,117 @@ s16 sineTable[256] = {
   (s16)0xF384, (s16)0xF50F, (s16)0xF69C, (s16)0xF82B, (s16)0xF9BB, (s16)0xFB4B, (s16)0xFCDD, (s16)0xFE6E
 };
 
+// A stretch of linear memory the HLE routines reach through a host
+// pointer; accesses outside of it use the CPURead*/CPUWrite* handlers.
+// Code pages of a written span are invalidated when it is set up.
+typedef struct
+{
+	u32 start;
+	u32 size;
+	uint8_t *host;
+} bios_span_t;
+
+// Source spans run to the end of the region
+static void biosSpanRead(bios_span_t &span, u32 address)
+{
+	span.start = address & ~3;
+	span.host = cpuHostAddress(span.start, false, span.size);
+
+	// the RTC registers sit in the ROM header
+	if(span.host == NULL || ((span.start >> 24) == 0x08 && (span.start & 0xFFFFFF) < 0xCC))
+		span.size = 0;
+}
+
+// Covers the size bytes about to be written at address; bytes marks a
+// span written byte by byte, which only EWRAM and IWRAM store as is
+static void biosSpanWrite(bios_span_t &span, u32 address, u32 size, bool bytes)
+{
+	u32 avail;
+
+	span.start = address & ~3;
+	span.size = 0;
+	span.host = cpuHostAddress(span.start, true, avail);
+
+	if(span.host == NULL)
+		return;
+	if(bytes && (span.start >> 24) != 0x02 && (span.start >> 24) != 0x03)
+		return;
+
+	size = (size + (address & 3) + 3) & ~3;
+	span.size = size < avail ? size : avail;
+
+	if((span.start >> 24) == 0x02)
+	{
+		for(u32 a = span.start & ~(CODE_PAGE_SIZE - 1); a < span.start + span.size; a += CODE_PAGE_SIZE)
+			CODE_PAGE_WRITE(CODE_PAGE_EWRAM(a));
+	}
+	else if((span.start >> 24) == 0x03)
+	{
+		for(u32 a = span.start & ~(CODE_PAGE_SIZE - 1); a < span.start + span.size; a += CODE_PAGE_SIZE)
+			CODE_PAGE_WRITE(CODE_PAGE_IWRAM(a));
+	}
+}
+
+// Host pointer to n bytes at address, NULL unless the span holds them all
+static INLINE uint8_t *biosSpanPointer(const bios_span_t &span, u32 address, u32 n)
+{
+	u32 offset = address - span.start;
+	if(offset < span.size && n <= span.size - offset)
+		return &span.host[offset];
+	return NULL;
+}
+
+static INLINE u8 biosReadByte(const bios_span_t &span, u32 address)
+{
+	u32 offset = address - span.start;
+	if(offset < span.size)
+		return span.host[offset];
+	return CPUReadByte(address);
+}
+
+static INLINE u16 biosReadHalfWord(const bios_span_t &span, u32 address)
+{
+	u32 offset = address - span.start;
+	if(offset < span.size && !(address & 1))
+		return READ16LE(((u16 *)&span.host[offset]));
+	return CPUReadHalfWord(address);
+}
+
+static INLINE u32 biosReadMemory(const bios_span_t &span, u32 address)
+{
+	u32 offset = address - span.start;
+	if(offset < span.size && !(address & 3))
+		return READ32LE(((u32 *)&span.host[offset]));
+	return CPUReadMemory(address);
+}
+
+static INLINE void biosWriteByte(const bios_span_t &span, u32 address, u8 b)
+{
+	u32 offset = address - span.start;
+	if(offset < span.size)
+		span.host[offset] = b;
+	else
+		CPUWriteByte(address, b);
+}
+
+static INLINE void biosWriteHalfWord(const bios_span_t &span, u32 address, u16 value)
+{
+	u32 offset = (address & ~1) - span.start;
+	if(offset < span.size)
+		WRITE16LE(((u16 *)&span.host[offset]), value);
+	else
+		CPUWriteHalfWord(address, value);
+}
+
+static INLINE void biosWriteMemory(const bios_span_t &span, u32 address, u32 value)
+{
+	u32 offset = (address & ~3) - span.start;
+	if(offset < span.size)
+		WRITE32LE(((u32 *)&span.host[offset]), value);
+	else
+		CPUWriteMemory(address, value);
+}
+
 static void BIOS_ArcTan (void)
 {
 	s32 a =  -(((s32)(bus.reg[0].I*bus.reg[0].I)) >> 14);
@@ -1079,6 +1368,11 @@ static void BIOS_CpuSet (void)
 	u32 cnt = bus.reg[2].I;
 
 	int count = cnt & 0x1FFFFF;
+	int size = ((cnt >> 26) & 1) ? 4 : 2;
+
+	bios_span_t src, dst;
+	biosSpanRead(src, source);
+	biosSpanWrite(dst, dest, count * size, false);
 
 	// 32-bit ?
 	if((cnt >> 26) & 1)
@@ -1088,16 +1382,16 @@ static void BIOS_CpuSet (void)
 		dest &= 0xFFFFFFFC;
 		// fill ?
 		if((cnt >> 24) & 1) {
-			u32 value = (source>0x0EFFFFFF ? 0x1CAD1CAD : CPUReadMemory(source));
+			u32 value = (source>0x0EFFFFFF ? 0x1CAD1CAD : biosReadMemory(src, source));
 			while(count) {
-				CPUWriteMemory(dest, value);
+				biosWriteMemory(dst, dest, value);
 				dest += 4;
 				count--;
 			}
 		} else {
 			// copy
 			while(count) {
-				CPUWriteMemory(dest, (source>0x0EFFFFFF ? 0x1CAD1CAD : CPUReadMemory(source)));
+				biosWriteMemory(dst, dest, (source>0x0EFFFFFF ? 0x1CAD1CAD : biosReadMemory(src, source)));
 				source += 4;
 				dest += 4;
 				count--;
@@ -1108,16 +1402,16 @@ static void BIOS_CpuSet (void)
 	{
 		// 16-bit fill?
 		if((cnt >> 24) & 1) {
-			u16 value = (source>0x0EFFFFFF ? 0x1CAD : CPUReadHalfWord(source));
+			u16 value = (source>0x0EFFFFFF ? 0x1CAD : biosReadHalfWord(src, source));
 			while(count) {
-				CPUWriteHalfWord(dest, value);
+				biosWriteHalfWord(dst, dest, value);
 				dest += 2;
 				count--;
 			}
 		} else {
 			// copy
 			while(count) {
-				CPUWriteHalfWord(dest, (source>0x0EFFFFFF ? 0x1CAD : CPUReadHalfWord(source)));
+				biosWriteHalfWord(dst, dest, (source>0x0EFFFFFF ? 0x1CAD : biosReadHalfWord(src, source)));
 				source += 2;
 				dest += 2;
 				count--;
@@ -1138,13 +1432,18 @@ static void BIOS_CpuFastSet (void)
 
 	int count = cnt & 0x1FFFFF;
 
+	// whole blocks of 8 words are written
+	bios_span_t src, dst;
+	biosSpanRead(src, source);
+	biosSpanWrite(dst, dest, ((count + 7) & ~7) * 4, false);
+
 	// fill?
 	if((cnt >> 24) & 1) {
 		while(count > 0) {
 			// BIOS always transfers 32 bytes at a time
-			u32 value = (source>0x0EFFFFFF ? 0xBAFFFFFB : CPUReadMemory(source));
+			u32 value = (source>0x0EFFFFFF ? 0xBAFFFFFB : biosReadMemory(src, source));
 			for(int i = 0; i < 8; i++) {
-				CPUWriteMemory(dest, value);
+				biosWriteMemory(dst, dest, value);
 				dest += 4;
 			}
 			count -= 8;
@@ -1154,7 +1453,7 @@ static void BIOS_CpuFastSet (void)
 		while(count > 0) {
 			// BIOS always transfers 32 bytes at a time
 			for(int i = 0; i < 8; i++) {
-				CPUWriteMemory(dest, (source>0x0EFFFFFF ? 0xBAFFFFFB :CPUReadMemory(source)));
+				biosWriteMemory(dst, dest, (source>0x0EFFFFFF ? 0xBAFFFFFB :biosReadMemory(src, source)));
 				source += 4;
 				dest += 4;
 			}
@@ -1177,14 +1476,18 @@ static void BIOS_Diff8bitUnFilterWram (void)
 
 	int len = header >> 8;
 
-	u8 data = CPUReadByte(source++);
-	CPUWriteByte(dest++, data);
+	bios_span_t src, dst;
+	biosSpanRead(src, source);
+	biosSpanWrite(dst, dest, len, true);
+
+	u8 data = biosReadByte(src, source++);
+	biosWriteByte(dst, dest++, data);
 	len--;
 
 	while(len > 0) {
-		u8 diff = CPUReadByte(source++);
+		u8 diff = biosReadByte(src, source++);
 		data += diff;
-		CPUWriteByte(dest++, data);
+		biosWriteByte(dst, dest++, data);
 		len--;
 	}
 }
@@ -1203,19 +1506,23 @@ static void BIOS_Diff8bitUnFilterVram (void)
 
 	int len = header >> 8;
 
-	u8 data = CPUReadByte(source++);
+	bios_span_t src, dst;
+	biosSpanRead(src, source);
+	biosSpanWrite(dst, dest, len, false);
+
+	u8 data = biosReadByte(src, source++);
 	u16 writeData = data;
 	int shift = 8;
 	int bytes = 1;
 
 	while(len >= 2) {
-		u8 diff = CPUReadByte(source++);
+		u8 diff = biosReadByte(src, source++);
 		data += diff;
 		writeData |= (data << shift);
 		bytes++;
 		shift += 8;
 		if(bytes == 2) {
-			CPUWriteHalfWord(dest, writeData);
+			biosWriteHalfWord(dst, dest, writeData);
 			dest += 2;
 			len -= 2;
 			bytes = 0;
@@ -1239,17 +1546,21 @@ static void BIOS_Diff16bitUnFilter (void)
 
 	int len = header >> 8;
 
-	u16 data = CPUReadHalfWord(source);
+	bios_span_t src, dst;
+	biosSpanRead(src, source);
+	biosSpanWrite(dst, dest, len, false);
+
+	u16 data = biosReadHalfWord(src, source);
 	source += 2;
-	CPUWriteHalfWord(dest, data);
+	biosWriteHalfWord(dst, dest, data);
 	dest += 2;
 	len -= 2;
 
 	while(len >= 2) {
-		u16 diff = CPUReadHalfWord(source);
+		u16 diff = biosReadHalfWord(src, source);
 		source += 2;
 		data += diff;
-		CPUWriteHalfWord(dest, data);
+		biosWriteHalfWord(dst, dest, data);
 		dest += 2;
 		len -= 2;
 	}
@@ -1275,12 +1586,16 @@ static void BIOS_HuffUnComp (void)
 
 	int len = header >> 8;
 
+	bios_span_t src, dst;
+	biosSpanRead(src, treeStart);
+	biosSpanWrite(dst, dest, len, false);
+
 	u32 mask = 0x80000000;
-	u32 data = CPUReadMemory(source);
+	u32 data = biosReadMemory(src, source);
 	source += 4;
 
 	int pos = 0;
-	u8 rootNode = CPUReadByte(treeStart);
+	u8 rootNode = biosReadByte(src, treeStart);
 	u8 currentNode = rootNode;
 	bool writeData = false;
 	int byteShift = 0;
@@ -1299,12 +1614,12 @@ static void BIOS_HuffUnComp (void)
 				// right
 				if(currentNode & 0x40)
 					writeData = true;
-				currentNode = CPUReadByte(treeStart+pos+1);
+				currentNode = biosReadByte(src, treeStart+pos+1);
 			} else {
 				// left
 				if(currentNode & 0x80)
 					writeData = true;
-				currentNode = CPUReadByte(treeStart+pos);
+				currentNode = biosReadByte(src, treeStart+pos);
 			}
 
 			if(writeData) {
@@ -1319,7 +1634,7 @@ static void BIOS_HuffUnComp (void)
 				if(byteCount == 4) {
 					byteCount = 0;
 					byteShift = 0;
-					CPUWriteMemory(dest, writeValue);
+					biosWriteMemory(dst, dest, writeValue);
 					writeValue = 0;
 					dest += 4;
 					len -= 4;
@@ -1328,7 +1643,7 @@ static void BIOS_HuffUnComp (void)
 			mask >>= 1;
 			if(mask == 0) {
 				mask = 0x80000000;
-				data = CPUReadMemory(source);
+				data = biosReadMemory(src, source);
 				source += 4;
 			}
 		}
@@ -1346,12 +1661,12 @@ static void BIOS_HuffUnComp (void)
 				// right
 				if(currentNode & 0x40)
 					writeData = true;
-				currentNode = CPUReadByte(treeStart+pos+1);
+				currentNode = biosReadByte(src, treeStart+pos+1);
 			} else {
 				// left
 				if(currentNode & 0x80)
 					writeData = true;
-				currentNode = CPUReadByte(treeStart+pos);
+				currentNode = biosReadByte(src, treeStart+pos);
 			}
 
 			if(writeData) {
@@ -1372,7 +1687,7 @@ static void BIOS_HuffUnComp (void)
 					if(byteCount == 4) {
 						byteCount = 0;
 						byteShift = 0;
-						CPUWriteMemory(dest, writeValue);
+						biosWriteMemory(dst, dest, writeValue);
 						dest += 4;
 						writeValue = 0;
 						len -= 4;
@@ -1385,7 +1700,7 @@ static void BIOS_HuffUnComp (void)
 			mask >>= 1;
 			if(mask == 0) {
 				mask = 0x80000000;
-				data = CPUReadMemory(source);
+				data = biosReadMemory(src, source);
 				source += 4;
 			}
 		}
@@ -1411,24 +1726,28 @@ static void BIOS_LZ77UnCompVram (void)
 
 	int len = header >> 8;
 
+	bios_span_t src, dst;
+	biosSpanRead(src, source);
+	biosSpanWrite(dst, dest, len, false);
+
 	while(len > 0) {
-		u8 d = CPUReadByte(source++);
+		u8 d = biosReadByte(src, source++);
 
 		if(d) {
 			for(int i = 0; i < 8; i++) {
 				if(d & 0x80) {
-					u16 data = CPUReadByte(source++) << 8;
-					data |= CPUReadByte(source++);
+					u16 data = biosReadByte(src, source++) << 8;
+					data |= biosReadByte(src, source++);
 					int length = (data >> 12) + 3;
 					int offset = (data & 0x0FFF);
 					u32 windowOffset = dest + byteCount - offset - 1;
 					for(int i2 = 0; i2 < length; i2++) {
-						writeValue |= (CPUReadByte(windowOffset++) << byteShift);
+						writeValue |= (biosReadByte(dst, windowOffset++) << byteShift);
 						byteShift += 8;
 						byteCount++;
 
 						if(byteCount == 2) {
-							CPUWriteHalfWord(dest, writeValue);
+							biosWriteHalfWord(dst, dest, writeValue);
 							dest += 2;
 							byteCount = 0;
 							byteShift = 0;
@@ -1439,11 +1758,11 @@ static void BIOS_LZ77UnCompVram (void)
 							return;
 					}
 				} else {
-					writeValue |= (CPUReadByte(source++) << byteShift);
+					writeValue |= (biosReadByte(src, source++) << byteShift);
 					byteShift += 8;
 					byteCount++;
 					if(byteCount == 2) {
-						CPUWriteHalfWord(dest, writeValue);
+						biosWriteHalfWord(dst, dest, writeValue);
 						dest += 2;
 						byteCount = 0;
 						byteShift = 0;
@@ -1457,11 +1776,11 @@ static void BIOS_LZ77UnCompVram (void)
 			}
 		} else {
 			for(int i = 0; i < 8; i++) {
-				writeValue |= (CPUReadByte(source++) << byteShift);
+				writeValue |= (biosReadByte(src, source++) << byteShift);
 				byteShift += 8;
 				byteCount++;
 				if(byteCount == 2) {
-					CPUWriteHalfWord(dest, writeValue);
+					biosWriteHalfWord(dst, dest, writeValue);
 					dest += 2;
 					byteShift = 0;
 					byteCount = 0;
@@ -1489,25 +1808,42 @@ static void BIOS_LZ77UnCompWram (void)
 
 	int len = header >> 8;
 
+	bios_span_t src, dst;
+	biosSpanRead(src, source);
+	biosSpanWrite(dst, dest, len, true);
+
 	while(len > 0) {
-		u8 d = CPUReadByte(source++);
+		u8 d = biosReadByte(src, source++);
 
 		if(d) {
 			for(int i = 0; i < 8; i++) {
 				if(d & 0x80) {
-					u16 data = CPUReadByte(source++) << 8;
-					data |= CPUReadByte(source++);
+					u16 data = biosReadByte(src, source++) << 8;
+					data |= biosReadByte(src, source++);
 					int length = (data >> 12) + 3;
 					int offset = (data & 0x0FFF);
 					u32 windowOffset = dest - offset - 1;
+					int n = length < len ? length : len;
+					uint8_t *to = biosSpanPointer(dst, dest, n);
+					uint8_t *from = biosSpanPointer(dst, windowOffset, n);
+					if(to && from) {
+						// byte by byte: the window may overlap the output
+						for(int i2 = 0; i2 < n; i2++)
+							to[i2] = from[i2];
+						dest += n;
+						len -= n;
+						if(len == 0)
+							return;
+						length = 0;
+					}
 					for(int i2 = 0; i2 < length; i2++) {
-						CPUWriteByte(dest++, CPUReadByte(windowOffset++));
+						biosWriteByte(dst, dest++, biosReadByte(dst, windowOffset++));
 						len--;
 						if(len == 0)
 							return;
 					}
 				} else {
-					CPUWriteByte(dest++, CPUReadByte(source++));
+					biosWriteByte(dst, dest++, biosReadByte(src, source++));
 					len--;
 					if(len == 0)
 						return;
@@ -1516,7 +1852,7 @@ static void BIOS_LZ77UnCompWram (void)
 			}
 		} else {
 			for(int i = 0; i < 8; i++) {
-				CPUWriteByte(dest++, CPUReadByte(source++));
+				biosWriteByte(dst, dest++, biosReadByte(src, source++));
 				len--;
 				if(len == 0)
 					return;
@@ -1574,6 +1910,9 @@ static void BIOS_RegisterRamReset(u32 flags)
 		if(flags & 0x02)
 			memset(internalRAM, 0, 0x7e00);		// don't clear 0x7e00-0x7fff, clear internal RAM
 
+		if(flags & 0x03)
+			codePageWriteAll();
+
 		if(flags & 0x04)
 			memset(graphics.paletteRAM, 0, 0x400);	// clear palette RAM
 
@@ -1643,16 +1982,20 @@ static void BIOS_RLUnCompVram (void)
 		return;
 
 	int len = header >> 8;
+
+	bios_span_t src, dst;
+	biosSpanRead(src, source);
+	biosSpanWrite(dst, dest, len, false);
 	int byteCount = 0;
 	int byteShift = 0;
 	u32 writeValue = 0;
 
 	while(len > 0)
 	{
-		u8 d = CPUReadByte(source++);
+		u8 d = biosReadByte(src, source++);
 		int l = d & 0x7F;
 		if(d & 0x80) {
-			u8 data = CPUReadByte(source++);
+			u8 data = biosReadByte(src, source++);
 			l += 3;
 			for(int i = 0;i < l; i++) {
 				writeValue |= (data << byteShift);
@@ -1660,7 +2003,7 @@ static void BIOS_RLUnCompVram (void)
 				byteCount++;
 
 				if(byteCount == 2) {
-					CPUWriteHalfWord(dest, writeValue);
+					biosWriteHalfWord(dst, dest, writeValue);
 					dest += 2;
 					byteCount = 0;
 					byteShift = 0;
@@ -1673,11 +2016,11 @@ static void BIOS_RLUnCompVram (void)
 		} else {
 			l++;
 			for(int i = 0; i < l; i++) {
-				writeValue |= (CPUReadByte(source++) << byteShift);
+				writeValue |= (biosReadByte(src, source++) << byteShift);
 				byteShift += 8;
 				byteCount++;
 				if(byteCount == 2) {
-					CPUWriteHalfWord(dest, writeValue);
+					biosWriteHalfWord(dst, dest, writeValue);
 					dest += 2;
 					byteCount = 0;
 					byteShift = 0;
@@ -1705,22 +2048,45 @@ static void BIOS_RLUnCompWram (void)
 
 	int len = header >> 8;
 
+	bios_span_t src, dst;
+	biosSpanRead(src, source);
+	biosSpanWrite(dst, dest, len, true);
+
 	while(len > 0) {
-		u8 d = CPUReadByte(source++);
+		u8 d = biosReadByte(src, source++);
 		int l = d & 0x7F;
+		int n = l + ((d & 0x80) ? 3 : 1);
+		if(n > len)
+			n = len;
+		uint8_t *to = biosSpanPointer(dst, dest, n);
 		if(d & 0x80) {
-			u8 data = CPUReadByte(source++);
+			u8 data = biosReadByte(src, source++);
 			l += 3;
+			if(to) {
+				memset(to, data, n);
+				dest += n;
+				len -= n;
+				continue;
+			}
 			for(int i = 0;i < l; i++) {
-				CPUWriteByte(dest++, data);
+				biosWriteByte(dst, dest++, data);
 				len--;
 				if(len == 0)
 					return;
 			}
 		} else {
 			l++;
+			uint8_t *from = biosSpanPointer(src, source, n);
+			if(to && from) {
+				for(int i = 0; i < n; i++)
+					to[i] = from[i];
+				source += n;
+				dest += n;
+				len -= n;
+				continue;
+			}
 			for(int i = 0; i < l; i++) {
-				CPUWriteByte(dest++,  CPUReadByte(source++));
+				biosWriteByte(dst, dest++,  biosReadByte(src, source++));
 				len--;
 				if(len == 0)
 					return;
@@ -1747,6 +2113,7 @@ static void BIOS_SoftReset (void)
 	u8 b = internalRAM[0x7ffa];
 
 	memset(&internalRAM[0x7e00], 0, 0x200);
+	codePageWriteAll();
 
 	if(b) {
 		bus.armNextPC = 0x02000000;
@@ -4230,11 +4597,152 @@ static insnfunc_t armInsnTable[4096] = {
     REP256(armF00),                                           // F00
 };
 
+static INLINE bool armCondition (u32 cond)
+{
+	bool cond_res = true;
+	if (cond != 0x0E) {  // most opcodes are AL (always)
+		switch(cond) {
+			case 0x00: // EQ
+				cond_res = Z_FLAG;
+				break;
+			case 0x01: // NE
+				cond_res = !Z_FLAG;
+				break;
+			case 0x02: // CS
+				cond_res = C_FLAG;
+				break;
+			case 0x03: // CC
+				cond_res = !C_FLAG;
+				break;
+			case 0x04: // MI
+				cond_res = N_FLAG;
+				break;
+			case 0x05: // PL
+				cond_res = !N_FLAG;
+				break;
+			case 0x06: // VS
+				cond_res = V_FLAG;
+				break;
+			case 0x07: // VC
+				cond_res = !V_FLAG;
+				break;
+			case 0x08: // HI
+				cond_res = C_FLAG && !Z_FLAG;
+				break;
+			case 0x09: // LS
+				cond_res = !C_FLAG || Z_FLAG;
+				break;
+			case 0x0A: // GE
+				cond_res = N_FLAG == V_FLAG;
+				break;
+			case 0x0B: // LT
+				cond_res = N_FLAG != V_FLAG;
+				break;
+			case 0x0C: // GT
+				cond_res = !Z_FLAG &&(N_FLAG == V_FLAG);
+				break;
+			case 0x0D: // LE
+				cond_res = Z_FLAG || (N_FLAG != V_FLAG);
+				break;
+			case 0x0E: // AL (impossible, checked above)
+				cond_res = true;
+				break;
+			case 0x0F:
+			default:
+				// ???
+				cond_res = false;
+				break;
+		}
+	}
+
+	return cond_res;
+}
+
+// Runs instruction i of a predecoded block. The prefetch queue is refilled
+// from the block, holding what armExecute would have fetched. Returns -1 when
+// the next instruction of the block follows, else the result of
+// armExecuteBlock.
+static INLINE int armBlockStep (cpu_block_t *block, int i)
+{
+	clockTicks = 0;
+
+	if ((bus.armNextPC & 0x0803FFFF) == 0x08020000)
+		bus.busPrefetchCount = 0x100;
+
+	u32 opcode = block->opcode[i];
+	cpuPrefetch[0] = block->opcode[i + 1];
+	cpuPrefetch[1] = block->opcode[i + 2];
+
+	bus.busPrefetch = false;
+	int32_t busprefetch_mask = ((bus.busPrefetchCount & 0xFFFFFE00) | -(bus.busPrefetchCount & 0xFFFFFE00)) >> 31;
+	bus.busPrefetchCount = (0x100 | (bus.busPrefetchCount & 0xFF) & busprefetch_mask) | (bus.busPrefetchCount & ~busprefetch_mask);
+
+	int oldArmNextPC = bus.armNextPC;
+
+	bus.armNextPC = bus.reg[15].I;
+	bus.reg[15].I += 4;
+
+	if (armCondition(opcode >> 28))
+		(*block->func[i])(opcode);
+
+	int ct = clockTicks;
+
+	if (ct < 0)
+		return 0;
+
+	if (ct == 0)
+		clockTicks = 1 + codeTicksAccessSeq32(oldArmNextPC);
+
+	cpuTotalTicks += clockTicks;
+
+	// the pipeline was refilled by a taken branch
+	u32 nextPC = block->pc + ((i + 1) << 2);
+	if ((bus.armNextPC != nextPC) | (bus.reg[15].I != nextPC + 4))
+		return i + 1;
+
+	if (codeWritten)
+	{
+		codeWritten = false;
+		if (block->gen != codePageGen[block->page])
+			return i + 1;
+	}
+
+	return -1;
+}
+
+// Whether a block goes on with instruction i
+static INLINE bool armBlockContinues (cpu_block_t *block, int i)
+{
+#ifdef USE_SWITICKS
+	return i < block->count && cpuTotalTicks < cpuNextEvent && armState && !holdState && !SWITicks;
+#else
+	return (i < block->count) & (cpuTotalTicks < cpuNextEvent) & armState & ~holdState;
+#endif
+}
+
+// Runs a predecoded block. Returns the number of instructions run, or 0
+// when armExecute has to return.
+static INLINE int armExecuteBlock (cpu_block_t *block)
+{
+	int i = 0;
+
+	do
+	{
+		int ret = armBlockStep(block, i);
+		if (ret >= 0)
+			return ret;
+	} while (armBlockContinues(block, ++i));
+
+	return i;
+}
+
 // Wrapper routine (execution loop) ///////////////////////////////////////
 static int armExecute (void)
 {
 	CACHE_PREFETCH(clockTicks);
 
+	cpuIdle.block = NULL;
+
 	u32 cond1;
 	u32 cond2;
 
@@ -4242,10 +4750,35 @@ static int armExecute (void)
 
 	do
 	{
-		if( cheatsEnabled ) {
-			cpuMasterCodeCheck();
+		if (cpuDecodeCache)
+		{
+			cpu_block_t *block = cpuBlockGet(bus.armNextPC, false);
+
+			// a block is only entered when it agrees with the prefetch queue
+			if (block && block->opcode[0] == cpuPrefetch[0] && block->opcode[1] == cpuPrefetch[1])
+			{
+				int count;
+#ifdef HAVE_GBA_JIT
+				// code that keeps being rewritten is not worth translating
+				if (cpuRecompiler && (block->code || (++block->runs >= CPU_BLOCK_HOT && cpuBlockTranslate(block))))
+					count = block->code();
+				else
+#endif
+				count = armExecuteBlock(block);
+
+				if (!count)
+					return 0;
+
+				if (cpuIdleSkip && bus.armNextPC == block->pc)
+					cpuIdleCheck(block, count);
+				else
+					cpuIdle.block = NULL;
+				continue;
+			}
 		}
 
+		cpuIdle.block = NULL;
+
 		clockTicks = 0;
 
 		if ((bus.armNextPC & 0x0803FFFF) == 0x08020000)
@@ -4269,64 +4802,7 @@ static int armExecute (void)
 		bus.reg[15].I += 4;
 		ARM_PREFETCH_NEXT;
 
-		int cond = opcode >> 28;
-		bool cond_res = true;
-		if (cond != 0x0E) {  // most opcodes are AL (always)
-			switch(cond) {
-				case 0x00: // EQ
-					cond_res = Z_FLAG;
-					break;
-				case 0x01: // NE
-					cond_res = !Z_FLAG;
-					break;
-				case 0x02: // CS
-					cond_res = C_FLAG;
-					break;
-				case 0x03: // CC
-					cond_res = !C_FLAG;
-					break;
-				case 0x04: // MI
-					cond_res = N_FLAG;
-					break;
-				case 0x05: // PL
-					cond_res = !N_FLAG;
-					break;
-				case 0x06: // VS
-					cond_res = V_FLAG;
-					break;
-				case 0x07: // VC
-					cond_res = !V_FLAG;
-					break;
-				case 0x08: // HI
-					cond_res = C_FLAG && !Z_FLAG;
-					break;
-				case 0x09: // LS
-					cond_res = !C_FLAG || Z_FLAG;
-					break;
-				case 0x0A: // GE
-					cond_res = N_FLAG == V_FLAG;
-					break;
-				case 0x0B: // LT
-					cond_res = N_FLAG != V_FLAG;
-					break;
-				case 0x0C: // GT
-					cond_res = !Z_FLAG &&(N_FLAG == V_FLAG);
-					break;
-				case 0x0D: // LE
-					cond_res = Z_FLAG || (N_FLAG != V_FLAG);
-					break;
-				case 0x0E: // AL (impossible, checked above)
-					cond_res = true;
-					break;
-				case 0x0F:
-				default:
-					// ???
-					cond_res = false;
-					break;
-			}
-		}
-
-		if (cond_res)
+		if (armCondition(opcode >> 28))
 		{
 			cond1 = (opcode>>16)&0xFF0;
 			cond2 = (opcode>>4)&0x0F;
@@ -5965,32 +6441,574 @@ static insnfunc_t thumbInsnTable[1024] = {
   thumbF8,thumbF8,thumbF8,thumbF8,thumbF8,thumbF8,thumbF8,thumbF8,
 };
 
-// Wrapper routine (execution loop) ///////////////////////////////////////
-
+// Decode cache ///////////////////////////////////////////////////////////
 
-static int thumbExecute (void)
+static INLINE bool armEndsBlock (u32 opcode)
 {
-	CACHE_PREFETCH(clockTicks);
+	// unconditional B, BL, SWI and BX
+	return (opcode >> 28) == 0x0E &&
+		(((opcode & 0x0E000000) == 0x0A000000) ||
+		 ((opcode & 0x0F000000) == 0x0F000000) ||
+		 ((opcode & 0x0FFFFFF0) == 0x012FFF10));
+}
 
-	int ct = 0;
+static INLINE bool thumbEndsBlock (u32 opcode)
+{
+	// B, BL, BX, POP {pc} and SWI
+	return ((opcode & 0xF800) == 0xE000) || ((opcode & 0xF800) == 0xF800) ||
+		((opcode & 0xFF00) == 0x4700) || ((opcode & 0xFF00) == 0xBD00) ||
+		((opcode & 0xFF00) == 0xDF00);
+}
 
-	do {
+static cpu_block_t *cpuBlockDecode (cpu_block_t *block, u32 pc, bool thumb)
+{
+	int page;
+	switch (pc >> 24)
+	{
+		case 0x00:
+			if (pc >= 0x4000)
+				return NULL;
+			page = CODE_PAGE_NONE;
+			break;
+		case 0x02:
+			page = CODE_PAGE_EWRAM(pc);
+			break;
+		case 0x03:
+			page = CODE_PAGE_IWRAM(pc);
+			break;
+		case 0x08:
+		case 0x09:
+		case 0x0A:
+		case 0x0B:
+		case 0x0C:
+		case 0x0D:
+			page = CODE_PAGE_NONE;
+			break;
+		default:
+			return NULL;
+	}
 
-		if( cheatsEnabled ) {
-			cpuMasterCodeCheck();
-		}
+	int step = thumb ? 2 : 4;
+	int count = CPU_BLOCK_INSNS;
 
-		clockTicks = 0;
+	// RAM blocks and their two prefetched opcodes stay within one page
+	if (page != CODE_PAGE_NONE)
+	{
+		count = (CODE_PAGE_SIZE - (pc & (CODE_PAGE_SIZE - 1))) / step - 2;
+		if (count <= 0)
+			return NULL;
+		if (count > CPU_BLOCK_INSNS)
+			count = CPU_BLOCK_INSNS;
+		codePageUsed[page] = 1;
+	}
 
-#if 0
-		if ((bus.armNextPC & 0x0803FFFF) == 0x08020000)
-		   bus.busPrefetchCount=0x100;
+	block->key = pc | thumb;
+	block->idle = CPU_IDLE_UNKNOWN;
+#ifdef HAVE_GBA_JIT
+	block->code = NULL;
+	block->runs = 0;
 #endif
+	block->pc = pc;
+	block->page = page;
+	block->gen = codePageGen[page];
 
-		u32 opcode = cpuPrefetch[0];
-		cpuPrefetch[0] = cpuPrefetch[1];
+	u32 address = pc;
+	int i = 0;
+	while (i < count)
+	{
+		u32 opcode;
 
-		bus.busPrefetch = false;
+		if (thumb)
+		{
+			opcode = CPUReadHalfWordQuick(address);
+			block->func[i] = thumbInsnTable[opcode>>6];
+		}
+		else
+		{
+			opcode = CPUReadMemoryQuick(address);
+			block->func[i] = armInsnTable[((opcode>>16)&0xFF0) | ((opcode>>4)&0x0F)];
+		}
+
+		block->opcode[i++] = opcode;
+		address += step;
+
+		if (thumb ? thumbEndsBlock(opcode) : armEndsBlock(opcode))
+			break;
+	}
+	block->count = i;
+
+	if (thumb)
+	{
+		block->opcode[i] = CPUReadHalfWordQuick(address);
+		block->opcode[i + 1] = CPUReadHalfWordQuick(address + 2);
+	}
+	else
+	{
+		block->opcode[i] = CPUReadMemoryQuick(address);
+		block->opcode[i + 1] = CPUReadMemoryQuick(address + 4);
+	}
+
+	return block;
+}
+
+// Idle loops /////////////////////////////////////////////////////////////
+
+// Games often wait by polling VCOUNT, DISPSTAT, IF or a RAM flag set by an
+// interrupt handler. Once a pass through such a loop leaves the CPU state
+// unchanged and only read memory that cannot change before the next event,
+// every pass until then is identical, so the whole passes are skipped the
+// way holdState skips a halt.
+
+// Memory that only changes at events: by DMA, the LCD or interrupt handlers
+static bool cpuIdleStable (u32 address)
+{
+	switch (address >> 24)
+	{
+		case 0x02:
+		case 0x03:
+		case 0x05:
+		case 0x06:
+		case 0x07:
+			return true;
+		case 0x04:
+			// DISPCNT to VCOUNT, KEYINPUT, KEYCNT, IE, IF, WAITCNT and IME
+			address &= 0xFFFFFF;
+			return address < 0x08 || (address >= 0x130 && address < 0x134) ||
+				(address >= 0x200 && address < 0x20C);
+		case 0x08:
+		case 0x09:
+		case 0x0A:
+		case 0x0B:
+		case 0x0C:
+			// but not the RTC
+			return address < 0x080000C4 || address > 0x080000C9;
+	}
+	return false;
+}
+
+static INLINE bool cpuIdleLoad (u32 written, int base, u32 address)
+{
+	return !((written >> base) & 1) && cpuIdleStable(address);
+}
+
+// The count instructions the pass ran must end with the branch back to the
+// block start and otherwise be register operations, branches that were not
+// taken and loads from stable memory. Load addresses are taken from the
+// registers, which hold their values at the pass start.
+static bool armIdleLoopSafe (cpu_block_t *block, int count)
+{
+	u32 written = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		u32 opcode = block->opcode[i];
+		u32 pc = block->pc + (i << 2);
+
+		if ((opcode & 0x0E000000) == 0x0A000000)
+		{
+			if (i < count - 1)
+				continue;
+			return !(opcode & 0x01000000) && pc + 8 + ((s32)(opcode << 8) >> 6) == block->pc;
+		}
+
+		if (i == count - 1)
+			return false;
+
+		if ((opcode & 0x0C000000) == 0x04000000)
+		{
+			// LDR/LDRB, immediate offset without writeback
+			if ((opcode & 0x03300000) != 0x01100000)
+				return false;
+
+			int base = (opcode >> 16) & 15;
+			int dest = (opcode >> 12) & 15;
+			u32 offset = opcode & 0xFFF;
+			u32 address = (base == 15) ? pc + 8 : bus.reg[base].I;
+			address = (opcode & 0x00800000) ? address + offset : address - offset;
+
+			if (dest == 15 || !cpuIdleLoad(written, base, address))
+				return false;
+			written |= 1 << dest;
+			continue;
+		}
+
+		if ((opcode & 0x0FC000F0) == 0x00000090)
+		{
+			// MUL/MLA
+			int dest = (opcode >> 16) & 15;
+			if (dest == 15)
+				return false;
+			written |= 1 << dest;
+			continue;
+		}
+
+		if ((opcode & 0x0E000090) == 0x00000090)
+		{
+			// LDRH/LDRSB/LDRSH, immediate offset without writeback
+			if (!(opcode & 0x60) || (opcode & 0x01700000) != 0x01500000)
+				return false;
+
+			int base = (opcode >> 16) & 15;
+			int dest = (opcode >> 12) & 15;
+			u32 offset = ((opcode >> 4) & 0xF0) | (opcode & 0x0F);
+			u32 address = (base == 15) ? pc + 8 : bus.reg[base].I;
+			address = (opcode & 0x00800000) ? address + offset : address - offset;
+
+			if (dest == 15 || !cpuIdleLoad(written, base, address))
+				return false;
+			written |= 1 << dest;
+			continue;
+		}
+
+		if ((opcode & 0x0C000000) == 0x00000000)
+		{
+			// data processing, but not MRS, MSR or BX
+			int op = (opcode >> 21) & 15;
+			if ((op & 0x0C) == 0x08)
+			{
+				if (!(opcode & 0x00100000))
+					return false;
+				continue;
+			}
+
+			int dest = (opcode >> 12) & 15;
+			if (dest == 15)
+				return false;
+			written |= 1 << dest;
+			continue;
+		}
+
+		return false;
+	}
+
+	return false;
+}
+
+static bool thumbIdleLoopSafe (cpu_block_t *block, int count)
+{
+	u32 written = 0;
+
+	for (int i = 0; i < count - 1; i++)
+	{
+		u32 opcode = block->opcode[i];
+		u32 pc = block->pc + (i << 1);
+		u32 address;
+		int base;
+		int dest;
+
+		switch (opcode >> 11)
+		{
+			case 0x00:			// LSL, LSR, ASR
+			case 0x01:
+			case 0x02:
+			case 0x03:			// ADD/SUB
+				written |= 1 << (opcode & 7);
+				continue;
+			case 0x04:			// MOV immediate
+			case 0x06:			// ADD immediate
+			case 0x07:			// SUB immediate
+				written |= 1 << ((opcode >> 8) & 7);
+				continue;
+			case 0x05:			// CMP immediate
+				continue;
+			case 0x08:			// ALU operations, but not the high registers
+				if (opcode >= 0x4400)
+					return false;
+				written |= 1 << (opcode & 7);
+				continue;
+			case 0x09:			// LDR PC relative
+				base = 15;
+				address = ((pc + 4) & ~2) + ((opcode & 0xFF) << 2);
+				dest = (opcode >> 8) & 7;
+				break;
+			case 0x0D:			// LDR immediate
+				base = (opcode >> 3) & 7;
+				address = bus.reg[base].I + (((opcode >> 6) & 31) << 2);
+				dest = opcode & 7;
+				break;
+			case 0x0F:			// LDRB immediate
+				base = (opcode >> 3) & 7;
+				address = bus.reg[base].I + ((opcode >> 6) & 31);
+				dest = opcode & 7;
+				break;
+			case 0x11:			// LDRH immediate
+				base = (opcode >> 3) & 7;
+				address = bus.reg[base].I + (((opcode >> 6) & 31) << 1);
+				dest = opcode & 7;
+				break;
+			case 0x13:			// LDR SP relative
+				base = 13;
+				address = bus.reg[13].I + ((opcode & 0xFF) << 2);
+				dest = (opcode >> 8) & 7;
+				break;
+			case 0x14:			// ADD Rd, PC/SP
+			case 0x15:
+				written |= 1 << ((opcode >> 8) & 7);
+				continue;
+			case 0x1A:			// conditional branch, but not SWI
+			case 0x1B:
+				if ((opcode & 0xFF00) >= 0xDE00)
+					return false;
+				continue;
+			default:
+				return false;
+		}
+
+		if (!cpuIdleLoad(written, base, address))
+			return false;
+		written |= 1 << dest;
+	}
+
+	u32 opcode = block->opcode[count - 1];
+	u32 pc = block->pc + ((count - 1) << 1);
+
+	// the branch back: B or a conditional branch, but not SWI
+	if ((opcode & 0xF800) == 0xE000)
+		return pc + 4 + ((s32)(opcode << 21) >> 20) == block->pc;
+	if ((opcode & 0xF000) == 0xD000 && (opcode & 0xFF00) < 0xDE00)
+		return pc + 4 + ((s32)(s8)(opcode & 0xFF) << 1) == block->pc;
+
+	return false;
+}
+
+// Called when a block has run a full pass of count instructions and
+// branched back to its start
+static void cpuIdleCheck (cpu_block_t *block, int count)
+{
+	if (block->idle == CPU_IDLE_NONE)
+	{
+		cpuIdle.block = NULL;
+		return;
+	}
+
+	bool same = cpuIdle.block == block &&
+		cpuIdle.N == N_FLAG && cpuIdle.Z == Z_FLAG && cpuIdle.C == C_FLAG && cpuIdle.V == V_FLAG &&
+		cpuIdle.busPrefetchCount == bus.busPrefetchCount;
+
+	for (int i = 0; same && i < 16; i++)
+		same = cpuIdle.reg[i] == bus.reg[i].I;
+
+	if (same)
+	{
+		bool safe = block->pc == cpuIdleAddress ||
+			((block->key & 1) ? thumbIdleLoopSafe(block, count) : armIdleLoopSafe(block, count));
+
+		int ticks = cpuTotalTicks - cpuIdle.ticks;
+
+		if (!safe)
+		{
+			block->idle = CPU_IDLE_NONE;
+			cpuIdle.block = NULL;
+			return;
+		}
+
+		if (ticks > 0 && cpuTotalTicks < cpuNextEvent)
+			cpuTotalTicks += ((cpuNextEvent - 1 - cpuTotalTicks) / ticks) * ticks;
+	}
+
+	cpuIdle.block = block;
+	for (int i = 0; i < 16; i++)
+		cpuIdle.reg[i] = bus.reg[i].I;
+	cpuIdle.N = N_FLAG;
+	cpuIdle.Z = Z_FLAG;
+	cpuIdle.C = C_FLAG;
+	cpuIdle.V = V_FLAG;
+	cpuIdle.busPrefetchCount = bus.busPrefetchCount;
+	cpuIdle.ticks = cpuTotalTicks;
+}
+
+// Thumb counterparts of armBlockStep and armExecuteBlock
+static INLINE int thumbBlockStep (cpu_block_t *block, int i)
+{
+	clockTicks = 0;
+
+	u32 opcode = block->opcode[i];
+	cpuPrefetch[0] = block->opcode[i + 1];
+	cpuPrefetch[1] = block->opcode[i + 2];
+
+	bus.busPrefetch = false;
+
+	u32 oldArmNextPC = bus.armNextPC;
+
+	bus.armNextPC = bus.reg[15].I;
+	bus.reg[15].I += 2;
+
+	(*block->func[i])(opcode);
+
+	int ct = clockTicks;
+
+	if (ct < 0)
+		return 0;
+
+	if (ct == 0)
+		clockTicks = codeTicksAccessSeq16(oldArmNextPC) + 1;
+
+	cpuTotalTicks += clockTicks;
+
+	// the pipeline was refilled by a taken branch
+	u32 nextPC = block->pc + ((i + 1) << 1);
+	if ((bus.armNextPC != nextPC) | (bus.reg[15].I != nextPC + 2))
+		return i + 1;
+
+	if (codeWritten)
+	{
+		codeWritten = false;
+		if (block->gen != codePageGen[block->page])
+			return i + 1;
+	}
+
+	return -1;
+}
+
+static INLINE bool thumbBlockContinues (cpu_block_t *block, int i)
+{
+#ifdef USE_SWITICKS
+	return i < block->count && cpuTotalTicks < cpuNextEvent && !armState && !holdState && !SWITicks;
+#else
+	return (i < block->count) & (cpuTotalTicks < cpuNextEvent) & ~armState & ~holdState;
+#endif
+}
+
+static INLINE int thumbExecuteBlock (cpu_block_t *block)
+{
+	int i = 0;
+
+	do
+	{
+		int ret = thumbBlockStep(block, i);
+		if (ret >= 0)
+			return ret;
+	} while (thumbBlockContinues(block, ++i));
+
+	return i;
+}
+
+#ifdef HAVE_GBA_JIT
+// Translated code hands the instructions it has no native code for to
+// these, without keeping bus.armNextPC and R15 up to date itself
+static int jitArmStep (void *block, int i)
+{
+	u32 pc = ((cpu_block_t *)block)->pc + (i << 2);
+	bus.armNextPC = pc;
+	bus.reg[15].I = pc + 4;
+
+	int ret = armBlockStep((cpu_block_t *)block, i);
+	if (ret < 0 && !armBlockContinues((cpu_block_t *)block, i + 1))
+		ret = i + 1;
+	return ret;
+}
+
+static int jitThumbStep (void *block, int i)
+{
+	u32 pc = ((cpu_block_t *)block)->pc + (i << 1);
+	bus.armNextPC = pc;
+	bus.reg[15].I = pc + 2;
+
+	int ret = thumbBlockStep((cpu_block_t *)block, i);
+	if (ret < 0 && !thumbBlockContinues((cpu_block_t *)block, i + 1))
+		ret = i + 1;
+	return ret;
+}
+
+static jit_block_t cpuBlockTranslate (cpu_block_t *block)
+{
+	jit_block_t code = jitTranslate(block, block->opcode, block->count, block->pc, block->key & 1);
+
+	// the code buffer is full: start it over
+	if (!code)
+	{
+		for (int i = 0; i < CPU_BLOCK_COUNT; i++)
+			cpuBlocks[i].code = NULL;
+		jitReset();
+		code = jitTranslate(block, block->opcode, block->count, block->pc, block->key & 1);
+		if (!code)
+			cpuRecompiler = false;
+	}
+
+	block->code = code;
+	return code;
+}
+#endif
+
+void CPUSetRecompiler (bool enable)
+{
+#ifdef HAVE_GBA_JIT
+	jit_env_t env;
+
+	env.reg = &bus.reg[0].I;
+	env.armNextPC = &bus.armNextPC;
+	env.busPrefetchCount = &bus.busPrefetchCount;
+	env.busPrefetch = &bus.busPrefetch;
+	env.N = &N_FLAG;
+	env.Z = &Z_FLAG;
+	env.C = &C_FLAG;
+	env.V = &V_FLAG;
+	env.cpuTotalTicks = &cpuTotalTicks;
+	env.cpuNextEvent = &cpuNextEvent;
+	env.cpuPrefetch = cpuPrefetch;
+	env.memoryWait = memoryWait;
+	env.memoryWaitSeq = memoryWaitSeq;
+	env.memoryWait32 = memoryWait32;
+	env.memoryWaitSeq32 = memoryWaitSeq32;
+	env.armStep = jitArmStep;
+	env.thumbStep = jitThumbStep;
+
+	cpuBlockFlush();
+	cpuRecompiler = enable && jitInit(&env);
+#endif
+}
+
+// Wrapper routine (execution loop) ///////////////////////////////////////
+
+
+static int thumbExecute (void)
+{
+	CACHE_PREFETCH(clockTicks);
+
+	cpuIdle.block = NULL;
+
+	int ct = 0;
+
+	do {
+
+		if (cpuDecodeCache)
+		{
+			cpu_block_t *block = cpuBlockGet(bus.armNextPC, true);
+
+			if (block && block->opcode[0] == cpuPrefetch[0] && block->opcode[1] == cpuPrefetch[1])
+			{
+				int count;
+#ifdef HAVE_GBA_JIT
+				if (cpuRecompiler && (block->code || (++block->runs >= CPU_BLOCK_HOT && cpuBlockTranslate(block))))
+					count = block->code();
+				else
+#endif
+				count = thumbExecuteBlock(block);
+
+				if (!count)
+					return 0;
+
+				if (cpuIdleSkip && bus.armNextPC == block->pc)
+					cpuIdleCheck(block, count);
+				else
+					cpuIdle.block = NULL;
+				continue;
+			}
+		}
+
+		cpuIdle.block = NULL;
+
+		clockTicks = 0;
+
+#if 0
+		if ((bus.armNextPC & 0x0803FFFF) == 0x08020000)
+		   bus.busPrefetchCount=0x100;
+#endif
+
+		u32 opcode = cpuPrefetch[0];
+		cpuPrefetch[0] = cpuPrefetch[1];
+
+		bus.busPrefetch = false;
 #if 0
 		if (bus.busPrefetchCount & 0xFFFFFF00)
 			bus.busPrefetchCount = 0x100 | (bus.busPrefetchCount & 0xFF);
@@ -8292,14 +9310,116 @@ static bool CPUIsELF(const char *file)
 }
 #endif
 
-void CPUCleanUp (void)
+/*============================================================
+	ROM STORAGE
+============================================================ */
+
+// The cartridge space is 32MB. Past the end of the image the bus returns
+// the low address bits, a pattern that repeats every 128KB, so on Linux
+// all of those chunks map one shared copy of it and only the image itself
+// is resident. A chunk gets private pages before anything writes to it.
+
+#define ROM_SPACE		0x2000000
+#define ROM_CHUNK		0x20000
+#define ROM_CHUNKS		(ROM_SPACE / ROM_CHUNK)
+
+static uint8_t *romOpenBus = NULL;
+static bool romMapped = false;
+static bool romShared[ROM_CHUNKS];
+
+static void romFillOpenBus(u32 start, u32 end)
+{
+	for(u32 i = start; i < end; i += 2)
+		WRITE16LE((uint16_t *)(rom + i), (i >> 1) & 0xFFFF);
+}
+
+static uint8_t *romAlloc (void)
+{
+	memset(romShared, 0, sizeof(romShared));
+#if defined(__linux__) && defined(MREMAP_FIXED)
+	void *space = mmap(NULL, ROM_SPACE, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if(space != MAP_FAILED) {
+		romMapped = true;
+		return (uint8_t *)space;
+	}
+#endif
+	romMapped = false;
+	return (uint8_t *)malloc(ROM_SPACE);
+}
+
+static void romFree (void)
 {
-/*	
-	if(rom != NULL) {
+	if(rom == NULL)
+		return;
+#ifdef __linux__
+	if(romMapped)
+		munmap(rom, ROM_SPACE);
+	else
+#endif
 		free(rom);
-		rom = NULL;
+	rom = NULL;
+}
+
+// Fills everything past romSize with the open bus pattern
+static void romMapOpenBus (void)
+{
+	u32 end = (romSize + ROM_CHUNK - 1) & ~(ROM_CHUNK - 1);
+	if(end > ROM_SPACE)
+		end = ROM_SPACE;
+	romFillOpenBus((romSize + 1) & ~1, end);
+
+#if defined(__linux__) && defined(MREMAP_FIXED)
+	if(romMapped && romOpenBus == NULL) {
+		void *page = mmap(NULL, ROM_CHUNK, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if(page != MAP_FAILED) {
+			romOpenBus = (uint8_t *)page;
+			for(u32 i = 0; i < ROM_CHUNK; i += 2)
+				WRITE16LE((uint16_t *)(romOpenBus + i), (i >> 1) & 0xFFFF);
+		}
 	}
-*/
+
+	if(romMapped && romOpenBus != NULL) {
+		// a zero old size makes mremap map the same shared pages again
+		for(; end < ROM_SPACE; end += ROM_CHUNK) {
+			if(mremap(romOpenBus, 0, ROM_CHUNK, MREMAP_MAYMOVE | MREMAP_FIXED,
+				rom + end) == MAP_FAILED)
+				break;
+			romShared[end / ROM_CHUNK] = true;
+		}
+	}
+#endif
+
+	romFillOpenBus(end, ROM_SPACE);
+}
+
+// Must be called before writing to rom[start..start+size) past the image
+static void romWritable (u32 start, u32 size)
+{
+#ifdef __linux__
+	u32 last = (start + size - 1) & (ROM_SPACE - 1);
+	for(u32 i = (start & (ROM_SPACE - 1)) / ROM_CHUNK; i <= last / ROM_CHUNK; i++) {
+		if(!romShared[i])
+			continue;
+		uint8_t *chunk = rom + i * ROM_CHUNK;
+		mmap(chunk, ROM_CHUNK, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+		memcpy(chunk, romOpenBus, ROM_CHUNK);
+		romShared[i] = false;
+	}
+#endif
+}
+
+void CPUCleanUp (void)
+{
+	romFree();
+
+#ifdef HAVE_GBA_JIT
+	cpuBlockFlush();
+	jitCleanUp();
+#endif
+
 	if(vram != NULL) {
 		free(vram);
 		vram = NULL;
@@ -8341,18 +9461,20 @@ void CPUCleanUp (void)
 	}
 }
 
-int CPULoadRomBuffer(void *buf, int size)
+int CPULoadRomBuffer(const void *buf, int size)
 {
-	romSize = size;
-	rom = (uint8_t *)buf;
-	
-	uint16_t *temp = (uint16_t *)(rom+((romSize+1)&~1));
-	int i;
-	for(i = (romSize+1)&~1; i < 0x2000000; i+=2) {
-		WRITE16LE(temp, (i >> 1) & 0xFFFF);
-		temp++;
-	}
-	
+	if(rom != NULL)
+		CPUCleanUp();
+
+	romSize = size > ROM_SPACE ? ROM_SPACE : size;
+	rom = romAlloc();
+
+	if(rom == NULL)
+		return 0;
+
+	memcpy(rom, buf, romSize);
+	romMapOpenBus();
+
 	workRAM = (uint8_t *)calloc(1, 0x40000);
 	if(workRAM == NULL)
 		return 0;
@@ -8406,11 +9528,11 @@ int CPULoadRomBuffer(void *buf, int size)
 
 int CPULoadRom(const char * file)
 {
-	romSize = 0x2000000;
+	romSize = ROM_SPACE;
 	if(rom != NULL)
 		CPUCleanUp();
 
-	rom = (uint8_t *)malloc(0x2000000);
+	rom = romAlloc();
 
 	if(rom == NULL)
 		return 0;
@@ -8428,20 +9550,14 @@ int CPULoadRom(const char * file)
 						utilIsGBAImage,
 						whereToLoad,
 						romSize)) {
-				free(rom);
-				rom = NULL;
+				romFree();
 				free(workRAM);
 				workRAM = NULL;
 				return 0;
 			}
 		}
 
-	uint16_t *temp = (uint16_t *)(rom+((romSize+1)&~1));
-	int i;
-	for(i = (romSize+1)&~1; i < 0x2000000; i+=2) {
-		WRITE16LE(temp, (i >> 1) & 0xFFFF);
-		temp++;
-	}
+	romMapOpenBus();
 
 	bios = (uint8_t *)calloc(1,0x4000);
 	if(bios == NULL) {
@@ -8499,6 +9615,7 @@ void doMirroring (bool b)
 		mirroredRomAddress = mirroredRomSize;
 		if (mirroredRomSize==0)
 			mirroredRomSize=0x100000;
+		romWritable(mirroredRomAddress, 0x01000000 - mirroredRomAddress);
 		while (mirroredRomAddress<0x01000000)
 		{
 			memcpy((uint16_t *)(rom+mirroredRomAddress), (uint16_t *)(rom), mirroredRomSize);
@@ -8532,6 +9649,294 @@ void doMirroring (bool b)
 /* we only use 16bit color depth */
 #define INIT_COLOR_DEPTH_LINE_MIX() uint16_t * lineMix = (pix + PIX_BUFFER_SCREEN_WIDTH * io_registers[REG_VCOUNT])
 
+/*============================================================
+	LINE COMPOSITOR
+============================================================ */
+
+// Vector version of the per-pixel loops in the renderers below, 8 pixels
+// at a time in 16 bit lanes. Each line entry is split into its color half
+// and its high half, whose top byte is the priority (0x80 and above when
+// transparent, 0x30 for the backdrop) and whose low bit marks a
+// semi-transparent OBJ. The layer searches, window masks and color
+// effects are the scalar ones, so the output is the same bit for bit.
+
+#if defined(GFX_NEON) || defined(GFX_SSE2)
+
+#if defined(GFX_NEON)
+
+typedef uint16x8_t gfx_vec_t;
+
+#define gfxVecSet(x)		vdupq_n_u16((uint16_t)(x))
+#define gfxVecAnd(a, b)		vandq_u16(a, b)
+#define gfxVecOr(a, b)		vorrq_u16(a, b)
+#define gfxVecAndNot(a, b)	vbicq_u16(b, a)			// b & ~a
+#define gfxVecSelect(m, a, b)	vbslq_u16(m, a, b)		// m ? a : b
+#define gfxVecEq(a, b)		vceqq_u16(a, b)
+#define gfxVecLt(a, b)		vcltq_u16(a, b)
+#define gfxVecMin(a, b)		vminq_u16(a, b)
+#define gfxVecAdd(a, b)		vaddq_u16(a, b)
+#define gfxVecSub(a, b)		vsubq_u16(a, b)
+#define gfxVecMul(a, b)		vmulq_u16(a, b)
+#define gfxVecShr(a, n)		vshrq_n_u16(a, n)
+#define gfxVecShl(a, n)		vshlq_n_u16(a, n)
+
+static INLINE void gfxVecLoadLine(const uint32_t *src, gfx_vec_t &lo, gfx_vec_t &hi)
+{
+	uint16x8x2_t v = vld2q_u16((const uint16_t *)src);
+	lo = v.val[0];
+	hi = v.val[1];
+}
+
+static INLINE gfx_vec_t gfxVecLoadFlags(const bool *src)
+{
+	return vmovl_u8(vld1_u8((const uint8_t *)src));
+}
+
+static INLINE void gfxVecStore(uint16_t *dest, gfx_vec_t v)
+{
+	vst1q_u16(dest, v);
+}
+
+static INLINE bool gfxVecAny(gfx_vec_t v)
+{
+	uint64x2_t q = vreinterpretq_u64_u16(v);
+	return (vgetq_lane_u64(q, 0) | vgetq_lane_u64(q, 1)) != 0;
+}
+
+#else
+
+typedef __m128i gfx_vec_t;
+
+#define gfxVecSet(x)		_mm_set1_epi16((short)(x))
+#define gfxVecAnd(a, b)		_mm_and_si128(a, b)
+#define gfxVecOr(a, b)		_mm_or_si128(a, b)
+#define gfxVecAndNot(a, b)	_mm_andnot_si128(a, b)		// b & ~a
+#define gfxVecSelect(m, a, b)	_mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b))
+#define gfxVecEq(a, b)		_mm_cmpeq_epi16(a, b)
+#define gfxVecLt(a, b)		_mm_cmplt_epi16(a, b)		// only used on values below 0x8000
+#define gfxVecMin(a, b)		_mm_min_epi16(a, b)
+#define gfxVecAdd(a, b)		_mm_add_epi16(a, b)
+#define gfxVecSub(a, b)		_mm_sub_epi16(a, b)
+#define gfxVecMul(a, b)		_mm_mullo_epi16(a, b)
+#define gfxVecShr(a, n)		_mm_srli_epi16(a, n)
+#define gfxVecShl(a, n)		_mm_slli_epi16(a, n)
+
+static INLINE void gfxVecLoadLine(const uint32_t *src, gfx_vec_t &lo, gfx_vec_t &hi)
+{
+	__m128i a = _mm_loadu_si128((const __m128i *)src);
+	__m128i b = _mm_loadu_si128((const __m128i *)(src + 4));
+
+	// sign extending keeps both halves in range for the signed pack
+	lo = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+	hi = _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16));
+}
+
+static INLINE gfx_vec_t gfxVecLoadFlags(const bool *src)
+{
+	return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)src), _mm_setzero_si128());
+}
+
+static INLINE void gfxVecStore(uint16_t *dest, gfx_vec_t v)
+{
+	_mm_storeu_si128((__m128i *)dest, v);
+}
+
+static INLINE bool gfxVecAny(gfx_vec_t v)
+{
+	return _mm_movemask_epi8(v) != 0;
+}
+
+#endif
+
+// All ones in the lanes where v has one of the bits set
+static INLINE gfx_vec_t gfxVecTest(gfx_vec_t v, gfx_vec_t bits)
+{
+	return gfxVecAndNot(gfxVecEq(gfxVecAnd(v, bits), gfxVecSet(0)), gfxVecSet(0xFFFF));
+}
+
+static INLINE gfx_vec_t gfxVecAlphaBlend(gfx_vec_t color, gfx_vec_t back, gfx_vec_t ca, gfx_vec_t cb)
+{
+	gfx_vec_t field = gfxVecSet(0x1F);
+	gfx_vec_t r = gfxVecAdd(gfxVecShr(gfxVecMul(gfxVecAnd(color, field), ca), 4),
+		gfxVecShr(gfxVecMul(gfxVecAnd(back, field), cb), 4));
+	gfx_vec_t g = gfxVecAdd(gfxVecShr(gfxVecMul(gfxVecAnd(gfxVecShr(color, 5), field), ca), 4),
+		gfxVecShr(gfxVecMul(gfxVecAnd(gfxVecShr(back, 5), field), cb), 4));
+	gfx_vec_t b = gfxVecAdd(gfxVecShr(gfxVecMul(gfxVecAnd(gfxVecShr(color, 10), field), ca), 4),
+		gfxVecShr(gfxVecMul(gfxVecAnd(gfxVecShr(back, 10), field), cb), 4));
+
+	// AlphaClampLUT
+	r = gfxVecMin(r, field);
+	g = gfxVecMin(g, field);
+	b = gfxVecMin(b, field);
+
+	return gfxVecOr(gfxVecOr(r, gfxVecShl(g, 5)), gfxVecShl(b, 10));
+}
+
+// gfxIncreaseBrightness or gfxDecreaseBrightness on each field
+static INLINE gfx_vec_t gfxVecBrightness(gfx_vec_t color, gfx_vec_t cy, bool increase)
+{
+	gfx_vec_t field = gfxVecSet(0x1F);
+	gfx_vec_t r = gfxVecAnd(color, field);
+	gfx_vec_t g = gfxVecAnd(gfxVecShr(color, 5), field);
+	gfx_vec_t b = gfxVecAnd(gfxVecShr(color, 10), field);
+
+	if(increase) {
+		r = gfxVecAdd(r, gfxVecShr(gfxVecMul(gfxVecSub(field, r), cy), 4));
+		g = gfxVecAdd(g, gfxVecShr(gfxVecMul(gfxVecSub(field, g), cy), 4));
+		b = gfxVecAdd(b, gfxVecShr(gfxVecMul(gfxVecSub(field, b), cy), 4));
+	} else {
+		r = gfxVecSub(r, gfxVecShr(gfxVecMul(r, cy), 4));
+		g = gfxVecSub(g, gfxVecShr(gfxVecMul(g, cy), 4));
+		b = gfxVecSub(b, gfxVecShr(gfxVecMul(b, cy), 4));
+	}
+
+	return gfxVecOr(gfxVecOr(r, gfxVecShl(g, 5)), gfxVecShl(b, 10));
+}
+
+// CONVERT_COLOR
+static INLINE gfx_vec_t gfxVecConvert(gfx_vec_t color)
+{
+#ifdef FRONTEND_SUPPORTS_RGB565
+	return gfxVecOr(gfxVecOr(gfxVecShl(color, 11), gfxVecShl(gfxVecAnd(color, gfxVecSet(0x03e0)), 1)),
+		gfxVecOr(gfxVecShr(gfxVecAnd(color, gfxVecSet(0x0200)), 4), gfxVecShr(gfxVecAnd(color, gfxVecSet(0x7c00)), 10)));
+#else
+	return gfxVecOr(gfxVecOr(gfxVecAnd(gfxVecShl(color, 10), gfxVecSet(0x7c00)), gfxVecAnd(color, gfxVecSet(0x03e0))),
+		gfxVecShr(gfxVecAnd(color, gfxVecSet(0x7c00)), 10));
+#endif
+}
+
+// Composites the whole line from line[], using the BG layers in layers
+// (bit 0 for BG0) and OBJ. fx applies the color effects to pixels that are
+// not semi-transparent OBJ, as the NoWindow and All renderers do; windowed
+// takes the layer mask of each pixel from the windows, as the All
+// renderers do. Returns the number of pixels done.
+template<int layers, bool fx, bool windowed>
+static int gfxComposeLine(uint16_t *lineMix, uint32_t backdrop, bool inWindow0, bool inWindow1)
+{
+	int effect = (BLDMOD >> 6) & 3;
+
+	gfx_vec_t target1 = gfxVecSet(BLDMOD & 0x3F);
+	gfx_vec_t target2 = gfxVecSet((BLDMOD >> 8) & 0x3F);
+	gfx_vec_t ca = gfxVecSet(coeff[COLEV & 0x1F]);
+	gfx_vec_t cb = gfxVecSet(coeff[(COLEV >> 8) & 0x1F]);
+	gfx_vec_t cy = gfxVecSet(coeff[COLY & 0x1F]);
+
+	gfx_vec_t backColor = gfxVecSet(backdrop & 0xFFFF);
+	gfx_vec_t backPrio = gfxVecSet(backdrop >> 24);
+	gfx_vec_t opaquePrio = gfxVecSet(0x80);
+	gfx_vec_t ones = gfxVecSet(0xFFFF);
+
+	gfx_vec_t inWin0Mask = gfxVecSet(io_registers[REG_WININ] & 0xFF);
+	gfx_vec_t inWin1Mask = gfxVecSet(io_registers[REG_WININ] >> 8);
+	gfx_vec_t outMask = gfxVecSet(io_registers[REG_WINOUT] & 0xFF);
+	gfx_vec_t objWinMask = gfxVecSet(io_registers[REG_WINOUT] >> 8);
+	gfx_vec_t window0 = gfxVecSet(inWindow0 ? 0xFFFF : 0);
+	gfx_vec_t window1 = gfxVecSet(inWindow1 ? 0xFFFF : 0);
+
+	const int used = (layers & 0x0F) | 0x10;
+
+	for(int x = 0; x < 240; x += 8) {
+		gfx_vec_t prio[5], color[5], bit[5], enable[5];
+
+		gfx_vec_t mask = ones;
+		if(windowed) {
+			gfx_vec_t lo, high;
+			gfxVecLoadLine(&line[5][x], lo, high);
+			mask = gfxVecSelect(gfxVecTest(high, gfxVecSet(0x8000)), outMask, objWinMask);
+			mask = gfxVecSelect(gfxVecAnd(window1, gfxVecTest(gfxVecLoadFlags(&gfxInWin[1][x]), ones)), inWin1Mask, mask);
+			mask = gfxVecSelect(gfxVecAnd(window0, gfxVecTest(gfxVecLoadFlags(&gfxInWin[0][x]), ones)), inWin0Mask, mask);
+		}
+
+		for(int i = 0; i < 4; i++) {
+			if(!(used & (1 << i)))
+				continue;
+			gfx_vec_t high;
+			gfxVecLoadLine(&line[i][x], color[i], high);
+			prio[i] = gfxVecShr(high, 8);
+			bit[i] = gfxVecSet(1 << i);
+			enable[i] = gfxVecTest(mask, bit[i]);
+		}
+
+		// OBJ, which also carries the semi-transparency flag
+		gfx_vec_t objHigh;
+		gfxVecLoadLine(&line[4][x], color[4], objHigh);
+		prio[4] = gfxVecShr(objHigh, 8);
+		bit[4] = gfxVecSet(0x10);
+		enable[4] = gfxVecTest(mask, bit[4]);
+		gfx_vec_t semi = gfxVecTest(objHigh, gfxVecSet(1));
+
+		// top layer
+		gfx_vec_t topPrio = backPrio;
+		gfx_vec_t topColor = backColor;
+		gfx_vec_t top = gfxVecSet(0x20);
+		for(int i = 0; i < 5; i++) {
+			if(!(used & (1 << i)))
+				continue;
+			gfx_vec_t take = gfxVecAnd(enable[i], gfxVecLt(prio[i], topPrio));
+			topPrio = gfxVecSelect(take, prio[i], topPrio);
+			topColor = gfxVecSelect(take, color[i], topColor);
+			top = gfxVecSelect(take, bit[i], top);
+		}
+		semi = gfxVecAnd(semi, gfxVecEq(top, bit[4]));
+
+		gfx_vec_t opaque = gfxVecLt(topPrio, opaquePrio);
+		gfx_vec_t first = gfxVecTest(top, target1);
+
+		gfx_vec_t effects = gfxVecSet(0);
+		if(fx) {
+			effects = gfxVecAndNot(semi, first);
+			if(windowed)
+				effects = gfxVecAnd(effects, gfxVecTest(mask, gfxVecSet(0x20)));
+		}
+
+		gfx_vec_t blend = gfxVecSet(0);
+		gfx_vec_t bright = effect >= 2 ? effects : gfxVecSet(0);
+		gfx_vec_t result = topColor;
+
+		gfx_vec_t alpha = effect == 1 ? gfxVecOr(semi, effects) : semi;
+		if(gfxVecAny(alpha)) {
+			// layer below the top one; with a semi-transparent OBJ on top
+			// this is the BG search of alpha_blend_brightness_switch
+			gfx_vec_t secondPrio = backPrio;
+			gfx_vec_t secondColor = backColor;
+			gfx_vec_t top2 = gfxVecSet(0x20);
+			for(int i = 0; i < 5; i++) {
+				if(!(used & (1 << i)))
+					continue;
+				gfx_vec_t take = gfxVecAndNot(gfxVecEq(top, bit[i]), gfxVecAnd(enable[i], gfxVecLt(prio[i], secondPrio)));
+				secondPrio = gfxVecSelect(take, prio[i], secondPrio);
+				secondColor = gfxVecSelect(take, color[i], secondColor);
+				top2 = gfxVecSelect(take, bit[i], top2);
+			}
+
+			gfx_vec_t second = gfxVecTest(top2, target2);
+			blend = gfxVecAnd(alpha, gfxVecAnd(second, opaque));
+			if(effect >= 2)
+				bright = gfxVecOr(bright, gfxVecAndNot(opaque, gfxVecAnd(semi, gfxVecAnd(second, first))));
+
+			if(gfxVecAny(blend))
+				result = gfxVecSelect(blend, gfxVecAlphaBlend(topColor, secondColor, ca, cb), result);
+		}
+
+		if(gfxVecAny(bright))
+			result = gfxVecSelect(bright, gfxVecBrightness(topColor, cy, effect == 2), result);
+
+		gfxVecStore(&lineMix[x], gfxVecConvert(result));
+	}
+
+	return 240;
+}
+
+#else
+
+template<int layers, bool fx, bool windowed>
+static int gfxComposeLine(uint16_t *lineMix, uint32_t backdrop, bool inWindow0, bool inWindow1)
+{
+	return 0;
+}
+
+#endif
+
 static void mode0RenderLine (void)
 {
 #ifdef REPORT_VIDEO_MODES
@@ -8560,7 +9965,7 @@ static void mode0RenderLine (void)
 
 	uint32_t backdrop = (READ16LE(&palette[0]) | 0x30000000);
 
-	for(int x = 0; x < 240; x++)
+	for(int x = gfxComposeLine<0x0F, false, false>(lineMix, backdrop, false, false); x < 240; x++)
 	{
 		uint32_t color = backdrop;
 		uint8_t top = 0x20;
@@ -8651,7 +10056,7 @@ static void mode0RenderLineNoWindow (void)
 
 	int effect = (BLDMOD >> 6) & 3;
 
-	for(int x = 0; x < 240; x++) {
+	for(int x = gfxComposeLine<0x0F, true, false>(lineMix, backdrop, false, false); x < 240; x++) {
 		uint32_t color = backdrop;
 		uint8_t top = 0x20;
 
@@ -8820,7 +10225,7 @@ static void mode0RenderLineAll (void)
 	uint8_t inWin1Mask = io_registers[REG_WININ] >> 8;
 	uint8_t outMask = io_registers[REG_WINOUT] & 0xFF;
 
-	for(int x = 0; x < 240; x++) {
+	for(int x = gfxComposeLine<0x0F, true, true>(lineMix, backdrop, inWindow0, inWindow1); x < 240; x++) {
 		uint32_t color = backdrop;
 		uint8_t top = 0x20;
 		uint8_t mask = outMask;
@@ -8986,7 +10391,7 @@ static void mode1RenderLine (void)
 
 	uint32_t backdrop = (READ16LE(&palette[0]) | 0x30000000);
 
-	for(uint32_t x = 0; x < 240u; ++x) {
+	for(uint32_t x = gfxComposeLine<0x07, false, false>(lineMix, backdrop, false, false); x < 240u; ++x) {
 		uint32_t color = backdrop;
 		uint8_t top = 0x20;
 
@@ -9086,7 +10491,7 @@ static void mode1RenderLineNoWindow (void)
 
 	uint32_t backdrop = (READ16LE(&palette[0]) | 0x30000000);
 
-	for(int x = 0; x < 240; ++x) {
+	for(int x = gfxComposeLine<0x07, true, false>(lineMix, backdrop, false, false); x < 240; ++x) {
 		uint32_t color = backdrop;
 		uint8_t top = 0x20;
 
@@ -9276,7 +10681,7 @@ static void mode1RenderLineAll (void)
 	uint8_t inWin1Mask = io_registers[REG_WININ] >> 8;
 	uint8_t outMask = io_registers[REG_WINOUT] & 0xFF;
 
-	for(int x = 0; x < 240; ++x) {
+	for(int x = gfxComposeLine<0x07, true, true>(lineMix, backdrop, inWindow0, inWindow1); x < 240; ++x) {
 		uint32_t color = backdrop;
 		uint8_t top = 0x20;
 		uint8_t mask = outMask;
@@ -9430,7 +10835,7 @@ static void mode2RenderLine (void)
 
 	uint32_t backdrop = (READ16LE(&palette[0]) | 0x30000000);
 
-	for(int x = 0; x < 240; ++x) {
+	for(int x = gfxComposeLine<0x0C, false, false>(lineMix, backdrop, false, false); x < 240; ++x) {
 		uint32_t color = backdrop;
 		uint8_t top = 0x20;
 
@@ -9522,7 +10927,7 @@ static void mode2RenderLineNoWindow (void)
 
 	uint32_t backdrop = (READ16LE(&palette[0]) | 0x30000000);
 
-	for(int x = 0; x < 240; ++x) {
+	for(int x = gfxComposeLine<0x0C, true, false>(lineMix, backdrop, false, false); x < 240; ++x) {
 		uint32_t color = backdrop;
 		uint8_t top = 0x20;
 
@@ -9693,7 +11098,7 @@ static void mode2RenderLineAll (void)
 	uint8_t inWin1Mask = io_registers[REG_WININ] >> 8;
 	uint8_t outMask = io_registers[REG_WINOUT] & 0xFF;
 
-	for(int x = 0; x < 240; x++) {
+	for(int x = gfxComposeLine<0x0C, true, true>(lineMix, backdrop, inWindow0, inWindow1); x < 240; x++) {
 		uint32_t color = backdrop;
 		uint8_t top = 0x20;
 		uint8_t mask = outMask;
@@ -9817,7 +11222,7 @@ static void mode3RenderLine (void)
 
 	uint32_t background = (READ16LE(&palette[0]) | 0x30000000);
 
-	for(int x = 0; x < 240; ++x) {
+	for(int x = gfxComposeLine<0x04, false, false>(lineMix, background, false, false); x < 240; ++x) {
 		uint32_t color = background;
 		uint8_t top = 0x20;
 
@@ -9872,7 +11277,7 @@ static void mode3RenderLineNoWindow (void)
 
 	uint32_t background = (READ16LE(&palette[0]) | 0x30000000);
 
-	for(int x = 0; x < 240; ++x) {
+	for(int x = gfxComposeLine<0x04, true, false>(lineMix, background, false, false); x < 240; ++x) {
 		uint32_t color = background;
 		uint8_t top = 0x20;
 
@@ -10003,7 +11408,7 @@ static void mode3RenderLineAll (void)
 
 	uint32_t background = (READ16LE(&palette[0]) | 0x30000000);
 
-	for(int x = 0; x < 240; ++x) {
+	for(int x = gfxComposeLine<0x04, true, true>(lineMix, background, inWindow0, inWindow1); x < 240; ++x) {
 		uint32_t color = background;
 		uint8_t top = 0x20;
 		uint8_t mask = outMask;
@@ -10111,7 +11516,7 @@ static void mode4RenderLine (void)
 
 	uint32_t backdrop = (READ16LE(&palette[0]) | 0x30000000);
 
-	for(int x = 0; x < 240; ++x)
+	for(int x = gfxComposeLine<0x04, false, false>(lineMix, backdrop, false, false); x < 240; ++x)
 	{
 		uint32_t color = backdrop;
 		uint8_t top = 0x20;
@@ -10168,7 +11573,7 @@ static void mode4RenderLineNoWindow (void)
 
 	uint32_t backdrop = (READ16LE(&palette[0]) | 0x30000000);
 
-	for(int x = 0; x < 240; ++x)
+	for(int x = gfxComposeLine<0x04, true, false>(lineMix, backdrop, false, false); x < 240; ++x)
 	{
 		uint32_t color = backdrop;
 		uint8_t top = 0x20;
@@ -10300,7 +11705,7 @@ static void mode4RenderLineAll (void)
 	uint8_t inWin1Mask = io_registers[REG_WININ] >> 8;
 	uint8_t outMask = io_registers[REG_WINOUT] & 0xFF;
 
-	for(int x = 0; x < 240; ++x) {
+	for(int x = gfxComposeLine<0x04, true, true>(lineMix, backdrop, inWindow0, inWindow1); x < 240; ++x) {
 		uint32_t color = backdrop;
 		uint8_t top = 0x20;
 		uint8_t mask = outMask;
@@ -10410,7 +11815,7 @@ static void mode5RenderLine (void)
 	uint32_t background;
 	background = (READ16LE(&palette[0]) | 0x30000000);
 
-	for(int x = 0; x < 240; ++x) {
+	for(int x = gfxComposeLine<0x04, false, false>(lineMix, background, false, false); x < 240; ++x) {
 		uint32_t color = background;
 		uint8_t top = 0x20;
 
@@ -10467,7 +11872,7 @@ static void mode5RenderLineNoWindow (void)
 	uint32_t background;
 	background = (READ16LE(&palette[0]) | 0x30000000);
 
-	for(int x = 0; x < 240; ++x) {
+	for(int x = gfxComposeLine<0x04, true, false>(lineMix, background, false, false); x < 240; ++x) {
 		uint32_t color = background;
 		uint8_t top = 0x20;
 
@@ -10603,7 +12008,7 @@ static void mode5RenderLineAll (void)
 	uint32_t background;
 	background = (READ16LE(&palette[0]) | 0x30000000);
 
-	for(int x = 0; x < 240; ++x) {
+	for(int x = gfxComposeLine<0x04, true, true>(lineMix, background, inWindow0, inWindow1); x < 240; ++x) {
 		uint32_t color = background;
 		uint8_t top = 0x20;
 		uint8_t mask = outMask;
@@ -10781,6 +12186,7 @@ bool CPUReadState(const uint8_t* data, unsigned size)
 	utilReadMem(internalRAM, data, 0x8000);
 	utilReadMem(graphics.paletteRAM, data, 0x400);
 	utilReadMem(workRAM, data, 0x40000);
+	cpuBlockFlush();
 	utilReadMem(vram, data, 0x20000);
 	utilReadMem(oam, data, 0x400);
 	utilReadMem(pix, data, 4* PIX_BUFFER_SCREEN_WIDTH * 160);
@@ -10956,6 +12362,94 @@ static void CPUSwitchMode(int mode, bool saveState, bool breakLoop)
 
 
 
+// Incrementing copies and fixed-source fills between linear regions are
+// done as one block. Returns false when the transfer has to go unit by
+// unit; s and d are left as the per-unit loop would leave them otherwise.
+static bool dmaBlockTransfer(uint32_t &s, uint32_t &d, uint32_t si, uint32_t di, uint32_t c, int transfer32)
+{
+	u32 unit = transfer32 ? 4 : 2;
+	u32 src = s & ~(unit - 1);
+	u32 dest = d & ~(unit - 1);
+	u32 len = c * unit;
+	u32 span;
+
+	if(di != 4 || (si != 4 && si != 0))
+		return false;
+
+	uint8_t *to = cpuHostAddress(dest, true, span);
+	if(to == NULL || span < len)
+		return false;
+
+	if(src < 0x02000000 && (bus.reg[15].I >> 24))
+	{
+		// BIOS is not readable from outside of it
+		memset(to, 0, len);
+		si = 0;
+	}
+	else
+	{
+		uint8_t *from = cpuHostAddress(src, false, span);
+		if(from == NULL)
+			return false;
+
+		// the RTC registers sit in the ROM header
+		if(!transfer32 && (src >> 24) == 0x08 && src < 0x80000ca && src + (si ? len : unit) > 0x80000c4)
+			return false;
+
+		if(si == 0)
+		{
+			// a fill that overwrites its own source changes value mid-way
+			if(from >= to && from < to + len)
+				return false;
+
+			if(transfer32)
+			{
+				u32 value = READ32LE((u32 *)from);
+				for(u32 i = 0; i < len; i += 4)
+					WRITE32LE((u32 *)(to + i), value);
+				cpuDmaLast = value;
+			}
+			else
+			{
+				u16 value = READ16LE((u16 *)from);
+				for(u32 i = 0; i < len; i += 2)
+					WRITE16LE((u16 *)(to + i), value);
+				cpuDmaLast = value | (value << 16);
+			}
+		}
+		else
+		{
+			// a forward unit copy onto a later part of its source repeats data
+			if(span < len || (to > from && to < from + len))
+				return false;
+
+			if(transfer32)
+				cpuDmaLast = READ32LE((u32 *)(from + len - 4));
+			else
+			{
+				cpuDmaLast = READ16LE((u16 *)(from + len - 2));
+				cpuDmaLast |= (cpuDmaLast << 16);
+			}
+			memmove(to, from, len);
+		}
+	}
+
+	if((dest >> 24) == 0x02)
+	{
+		for(u32 a = dest & ~(CODE_PAGE_SIZE - 1); a < dest + len; a += CODE_PAGE_SIZE)
+			CODE_PAGE_WRITE(CODE_PAGE_EWRAM(a));
+	}
+	else if((dest >> 24) == 0x03)
+	{
+		for(u32 a = dest & ~(CODE_PAGE_SIZE - 1); a < dest + len; a += CODE_PAGE_SIZE)
+			CODE_PAGE_WRITE(CODE_PAGE_IWRAM(a));
+	}
+
+	s = src + (si ? len : 0);
+	d += len;
+	return true;
+}
+
 void doDMA(uint32_t &s, uint32_t &d, uint32_t si, uint32_t di, uint32_t c, int transfer32)
 {
 	int sm = s >> 24;
@@ -10974,7 +12468,11 @@ void doDMA(uint32_t &s, uint32_t &d, uint32_t si, uint32_t di, uint32_t c, int t
 	//if ((sm>=0x05) && (sm<=0x07) || (dm>=0x05) && (dm <=0x07))
 	//    blank = (((io_registers[REG_DISPSTAT] | ((io_registers[REG_DISPSTAT] >> 1)&1))==1) ?  true : false);
 
-	if(transfer32)
+	if(dmaBlockTransfer(s, d, si, di, c, transfer32))
+	{
+		// waitstates below are the same either way
+	}
+	else if(transfer32)
 	{
 		s &= 0xFFFFFFFC;
 		if(s < 0x02000000 && (bus.reg[15].I >> 24))
@@ -11747,6 +13245,7 @@ void CPUInit(const char *biosFileName, bool useBiosFile)
 		ioReadable[i] = false;
 
 	if(romSize < 0x1fe2000) {
+		romWritable(0x1fe209c, 4);
 		*((uint16_t *)&rom[0x1fe209c]) = 0xdffa; // SWI 0xFA
 		*((uint16_t *)&rom[0x1fe209e]) = 0x4770; // BX LR
 	}
@@ -11810,6 +13309,7 @@ void CPUReset (void)
 	memset(pix, 0, 4 * 160 * 240);			// clean picture
 	memset(vram, 0, 0x20000);			// clean vram
 	memset(ioMem, 0, 0x400);			// clean io memory
+	cpuBlockFlush();				// ROM, BIOS or mirroring may have changed
 
 	io_registers[REG_DISPCNT]  = 0x0080;
 	io_registers[REG_DISPSTAT] = 0x0000;
@@ -12247,9 +13747,9 @@ updateLoop:
 							}
 						}
 
-						// If no (m) code is enabled, apply the cheats at each LCDline
-						if((cheatsEnabled)/* && (mastercode==0)*/)
-							/*remainingTicks += */cheatsCheckKeys(joy & 0x3FF, joy >> 10);
+						// Master codes are not supported; the cheats are applied once per frame
+						if(cheatsEnabled)
+							/*remainingTicks += */cheatsApply(joy & 0x3FF, joy >> 10);
 
 						io_registers[REG_DISPSTAT] |= 1;
 						io_registers[REG_DISPSTAT] &= 0xFFFD;
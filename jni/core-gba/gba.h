@@ -108,7 +108,7 @@ extern bool CPUReadBatteryFile(const char *);
 extern bool CPUReadState(const uint8_t * data, unsigned size);
 extern unsigned CPUWriteState(uint8_t* data, unsigned size);
 extern int CPULoadRom(const char *);
-extern int CPULoadRomBuffer(void *buf, int size);
+extern int CPULoadRomBuffer(const void *buf, int size);
 extern void doMirroring(bool);
 extern void CPUUpdateRegister(uint32_t, uint16_t);
 extern void CPUInit(const char *,bool);
@@ -116,5 +116,8 @@ extern void CPUReset (void);
 extern void CPULoop(void);
 extern void CPUCheckDMA(int,int);
 extern void CPUCleanUp (void);
+extern void CPUSetDecodeCache(bool enable);
+extern void CPUSetIdleSkip(bool enable);
+extern void CPUSetRecompiler(bool enable);
 
 #endif // GBA_H
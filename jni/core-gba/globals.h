@@ -13,6 +13,7 @@ extern bool enableRtc;
 extern bool skipSaveGameBattery; // skip battery data when reading save states
 extern bool renderEnabled;
 extern bool cheatsEnabled;
+extern u32 cpuIdleAddress;
 
 extern int cpuDmaCount;
 
@@ -335,6 +335,47 @@ static Blip_Synth pcm_synth; // 32 kHz, 16 kHz, 8 kHz
 static Blip_Buffer bufs_buffer [BUFS_SIZE];
 static int mixer_samples_read;
 
+/*============================================================
+	SOUND EVENT QUEUE
+============================================================ */
+
+// PCM amplitude changes and APU register writes are recorded with their
+// timestamps and synthesized in one pass at the end of the sound frame,
+// or earlier whenever the blip buffers are read, rebuilt or rescaled.
+// FIFO state still advances at event time since DMA refills depend on it.
+
+#define SOUND_EVENT_MAX 512
+
+typedef struct
+{
+	int32_t time;
+	int     data;		// PCM delta or APU register value
+	int     addr;		// APU register address
+	Blip_Buffer* output;	// PCM output, NULL for APU writes
+} sound_event_t;
+
+static sound_event_t sound_events [SOUND_EVENT_MAX];
+static int sound_event_count = 0;
+
+static void sound_events_render (void);
+
+static INLINE void sound_event_push( int32_t time, int addr, int data, Blip_Buffer* output )
+{
+	if ( sound_event_count == SOUND_EVENT_MAX )
+		sound_events_render();
+
+	sound_event_t& e = sound_events [sound_event_count++];
+	e.time   = time;
+	e.data   = data;
+	e.addr   = addr;
+	e.output = output;
+}
+
+static INLINE void pcm_synth_event( int32_t time, int delta, Blip_Buffer* output )
+{
+	sound_event_push( time, 0, delta, output );
+}
+
 static void gba_pcm_init (void)
 {
 	pcm[0].pcm.output    = 0;
@@ -373,7 +414,7 @@ static void gba_pcm_apply_control( int pcm_idx, int idx )
 	if ( pcm[pcm_idx].pcm.output != out )
 	{
 		if ( pcm[pcm_idx].pcm.output )
-			pcm_synth.offset( SOUND_CLOCK_TICKS - soundTicks, -pcm[pcm_idx].pcm.last_amp, pcm[pcm_idx].pcm.output );
+			pcm_synth_event( SOUND_CLOCK_TICKS - soundTicks, -pcm[pcm_idx].pcm.last_amp, pcm[pcm_idx].pcm.output );
 		pcm[pcm_idx].pcm.last_amp = 0;
 		pcm[pcm_idx].pcm.output = out;
 	}
@@ -707,6 +748,19 @@ static void gb_apu_write_register( int32_t time, unsigned addr, int data )
 	}
 }
 
+static void sound_events_render (void)
+{
+	for ( int i = 0; i < sound_event_count; i++ )
+	{
+		const sound_event_t& e = sound_events [i];
+		if ( e.output )
+			pcm_synth.offset( e.time, e.data, e.output );
+		else
+			gb_apu_write_register( e.time, e.addr, e.data );
+	}
+	sound_event_count = 0;
+}
+
 static void gb_apu_reset( uint32_t mode, bool agb_wave )
 {
 	/* Hardware mode*/
@@ -806,6 +860,7 @@ static void gb_apu_volume( double v )
 {
 	if ( gb_apu.volume_ != v )
 	{
+		sound_events_render();
 		gb_apu.volume_ = v;
 		gb_apu_apply_volume();
 	}
@@ -1729,7 +1784,7 @@ static void pcm_fifo_write_control( int data, int data2)
 		if ( delta )
 		{
 			pcm[0].pcm.last_amp = pcm[0].dac;
-			pcm_synth.offset( time, delta, pcm[0].pcm.output );
+			pcm_synth_event( time, delta, pcm[0].pcm.output );
 		}
 		pcm[0].pcm.last_time = time;
 	}
@@ -1758,7 +1813,7 @@ static void pcm_fifo_write_control( int data, int data2)
 		if ( delta )
 		{
 			pcm[1].pcm.last_amp = pcm[1].dac;
-			pcm_synth.offset( time, delta, pcm[1].pcm.output );
+			pcm_synth_event( time, delta, pcm[1].pcm.output );
 		}
 		pcm[1].pcm.last_time = time;
 	}
@@ -1845,7 +1900,7 @@ static void gba_pcm_fifo_timer_overflowed( unsigned pcm_idx )
 		if ( delta )
 		{
 			pcm[pcm_idx].pcm.last_amp = pcm[pcm_idx].dac;
-			pcm_synth.offset( time, delta, pcm[pcm_idx].pcm.output );
+			pcm_synth_event( time, delta, pcm[pcm_idx].pcm.output );
 		}
 		pcm[pcm_idx].pcm.last_time = time;
 	}
@@ -1856,7 +1911,7 @@ void soundEvent_u8_parallel(int gb_addr[], uint32_t address[], uint8_t data[])
 	for(uint32_t i = 0; i < 2; i++)
 	{
 		ioMem[address[i]] = data[i];
-		gb_apu_write_register( SOUND_CLOCK_TICKS -  soundTicks, gb_addr[i], data[i] );
+		sound_event_push( SOUND_CLOCK_TICKS -  soundTicks, gb_addr[i], data[i], NULL );
 
 		if ( address[i] == NR52 )
 		{
@@ -1870,7 +1925,7 @@ void soundEvent_u8_parallel(int gb_addr[], uint32_t address[], uint8_t data[])
 void soundEvent_u8(int gb_addr, uint32_t address, uint8_t data)
 {
 	ioMem[address] = data;
-	gb_apu_write_register( SOUND_CLOCK_TICKS -  soundTicks, gb_addr, data );
+	sound_event_push( SOUND_CLOCK_TICKS -  soundTicks, gb_addr, data, NULL );
 
 	if ( address == NR52 )
 	{
@@ -1939,6 +1994,8 @@ void soundTimerOverflow(int timer)
 
 void process_sound_tick_fn (int ticks)
 {
+	sound_events_render();
+
 	// Run sound hardware to present
 	pcm[0].pcm.last_time -= ticks;
 	if ( pcm[0].pcm.last_time < -2048 )
@@ -1968,6 +2025,7 @@ void sound_flush()
 {
 	// dump all the samples available
 	// VBA will only ever store 1 frame worth of samples
+	sound_events_render();
 	int numSamples = stereo_buffer_read_samples( (int16_t*) soundFinalWave, stereo_buffer_samples_avail());
 	systemOnWriteDataToSoundBuffer(soundFinalWave, numSamples);
 }
@@ -1991,6 +2049,8 @@ static void remake_stereo_buffer (void)
 	if ( !ioMem )
 		return;
 
+	sound_events_render();
+
 	// Clears pointers kept to old stereo_buffer
 	gba_pcm_init();
 
@@ -2124,6 +2184,7 @@ static variable_desc gba_state [] =
 
 void soundSaveGameMem(uint8_t *& data)
 {
+	sound_events_render();
 	gb_apu_save_state(&state.apu);
 	memset(dummy_state, 0, sizeof dummy_state);
 	utilWriteDataMem(data, gba_state);
@@ -2131,6 +2192,8 @@ void soundSaveGameMem(uint8_t *& data)
 
 void soundReadGameMem(const uint8_t *& in_data, int)
 {
+	sound_events_render();
+
 	// Prepare APU and default state
 
 	//Begin of Reset APU
@@ -642,6 +642,11 @@ bool GenesisEngine::setOption(const char *name, const char *value)
 		mEnableFM = getBoolFromString(value);
 		config.ym2413_enabled = (mEnableFM) ? 1 : 0;
 	}
+	else if(!strcasecmp(name, PLUGINOPT_GENESIS_Z80_IDLE_SKIP))
+	{
+		config.z80_idle_skip = (getBoolFromString(value)) ? 1 : 0;
+		return true;
+	}
 	return false;
 }
 
@@ -704,6 +709,7 @@ void GenesisEngine::configDefaults()
 //	config.vdp_mode       = 0; /* AUTO */
 //	config.master_clock   = 0; /* AUTO */
 	config.force_dtack    = 0;
+	config.z80_idle_skip  = 1;
 	config.addr_error     = 1;
 //	config.bios           = 0;
 	config.lock_on        = 0;
@@ -37,6 +37,7 @@ typedef struct
   float rolloff;
   uint8 region_detect;
   uint8 force_dtack;
+  uint8 z80_idle_skip;
   uint8 addr_error;
   uint8 tmss;
   uint8 lock_on;
@@ -206,6 +206,19 @@ unsigned int fm_read(unsigned int cycles, unsigned int address)
   return YM2612Read();
 }
 
+/* Last M-cycle until which FM status reads return the current value (YM2612 only) */
+unsigned int fm_status_deadline(void)
+{
+  unsigned int samples = YM2612TimerSamples();
+  if (!samples)
+  {
+    return 0xFFFFFFFF;
+  }
+
+  /* the flag is raised by the sample that brings the timer to zero */
+  return fm_cycles_count + (samples - 1) * fm_cycles_ratio;
+}
+
 /* Write PSG chip */
 void psg_write(unsigned int cycles, unsigned int data)
 {
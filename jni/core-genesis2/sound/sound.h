@@ -33,6 +33,7 @@ extern int sound_update(unsigned int cycles);
 extern void fm_reset(unsigned int cycles);
 extern void fm_write(unsigned int cycles, unsigned int address, unsigned int data);
 extern unsigned int fm_read(unsigned int cycles, unsigned int address);
+extern unsigned int fm_status_deadline(void);
 extern void psg_write(unsigned int cycles, unsigned int data);
 
 #endif /* _SOUND_H_ */
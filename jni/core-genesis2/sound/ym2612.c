@@ -1981,6 +1981,30 @@ unsigned int YM2612Read(void)
   return ym2612.OPN.ST.status & 0xff;
 }
 
+/* Number of samples before a timer overflow sets a status flag (0 if none can) */
+unsigned int YM2612TimerSamples(void)
+{
+  unsigned int samples = 0;
+
+  /* timer A running, flag enabled and not already set */
+  if (((ym2612.OPN.ST.mode & 0x05) == 0x05) && !(ym2612.OPN.ST.status & 0x01))
+  {
+    samples = (ym2612.OPN.ST.TAC > 0) ? ym2612.OPN.ST.TAC : 1;
+  }
+
+  /* timer B running, flag enabled and not already set */
+  if (((ym2612.OPN.ST.mode & 0x0A) == 0x0A) && !(ym2612.OPN.ST.status & 0x02))
+  {
+    unsigned int count = (ym2612.OPN.ST.TBC > 0) ? ym2612.OPN.ST.TBC : 1;
+    if (!samples || (count < samples))
+    {
+      samples = count;
+    }
+  }
+
+  return samples;
+}
+
 /* Generate samples for ym2612 */
 void YM2612Update(int *buffer, int length)
 {
@@ -174,8 +174,242 @@ void z80_nmi(void) {
 }
 
 extern uint32_t mcycles_z80;
+
+/* Idle loop skipping
+
+ Sound drivers spend most of their time in short loops polling Z80 RAM
+ (written by the 68k) or the YM2612 status register. Neither can change
+ while z80_run() executes, except for YM2612 timer overflows, so once a
+ loop is seen to come back to its start with every register unchanged
+ it will keep doing so until the end of the current slice. Such loops
+ are fast-forwarded by whole iterations instead of being interpreted. */
+
+#define Z80_IDLE_WINDOW 32
+
+#define IDLE_REJECT 0
+#define IDLE_STABLE 1
+#define IDLE_FM     2
+
+static struct {
+	uint16 start, end;		/* loop being verified */
+	uint16 reject_start, reject_end;	/* last loop that failed decoding */
+	int armed, rejected, fm;
+	processor regs;			/* registers at loop start */
+	uint32 mcycles;			/* cycle count at loop start */
+} z80_idle;
+
+/* Classify a memory read in Genesis mode: Z80 RAM and plain 68k memory
+ are only modified by the 68k, the YM2612 status only by timer overflow */
+static int z80_idle_source(uint16 address) {
+	if (address < 0x4000) {
+		return IDLE_STABLE;
+	}
+	if (address < 0x6000) {
+		return IDLE_FM;
+	}
+	if (address < 0x8000) {
+		return IDLE_REJECT;
+	}
+	return zbank_memory_map[(zbank | (address & 0x7FFF)) >> 16].read ? IDLE_REJECT : IDLE_STABLE;
+}
+
+/* Memory operand of the (HL), (IX+d) or (IY+d) form */
+static int z80_idle_index(uint16 base, uint8 offset) {
+	return z80_idle_source((uint16)(base + (int8)offset));
+}
+
+/* Decode the loop body and make sure it only reads memory and only
+ writes A and F. Jumps must land on an opcode of the body, so that no
+ code outside it can run. Returns IDLE_REJECT or a mask of the sources
+ read. */
+static int z80_idle_decode(uint16 start, uint16 end) {
+	uint16 pc = start;
+	int sources = IDLE_STABLE;
+	uint64 opcodes = 0, targets = 0;	/* offsets from start */
+
+	/* code must not straddle Z80 RAM and the 68k bank, nor live in I/O space */
+	if (z80_idle_source(start) != IDLE_STABLE || z80_idle_source(end + 3) != IDLE_STABLE
+	    || ((start ^ (uint16)(end + 3)) & 0x8000)) {
+		return IDLE_REJECT;
+	}
+
+	while ((uint16)(pc - start) <= (uint16)(end - start)) {
+		uint8 op = z80_readmem(pc);
+		uint8 op1 = z80_readmem((uint16)(pc + 1));
+		uint8 op2 = z80_readmem((uint16)(pc + 2));
+		int source = IDLE_STABLE;
+		int length = 1;
+		int target = -1;
+
+		switch (op) {
+		case 0x00: /* NOP */
+		case 0x76: /* HALT */
+		case 0x07: case 0x0F: case 0x17: case 0x1F: /* RLCA RRCA RLA RRA */
+		case 0x2F: case 0x37: case 0x3F: /* CPL SCF CCF */
+			break;
+		case 0x0A: /* LD A,(BC) */
+			source = z80_idle_source(BC);
+			break;
+		case 0x1A: /* LD A,(DE) */
+			source = z80_idle_source(DE);
+			break;
+		case 0x3A: /* LD A,(nn) */
+			source = z80_idle_source(op1 | (op2 << 8));
+			length = 3;
+			break;
+		case 0xC6: case 0xCE: case 0xD6: case 0xDE: /* ALU A,n */
+		case 0xE6: case 0xEE: case 0xF6: case 0xFE:
+			length = 2;
+			break;
+		case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: /* JR */
+			target = (uint16)(pc + 2 + (int8)op1);
+			length = 2;
+			break;
+		case 0xC2: case 0xC3: case 0xCA: case 0xD2: /* JP */
+		case 0xDA: case 0xE2: case 0xEA: case 0xF2: case 0xFA:
+			target = op1 | (op2 << 8);
+			length = 3;
+			break;
+		case 0xCB: /* BIT b,r / BIT b,(HL) */
+			if ((op1 & 0xC0) != 0x40) {
+				return IDLE_REJECT;
+			}
+			if ((op1 & 7) == 6) {
+				source = z80_idle_source(HL);
+			}
+			length = 2;
+			break;
+		case 0xDD: /* LD A,(IX+d), ALU (IX+d), BIT b,(IX+d) */
+		case 0xFD:
+		{
+			uint16 base = (op == 0xDD) ? IX : IY;
+			if (op1 == 0x7E || (op1 >= 0x80 && op1 < 0xC0 && (op1 & 7) == 6)) {
+				length = 3;
+			} else if (op1 == 0xCB && (z80_readmem((uint16)(pc + 3)) & 0xC0) == 0x40) {
+				length = 4;
+			} else {
+				return IDLE_REJECT;
+			}
+			source = z80_idle_index(base, op2);
+			break;
+		}
+		default:
+			if (op >= 0x78 && op < 0x80) { /* LD A,r / LD A,(HL) */
+				if (op == 0x7E) {
+					source = z80_idle_source(HL);
+				}
+			} else if (op >= 0x80 && op < 0xC0) { /* ALU A,r / ALU A,(HL) */
+				if ((op & 7) == 6) {
+					source = z80_idle_source(HL);
+				}
+			} else {
+				return IDLE_REJECT;
+			}
+			break;
+		}
+
+		if (source == IDLE_REJECT) {
+			return IDLE_REJECT;
+		}
+		if (target >= 0) {
+			if ((uint16)(target - start) > (uint16)(end - start)) {
+				return IDLE_REJECT;
+			}
+			targets |= (uint64)1 << (uint16)(target - start);
+		}
+		opcodes |= (uint64)1 << (uint16)(pc - start);
+		sources |= source;
+		pc += length;
+	}
+
+	/* a jump into the middle of an opcode would run something else */
+	if (targets & ~opcodes) {
+		return IDLE_REJECT;
+	}
+
+	return sources;
+}
+
+static int z80_idle_same(const processor *a, const processor *b) {
+	return a->af.w == b->af.w && a->bc.w == b->bc.w && a->de.w == b->de.w
+	    && a->hl.w == b->hl.w && a->ix.w == b->ix.w && a->iy.w == b->iy.w
+	    && a->sp.w == b->sp.w && a->pc.w == b->pc.w && a->iff1 == b->iff1
+	    && a->halted == b->halted;
+}
+
+/* Called after an opcode at 'end' sent PC back to (or stayed at) the
+ start of a short loop */
+static void z80_idle_check(uint16 end, unsigned int cycles) {
+	uint16 start = PC;
+
+	if (z80_idle.armed && z80_idle.start == start && z80_idle.end == end
+	    && z80_idle_same(&z80_idle.regs, &z80)) {
+		uint32 iteration = mcycles_z80 - z80_idle.mcycles;
+		uint16 refresh = R - z80_idle.regs.r;
+		unsigned int target = cycles;
+
+		/* a pending interrupt would leave the loop at the next opcode */
+		if ((z80_int_line & 7) && IFF1) {
+			z80_idle.armed = 0;
+			return;
+		}
+
+		if (z80_idle.fm) {
+			unsigned int deadline = fm_status_deadline();
+			if (deadline < target) {
+				target = deadline;
+			}
+		}
+
+		if (iteration && target > mcycles_z80) {
+			uint32 count = (target - mcycles_z80) / iteration;
+			mcycles_z80 += count * iteration;
+			R += count * refresh;
+		}
+
+		z80_idle.regs.r = R;
+		z80_idle.mcycles = mcycles_z80;
+		return;
+	}
+
+	if (z80_idle.rejected && z80_idle.reject_start == start && z80_idle.reject_end == end) {
+		return;
+	}
+
+	int sources = z80_idle_decode(start, end);
+	if (sources == IDLE_REJECT) {
+		z80_idle.armed = 0;
+		z80_idle.rejected = 1;
+		z80_idle.reject_start = start;
+		z80_idle.reject_end = end;
+		return;
+	}
+
+	z80_idle.armed = 1;
+	z80_idle.start = start;
+	z80_idle.end = end;
+	z80_idle.fm = sources & IDLE_FM;
+	z80_idle.regs = z80;
+	z80_idle.mcycles = mcycles_z80;
+}
+
 void z80_run(unsigned int cycles) {
+	/* memory may have been changed by the 68k since the last slice */
+	z80_idle.armed = 0;
+	z80_idle.rejected = 0;
+
+	if (!config.z80_idle_skip || z80_readmem != z80_md_memory_r) {
+		while (mcycles_z80 < cycles) {
+			mcycles_z80 += z80_do_opcode() * 15;
+		}
+		return;
+	}
+
 	while (mcycles_z80 < cycles) {
+		uint16 pc = PC;
 		mcycles_z80 += z80_do_opcode() * 15;
+		if ((uint16)(pc - PC) < Z80_IDLE_WINDOW) {
+			z80_idle_check(pc, cycles);
+		}
 	}
 }
@@ -6,8 +6,9 @@ LOCAL_MODULE    := libcore-pce
 LOCAL_CFLAGS    := -O3 -Wno-write-strings -Wno-sign-compare -DANDROID_ARM -DWANT_PCE_FAST_EMU -DWANT_STEREO_SOUND -DWANT_CRC32 \
  					-DSIZEOF_DOUBLE=8 $(WARNINGS) -DMEDNAFEN_VERSION=\"0.9.26\" -DPACKAGE=\"mednafen\" -DMEDNAFEN_VERSION_NUMERIC=926 -DPSS_STYLE=1 \
  					-DMPC_FIXED_POINT $(CORE_DEFINE) -DSTDC_HEADERS -D__STDC_LIMIT_MACROS -D__LIBRETRO__ -DNDEBUG -D_LOW_ACCURACY_ $(SOUND_DEFINE) -DLSB_FIRST \
- 					-DFRONTEND_SUPPORTS_RGB565 -DWANT_32BPP # -UNDEBUG -DDEBUG
+ 					-DFRONTEND_SUPPORTS_RGB565 -DWANT_16BPP -DNEED_CD -DWANT_THREADING # -UNDEBUG -DDEBUG
 LOCAL_CFLAGS	+= -DLOG_TAG="\"core-pce\"" -fexceptions -fvisibility=hidden
+LOCAL_ARM_NEON := true
 
 LOCAL_SRC_FILES	+= android/pce-engine.cpp \
 				mednafen/pce_fast/huc.cpp \
@@ -41,10 +42,14 @@ LOCAL_SRC_FILES	+= android/pce-engine.cpp \
 				mednafen/md5.cpp	\
 				mednafen/trio/trio.c \
 				mednafen/trio/triostr.c \
+				mednafen/cdrom/CDUtility.cpp \
+				mednafen/cdrom/CDAccess.cpp \
+				mednafen/cdrom/CDAccess_Image.cpp \
+				mednafen/cdrom/cdromif.cpp \
+				mednafen/cdrom/scsicd.cpp \
+				mednafen/cdrom/pcecd.cpp \
 				scrc32.cpp \
 				stubs.cpp
-
-#				mednafen/cdrom/pcecd.cpp \
 				
 LOCAL_C_INCLUDES := $(LOCAL_PATH)/../engine $(LOCAL_PATH)/mednafen $(LOCAL_PATH)/mednafen/include $(LOCAL_PATH)/mednafen/intl $(LOCAL_PATH)/mednafen/hw_cpu $(LOCAL_PATH)/mednafen/hw_sound $(LOCAL_PATH)/mednafen/hw_misc $(LOCAL_PATH)/mednafen/hw_video
 LOCAL_LDLIBS    := -lz -llog
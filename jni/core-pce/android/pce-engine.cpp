@@ -2,6 +2,7 @@
 #define PCE_WIDTH 			512
 #define PCE_HEIGHT 			242
 #define PCE_MAX_PLAYERS		5
+#define PCE_MAX_FRAMESKIP	3
 #define BIT(b)				(1 << b)
 
 #include "mednafen/mednafen.h"
@@ -17,6 +18,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <zlib.h>
 
 #include "logging.h"
@@ -73,13 +75,17 @@ private:
 
 	MDFNGI *mGame;
 	MDFN_Surface *mSurface;
-	static uint32_t mScreenBuf[PCE_WIDTH * PCE_HEIGHT];
-	MDFN_PixelFormat mSavedPixFormat;
-	double mSavedSoundRate;
+	static uint16_t mScreenBuf[PCE_WIDTH * PCE_HEIGHT];
+	int mSoundRate;
+	bool mFormatChanged;
 	t_romInfo mRomInfo;
 	uint8_t mInputBuf[PCE_MAX_PLAYERS][2];
 	uint32 mSramCRC;
 	bool mNvmDirty;
+	MDFN_Rect mDisplayRect;
+	bool mAutoFrameSkip;
+	bool mSkipNext;
+	int mFramesSkipped;
 };
 
 namespace PCE_Fast
@@ -93,7 +99,7 @@ extern bool IsBRAMUsed(void);
 }
 
 bool mEmulate6ButtonPad = false;
-uint32_t PCEEngine::mScreenBuf[PCE_WIDTH * PCE_HEIGHT];
+uint16_t PCEEngine::mScreenBuf[PCE_WIDTH * PCE_HEIGHT];
 std::string retro_base_directory;
 std::string retro_base_name;
 
@@ -103,6 +109,12 @@ PCEEngine::PCEEngine()
 	memset(mScreenBuf, 0, sizeof(mScreenBuf));
 	mEmulate6ButtonPad = false;
 	mNvmDirty = false;
+	memset(&mDisplayRect, 0, sizeof(mDisplayRect));
+	mAutoFrameSkip = false;
+	mSkipNext = false;
+	mFramesSkipped = 0;
+	mSoundRate = PCE_SOUND_RATE;
+	mFormatChanged = false;
 }
 
 PCEEngine::~PCEEngine()
@@ -110,6 +122,13 @@ PCEEngine::~PCEEngine()
 
 }
 
+static uint64_t getTicksUs()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
 void PCEEngine::setBasename(const char *path)
 {
    const char *base = strrchr(path, '/');
@@ -198,9 +217,8 @@ t_romInfo *PCEEngine::loadRomFile(const char *file, t_systemRegion systemRegion)
 		return NULL;
 	}
 
-	mSavedSoundRate = 0.0;
-	memset(&mSavedPixFormat, 0, sizeof(mSavedPixFormat));
-	MDFN_PixelFormat pix(MDFN_COLORSPACE_RGB, 16, 8, 0, 24);
+	// RGB565; the alpha shift only places the SuperGrafx priority bits above the colour
+	MDFN_PixelFormat pix(MDFN_COLORSPACE_RGB, 11, 5, 0, 16);
 	mSurface = new MDFN_Surface(mScreenBuf, PCE_WIDTH, PCE_HEIGHT, PCE_WIDTH, pix);
 /*
     setting_pce_keepaspect = 0;
@@ -213,9 +231,13 @@ t_romInfo *PCEEngine::loadRomFile(const char *file, t_systemRegion systemRegion)
 
 	mRomInfo.fps = 59.82610545348264;
 	mRomInfo.aspectRatio = 4.0 / 3.0;
-	mRomInfo.soundRate = PCE_SOUND_RATE;
+	mRomInfo.soundRate = mSoundRate;
 	mRomInfo.soundMaxBytesPerFrame = ((mRomInfo.soundRate / 50) + 1) * 2 * sizeof(short);
 
+	// The core picks up the surface format and sound rate on the first frame.
+	// Neither changes until the next load.
+	mFormatChanged = true;
+
 	return &mRomInfo;
 }
 
@@ -225,7 +247,7 @@ void PCEEngine::unloadRom()
 		return;
 
 	MDFN_FlushGameCheats(1);
-	mGame->CloseGame();
+	MDFNI_CloseGame();
 	if (mGame->name)
 	{
 		free(mGame->name);
@@ -445,71 +467,63 @@ void PCEEngine::runFrame(cEmuBitmap *curBitmap, t_emuInputState ctrlState, short
     mInputBuf[1][0] = (stateP2 >> 0) & 0xff;
     mInputBuf[1][1] = (stateP2 >> 8) & 0xff;
 
-	static int16_t soundBuf[0x10000];
 	static MDFN_Rect rects[PCE_HEIGHT];
 	rects[0].w = ~0;
 
 	EmulateSpecStruct spec = {0};
 	spec.surface = mSurface;
-	spec.SoundRate = PCE_SOUND_RATE;
-	spec.SoundBuf = soundBuf;
+	spec.SoundRate = mRomInfo.soundRate;
+	// Samples are interleaved by the core straight into the host buffer
+	spec.SoundBuf = soundBuffer;
 	spec.LineWidths = rects;
-	spec.SoundBufMaxSize = sizeof(soundBuf) / 2;
+	spec.SoundBufMaxSize = mRomInfo.soundMaxBytesPerFrame / (2 * sizeof(short));
 	spec.SoundVolume = 1.0;
 	spec.soundmultiplier = 1.0;
 	spec.SoundBufSize = 0;
-	spec.VideoFormatChanged = false;
-	spec.SoundFormatChanged = false;
+	spec.VideoFormatChanged = mFormatChanged;
+	spec.SoundFormatChanged = mFormatChanged;
+	mFormatChanged = false;
 
-	if (memcmp(&mSavedPixFormat, &spec.surface->format, sizeof(MDFN_PixelFormat)))
-	{
-		LOGI("VideoFormatChanged");
-		spec.VideoFormatChanged = TRUE;
-		mSavedPixFormat = spec.surface->format;
-	}
+	// No bitmap means the frame is not shown. In automatic mode a frame is
+	// also left undrawn after one that overran its time budget, but never
+	// more than PCE_MAX_FRAMESKIP in a row. The VDC still evaluates sprites
+	// when the game relies on sprite IRQs.
+	spec.skip = (curBitmap == NULL);
+	if(mAutoFrameSkip && mSkipNext && mFramesSkipped < PCE_MAX_FRAMESKIP)
+		spec.skip = true;
+
+	uint64_t startTicks = mAutoFrameSkip ? getTicksUs() : 0;
+
+	mGame->Emulate(&spec);
 
-	if (spec.SoundRate != mSavedSoundRate)
+	if(mAutoFrameSkip)
 	{
-		LOGI("SoundFormatChanged: %f -> %f\n", mSavedSoundRate, spec.SoundRate);
-		spec.SoundFormatChanged = true;
-		mSavedSoundRate = spec.SoundRate;
+		mSkipNext = (getTicksUs() - startTicks) > (uint64_t)(1000000.0 / mRomInfo.fps);
+		mFramesSkipped = spec.skip ? mFramesSkipped + 1 : 0;
 	}
 
-	mGame->Emulate(&spec);
+	// Skipped frames leave the surface and DisplayRect untouched, so an
+	// automatically skipped frame hands back the last one drawn
+	if(!spec.skip)
+		mDisplayRect = spec.DisplayRect;
 
     if(curBitmap)
     {
-#define BUILD_PIXEL_RGB565(R,G,B) (((int) ((R)&0x1f) << 11) | ((int) ((G)&0x3f) << 5) | (int) ((B)&0x1f))
-    	const uint32_t *src32 = mSurface->pixels;
+    	// The VCE palette cache already holds RGB565, so lines are copied as is
+    	const uint16_t *src16 = mSurface->pixels16;
     	uint16_t *dst16 = (uint16_t *)curBitmap->getBuffer();
-		unsigned width  = spec.DisplayRect.w;
-		unsigned height = spec.DisplayRect.h;
+		unsigned width  = mDisplayRect.w;
+		unsigned height = mDisplayRect.h;
 
 //		LOGI("frame dim: %d, %d\n", width, height);
 		curBitmap->setDimensions(width, height);
 		for(int y = 0; y < height; y++)
-			for(int x = 0; x < width; x++)
-			{
-				uint32_t pixel = src32[(y * PCE_WIDTH) + x];
-				int r = (pixel >> 16) & 0xff;
-				int g = (pixel >> 8) & 0xff;
-				int b = (pixel >> 0) & 0xff;
-				dst16[(y * PCE_WIDTH) + x] = BUILD_PIXEL_RGB565(r >> 3, g >> 2, b >> 3);
-			}
+			memcpy(&dst16[y * PCE_WIDTH], &src16[y * PCE_WIDTH], width * sizeof(uint16_t));
 
     }
 
     if(soundBuffer)
-    {
-    	if((spec.SoundBufSize * 2 * sizeof(short)) > mRomInfo.soundMaxBytesPerFrame)
-    	{
-    		LOGE("too many sound samples: %d > %d\n", spec.SoundBufSize * 2 * sizeof(short), mRomInfo.soundMaxBytesPerFrame);
-    		*soundSampleByteCount = 0;
-    		return;
-    	}
-    	memcpy(soundBuffer, spec.SoundBuf, spec.SoundBufSize * 2 * sizeof(short));
     	*soundSampleByteCount = spec.SoundBufSize * 2 * sizeof(short);
-    }
 
 #if 0
 	// sound output verification
@@ -543,6 +557,23 @@ bool PCEEngine::setOption(const char *name, const char *value)
 	{
 		mEmulate6ButtonPad = getBoolFromString(value);
 	}
+	else if(!strcasecmp(name, PLUGINOPT_PCE_AUTO_FRAMESKIP))
+	{
+		mAutoFrameSkip = getBoolFromString(value);
+		mSkipNext = false;
+		mFramesSkipped = 0;
+	}
+	else if(!strcasecmp(name, PLUGINOPT_PCE_LOAD_SOUND_RATE))
+	{
+		// Load-time only: the host sizes its sound buffer and sink from
+		// mRomInfo, so the new rate takes effect with the next loadRomFile()
+		int rate = atoi(value);
+		if(rate > 0 && rate != mSoundRate)
+		{
+			LOGI("sound rate: %d -> %d (next load)\n", mSoundRate, rate);
+			mSoundRate = rate;
+		}
+	}
 	return false;
 }
 
@@ -0,0 +1,28 @@
+#ifndef __MDFN_CDROM_CDACCESS_H
+#define __MDFN_CDROM_CDACCESS_H
+
+#include "CDUtility.h"
+
+class CDAccess
+{
+ public:
+
+ CDAccess();
+ virtual ~CDAccess();
+
+ // Fills buf with the 2352 bytes of the sector at lba: data sectors with their sync pattern
+ // and header, audio sectors as little-endian 16-bit stereo samples.  Throws MDFN_Error on an
+ // I/O error.
+ virtual void Read_Raw_Sector(uint8 *buf, int32 lba) = 0;
+
+ virtual void Read_TOC(CDUtility::TOC *toc) = 0;
+
+ private:
+ CDAccess(const CDAccess&);	// No copy constructor.
+ CDAccess& operator=(const CDAccess&); // No assignment operator.
+};
+
+// Opens a CUE sheet or a bare ISO image.  Throws MDFN_Error on failure.
+CDAccess *cdaccess_open(const char *path, bool image_memcache);
+
+#endif
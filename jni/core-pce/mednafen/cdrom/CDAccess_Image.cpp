@@ -0,0 +1,501 @@
+/* Mednafen - Multi-system Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ Sector data is read straight from the image files on each call; CDIF caches and reads
+ ahead, so this code only runs on its read thread.
+
+ Audio in WAVE files has to be 16-bit stereo PCM at 44100Hz, there's no resampling
+ or decompression.
+*/
+
+#include "../mednafen.h"
+#include "../general.h"
+#include "../FileWrapper.h"
+#include "../FileStream.h"
+#include "../MemoryStream.h"
+#include "CDAccess_Image.h"
+
+#include <string.h>
+#include <limits.h>
+#include <ctype.h>
+
+using namespace CDUtility;
+
+enum
+{
+ DI_FORMAT_AUDIO       = 0x00,
+ DI_FORMAT_MODE1       = 0x01,
+ DI_FORMAT_MODE1_RAW   = 0x02,
+ DI_FORMAT_MODE2       = 0x03,
+ DI_FORMAT_MODE2_RAW   = 0x04,
+ _DI_FORMAT_COUNT
+};
+
+static const int32 DI_Size_Table[_DI_FORMAT_COUNT] =
+{
+ 2352, // Audio
+ 2048, // MODE1
+ 2352, // MODE1 RAW
+ 2336, // MODE2
+ 2352, // MODE2 RAW
+};
+
+static const char *DI_CUE_Strings[_DI_FORMAT_COUNT] = 
+{
+ "AUDIO",
+ "MODE1/2048",
+ "MODE1/2352",
+ "MODE2/2336",
+ "MODE2/2352",
+};
+
+// Splits a CUE sheet line into its whitespace separated arguments; double quotes group.
+static void TokenizeLine(const char *line, std::vector<std::string> &args)
+{
+ args.clear();
+
+ while(*line)
+ {
+  std::string arg;
+
+  while(*line == ' ' || *line == '\t')
+   line++;
+
+  if(!*line)
+   break;
+
+  if(*line == '"')
+  {
+   line++;
+   while(*line && *line != '"')
+    arg += *line++;
+
+   if(*line)
+    line++;
+  }
+  else
+  {
+   while(*line && *line != ' ' && *line != '\t')
+    arg += *line++;
+  }
+
+  args.push_back(arg);
+ }
+}
+
+// "mm:ss:ff" to a frame count.
+static int32 ParseMSF(const std::string &arg)
+{
+ unsigned int m, s, f;
+
+ if(sscanf(arg.c_str(), "%u:%u:%u", &m, &s, &f) != 3 || s >= 60 || f >= 75)
+  throw(MDFN_Error(0, _("Malformed m:s:f time in CUE sheet: \"%s\""), arg.c_str()));
+
+ return(AMSF_to_ABA(m, s, f));
+}
+
+// Finds the sample data of a RIFF WAVE file and checks it can be used as CD-DA as is.
+static void ParseWAVE(Stream *fp, int64 *data_base, int64 *data_end)
+{
+ uint8 header[12];
+ bool have_fmt = false;
+
+ if(fp->read(header, 12, false) != 12 || memcmp(header, "RIFF", 4) || memcmp(header + 8, "WAVE", 4))
+  throw(MDFN_Error(0, _("Not a RIFF WAVE file.")));
+
+ for(;;)
+ {
+  uint8 chunk[8];
+  uint32 chunk_size;
+
+  if(fp->read(chunk, 8, false) != 8)
+   throw(MDFN_Error(0, _("WAVE file has no \"data\" chunk.")));
+
+  chunk_size = MDFN_de32lsb(chunk + 4);
+
+  if(!memcmp(chunk, "fmt ", 4))
+  {
+   uint8 fmt[16];
+
+   if(chunk_size < 16)
+    throw(MDFN_Error(0, _("WAVE file \"fmt \" chunk is too short.")));
+
+   fp->read(fmt, 16);
+
+   if(MDFN_de16lsb(fmt + 0) != 1 || MDFN_de16lsb(fmt + 2) != 2 || MDFN_de32lsb(fmt + 4) != 44100 || MDFN_de16lsb(fmt + 14) != 16)
+    throw(MDFN_Error(0, _("WAVE audio must be 16-bit stereo PCM at 44100Hz.")));
+
+   fp->seek(((chunk_size + 1) & ~1) - 16, SEEK_CUR);
+   have_fmt = true;
+  }
+  else if(!memcmp(chunk, "data", 4))
+  {
+   if(!have_fmt)
+    throw(MDFN_Error(0, _("WAVE file \"data\" chunk comes before its \"fmt \" chunk.")));
+
+   *data_base = fp->tell();
+   *data_end = *data_base + chunk_size;
+
+   if(*data_end > fp->size())
+    *data_end = fp->size();
+   return;
+  }
+  else
+   fp->seek((chunk_size + 1) & ~1, SEEK_CUR);
+ }
+}
+
+Stream *CDAccess_Image::OpenFile(const std::string &path, bool image_memcache)
+{
+ Stream *fp = new FileStream(path.c_str(), FileStream::MODE_READ);
+
+ if(image_memcache)
+  fp = new MemoryStream(fp);
+
+ Files.push_back(fp);
+
+ return(fp);
+}
+
+void CDAccess_Image::LoadISO(const char *path, bool image_memcache)
+{
+ CDRFILE_TRACK_INFO *t = &Tracks[1];
+
+ memset(t, 0, sizeof(CDRFILE_TRACK_INFO));
+
+ t->fp = OpenFile(path, image_memcache);
+ t->DIFormat = DI_FORMAT_MODE1;
+ t->subq_control = SUBQ_CTRLF_DATA;
+ t->index[0] = -1;
+ t->index[1] = 0;
+ t->FirstFileInstance = true;
+ t->FileBase = 0;
+ t->FileEnd = t->fp->size();
+
+ FirstTrack = LastTrack = 1;
+}
+
+void CDAccess_Image::LoadCUE(const char *path, bool image_memcache)
+{
+ FileWrapper cue_file(path, FileWrapper::MODE_READ, _("CUE sheet"));
+ std::string base_dir;
+ std::vector<std::string> args;
+ char linebuf[2048];
+ CDRFILE_TRACK_INFO TmpTrack;
+ int32 CurTrack = 0;
+ Stream *file_fp = NULL;	// Set by FILE, taken over by the TRACK directives that follow.
+ int64 file_base = 0, file_end = 0;
+ bool file_msb = false;
+ bool new_file = false;
+
+ MDFN_GetFilePathComponents(path, &base_dir);
+
+ memset(&TmpTrack, 0, sizeof(TmpTrack));
+
+ while(cue_file.get_line(linebuf, sizeof(linebuf)))
+ {
+  std::string cmdbuf;
+
+  MDFN_trim(linebuf);
+  TokenizeLine(linebuf, args);
+
+  if(args.empty())
+   continue;
+
+  cmdbuf = args[0];
+  for(unsigned i = 0; i < cmdbuf.size(); i++)
+   cmdbuf[i] = toupper(cmdbuf[i]);
+
+  if(cmdbuf == "FILE")
+  {
+   std::string file_type = (args.size() >= 3) ? args[2] : std::string("BINARY");
+
+   if(args.size() < 2)
+    throw(MDFN_Error(0, _("Malformed FILE directive in CUE sheet.")));
+
+   for(unsigned i = 0; i < file_type.size(); i++)
+    file_type[i] = toupper(file_type[i]);
+
+   file_fp = OpenFile(MDFN_EvalFIP(base_dir, args[1]), image_memcache);
+   file_msb = false;
+   file_base = 0;
+   file_end = file_fp->size();
+
+   if(file_type == "WAVE")
+    ParseWAVE(file_fp, &file_base, &file_end);
+   else if(file_type == "MOTOROLA")
+    file_msb = true;
+   else if(file_type != "BINARY")
+    throw(MDFN_Error(0, _("Unsupported CUE sheet file type \"%s\"."), file_type.c_str()));
+
+   new_file = true;
+  }
+  else if(cmdbuf == "TRACK")
+  {
+   int32 track_num;
+   unsigned format;
+
+   if(args.size() < 3)
+    throw(MDFN_Error(0, _("Malformed TRACK directive in CUE sheet.")));
+
+   if(!file_fp)
+    throw(MDFN_Error(0, _("TRACK directive before any FILE directive in CUE sheet.")));
+
+   track_num = atoi(args[1].c_str());
+
+   if(track_num < 1 || track_num > 99 || (CurTrack && track_num != CurTrack + 1))
+    throw(MDFN_Error(0, _("Invalid track number %d in CUE sheet."), track_num));
+
+   for(format = 0; format < _DI_FORMAT_COUNT; format++)
+    if(!strcasecmp(args[2].c_str(), DI_CUE_Strings[format]))
+     break;
+
+   if(format == _DI_FORMAT_COUNT)
+    throw(MDFN_Error(0, _("Unsupported track format \"%s\" in CUE sheet."), args[2].c_str()));
+
+   if(CurTrack)
+    Tracks[CurTrack] = TmpTrack;
+   else
+    FirstTrack = track_num;
+
+   CurTrack = track_num;
+
+   TmpTrack.fp = file_fp;
+   TmpTrack.RawAudioMSBFirst = file_msb;
+   TmpTrack.FileBase = file_base;
+   TmpTrack.FileEnd = file_end;
+   TmpTrack.DIFormat = format;
+   TmpTrack.subq_control = (format == DI_FORMAT_AUDIO) ? 0 : SUBQ_CTRLF_DATA;
+   TmpTrack.pregap = 0;
+   TmpTrack.postgap = 0;
+   TmpTrack.index[0] = -1;
+   TmpTrack.index[1] = -1;
+   TmpTrack.FirstFileInstance = new_file;
+   new_file = false;
+  }
+  else if(cmdbuf == "INDEX" || cmdbuf == "PREGAP" || cmdbuf == "POSTGAP" || cmdbuf == "FLAGS")
+  {
+   if(!CurTrack)
+    throw(MDFN_Error(0, _("%s directive outside of a track in CUE sheet."), cmdbuf.c_str()));
+
+   if(cmdbuf == "INDEX")
+   {
+    int index_num = (args.size() >= 3) ? atoi(args[1].c_str()) : -1;
+
+    if(index_num < 0)
+     throw(MDFN_Error(0, _("Malformed INDEX directive in CUE sheet.")));
+
+    if(index_num <= 1)
+     TmpTrack.index[index_num] = ParseMSF(args[2]);
+   }
+   else if(cmdbuf == "PREGAP" || cmdbuf == "POSTGAP")
+   {
+    if(args.size() < 2)
+     throw(MDFN_Error(0, _("Malformed %s directive in CUE sheet."), cmdbuf.c_str()));
+
+    if(cmdbuf == "PREGAP")
+     TmpTrack.pregap = ParseMSF(args[1]);
+    else
+     TmpTrack.postgap = ParseMSF(args[1]);
+   }
+   else
+   {
+    for(unsigned i = 1; i < args.size(); i++)
+    {
+     if(!strcasecmp(args[i].c_str(), "DCP"))
+      TmpTrack.subq_control |= SUBQ_CTRLF_DCP;
+     else if(!strcasecmp(args[i].c_str(), "4CH"))
+      TmpTrack.subq_control |= SUBQ_CTRLF_4CH;
+     else if(!strcasecmp(args[i].c_str(), "PRE"))
+      TmpTrack.subq_control |= SUBQ_CTRLF_PRE;
+    }
+   }
+  }
+  // REM, CATALOG, TITLE, PERFORMER, SONGWRITER, ISRC, CDTEXTFILE etc. don't affect the layout.
+ }
+
+ if(!CurTrack)
+  throw(MDFN_Error(0, _("No tracks found in CUE sheet.")));
+
+ Tracks[CurTrack] = TmpTrack;
+ LastTrack = CurTrack;
+
+ for(int32 x = FirstTrack; x <= LastTrack; x++)
+ {
+  if(Tracks[x].index[1] == -1)
+   throw(MDFN_Error(0, _("Track %d has no INDEX 01 in CUE sheet."), x));
+ }
+}
+
+// Places the tracks on the disc.  Each file holds consecutive tracks, with any INDEX 00
+// pregap stored in front of INDEX 01; PREGAP and POSTGAP sectors aren't in the files.
+void CDAccess_Image::CalcLayout(void)
+{
+ int32 RunningLBA = 0;
+ int64 FileOffset = 0;
+
+ for(int32 x = FirstTrack; x <= LastTrack; x++)
+ {
+  CDRFILE_TRACK_INFO *t = &Tracks[x];
+  const int32 size = DI_Size_Table[t->DIFormat];
+  int64 sectors;
+
+  if(t->FirstFileInstance)
+   FileOffset = t->FileBase + (int64)((t->index[0] != -1) ? t->index[0] : t->index[1]) * size;
+
+  RunningLBA += t->pregap;
+
+  t->pregap_dv = (t->index[0] != -1) ? (t->index[1] - t->index[0]) : 0;
+
+  if(t->pregap_dv < 0)
+   throw(MDFN_Error(0, _("Track %d INDEX 00 comes after its INDEX 01."), x));
+
+  FileOffset += (int64)t->pregap_dv * size;
+  RunningLBA += t->pregap_dv;
+
+  t->LBA = RunningLBA;
+  t->FileOffset = FileOffset;
+
+  if(x < LastTrack && !Tracks[x + 1].FirstFileInstance)
+   sectors = ((Tracks[x + 1].index[0] != -1) ? Tracks[x + 1].index[0] : Tracks[x + 1].index[1]) - t->index[1];
+  else
+   sectors = (t->FileEnd - FileOffset) / size;
+
+  if(sectors <= 0 || sectors > INT_MAX)
+   throw(MDFN_Error(0, _("Track %d has no sectors in its file."), x));
+
+  t->sectors = sectors;
+
+  RunningLBA += t->sectors + t->postgap;
+  FileOffset += (int64)t->sectors * size;
+ }
+
+ total_sectors = RunningLBA;
+}
+
+void CDAccess_Image::ImageOpen(const char *path, bool image_memcache)
+{
+ const char *ext = strrchr(path, '.');
+
+ memset(Tracks, 0, sizeof(Tracks));
+
+ if(ext && !strcasecmp(ext, ".cue"))
+  LoadCUE(path, image_memcache);
+ else if(ext && !strcasecmp(ext, ".iso"))
+  LoadISO(path, image_memcache);
+ else
+  throw(MDFN_Error(0, _("Unsupported CD image format: \"%s\""), path));
+
+ CalcLayout();
+}
+
+void CDAccess_Image::Cleanup(void)
+{
+ for(unsigned i = 0; i < Files.size(); i++)
+  delete Files[i];
+
+ Files.clear();
+}
+
+CDAccess_Image::CDAccess_Image(const char *path, bool image_memcache) : FirstTrack(0), LastTrack(0), total_sectors(0)
+{
+ try
+ {
+  ImageOpen(path, image_memcache);
+ }
+ catch(...)
+ {
+  Cleanup();
+  throw;
+ }
+}
+
+CDAccess_Image::~CDAccess_Image()
+{
+ Cleanup();
+}
+
+void CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
+{
+ memset(buf, 0, 2352);
+
+ for(int32 track = FirstTrack; track <= LastTrack; track++)
+ {
+  CDRFILE_TRACK_INFO *ct = &Tracks[track];
+
+  if(lba < (ct->LBA - ct->pregap_dv - ct->pregap) || lba >= (ct->LBA + ct->sectors + ct->postgap))
+   continue;
+
+  if(lba < (ct->LBA - ct->pregap_dv) || lba >= (ct->LBA + ct->sectors))
+  {
+   // Gap sectors that aren't in the image: silence, or empty data sectors.
+   if(ct->DIFormat != DI_FORMAT_AUDIO)
+    encode_sector_header(buf, lba, (ct->DIFormat >= DI_FORMAT_MODE2) ? 2 : 1);
+   return;
+  }
+
+  ct->fp->seek(ct->FileOffset + (int64)(lba - ct->LBA) * DI_Size_Table[ct->DIFormat], SEEK_SET);
+
+  switch(ct->DIFormat)
+  {
+   case DI_FORMAT_AUDIO:
+	ct->fp->read(buf, 2352);
+
+	if(ct->RawAudioMSBFirst)
+	 Endian_A16_Swap(buf, 588 * 2);
+	break;
+
+   case DI_FORMAT_MODE1:
+	ct->fp->read(buf + 16, 2048);
+	encode_sector_header(buf, lba, 1);
+	break;
+
+   case DI_FORMAT_MODE2:
+	ct->fp->read(buf + 16, 2336);
+	encode_sector_header(buf, lba, 2);
+	break;
+
+   case DI_FORMAT_MODE1_RAW:
+   case DI_FORMAT_MODE2_RAW:
+	ct->fp->read(buf, 2352);
+	break;
+  }
+  return;
+ }
+
+ // Lead-in and lead-out read back as empty.
+}
+
+void CDAccess_Image::Read_TOC(TOC *toc)
+{
+ toc->Clear();
+
+ toc->first_track = FirstTrack;
+ toc->last_track = LastTrack;
+
+ for(int32 i = FirstTrack; i <= LastTrack; i++)
+ {
+  toc->tracks[i].adr = ADR_CURPOS;
+  toc->tracks[i].control = Tracks[i].subq_control;
+  toc->tracks[i].lba = Tracks[i].LBA;
+ }
+
+ toc->tracks[100].adr = ADR_CURPOS;
+ toc->tracks[100].control = Tracks[LastTrack].subq_control & SUBQ_CTRLF_DATA;
+ toc->tracks[100].lba = total_sectors;
+}
@@ -0,0 +1,61 @@
+#ifndef __MDFN_CDROM_CDACCESS_IMAGE_H
+#define __MDFN_CDROM_CDACCESS_IMAGE_H
+
+#include "CDAccess.h"
+
+#include <vector>
+
+class Stream;
+
+struct CDRFILE_TRACK_INFO
+{
+ int32 LBA;
+
+ uint32 DIFormat;
+ uint8 subq_control;
+
+ int32 pregap;		// PREGAP sectors, not stored in the image.
+ int32 pregap_dv;	// INDEX 00 to INDEX 01, stored in the image.
+ int32 postgap;		// POSTGAP sectors, not stored in the image.
+
+ int32 index[2];
+
+ int32 sectors;	// Not including pregap sectors!
+ Stream *fp;
+ bool FirstFileInstance;
+ bool RawAudioMSBFirst;
+ int64 FileOffset;	// Where INDEX 01 starts in fp.
+ int64 FileBase;	// Sector data of fp lies in [FileBase, FileEnd), past any WAVE header.
+ int64 FileEnd;
+};
+
+// CUE sheets with BINARY, MOTOROLA and WAVE files, and bare ISO images.
+class CDAccess_Image : public CDAccess
+{
+ public:
+
+ CDAccess_Image(const char *path, bool image_memcache);
+ virtual ~CDAccess_Image();
+
+ virtual void Read_Raw_Sector(uint8 *buf, int32 lba);
+
+ virtual void Read_TOC(CDUtility::TOC *toc);
+
+ private:
+
+ int32 FirstTrack;
+ int32 LastTrack;
+ int32 total_sectors;
+ CDRFILE_TRACK_INFO Tracks[100]; // Track #0(HMM?) through 99
+
+ std::vector<Stream *> Files;
+
+ void ImageOpen(const char *path, bool image_memcache);
+ void LoadCUE(const char *path, bool image_memcache);
+ void LoadISO(const char *path, bool image_memcache);
+ Stream *OpenFile(const std::string &path, bool image_memcache);
+ void CalcLayout(void);
+ void Cleanup(void);
+};
+
+#endif
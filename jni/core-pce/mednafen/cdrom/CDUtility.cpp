@@ -0,0 +1,126 @@
+/* Mednafen - Multi-system Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "../mednafen.h"
+#include "CDUtility.h"
+
+#include <string.h>
+
+namespace CDUtility
+{
+
+// CRC-16/CCITT table for the Q subchannel, built by CDUtility_Init().
+static uint16 subq_crctab[256];
+static bool CDUtility_Inited = false;
+
+void CDUtility_Init(void)
+{
+ if(CDUtility_Inited)
+  return;
+
+ for(int i = 0; i < 256; i++)
+ {
+  uint16 crc = i << 8;
+
+  for(int b = 0; b < 8; b++)
+   crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+
+  subq_crctab[i] = crc;
+ }
+
+ CDUtility_Inited = true;
+}
+
+void encode_sector_header(uint8 *buf, int32 lba, uint8 mode)
+{
+ uint8 m, s, f;
+
+ buf[0] = 0x00;
+ memset(buf + 1, 0xFF, 10);
+ buf[11] = 0x00;
+
+ LBA_to_AMSF(lba, &m, &s, &f);
+
+ buf[12] = U8_to_BCD(m);
+ buf[13] = U8_to_BCD(s);
+ buf[14] = U8_to_BCD(f);
+ buf[15] = mode;
+}
+
+static uint16 subq_crc(const uint8 *subq_buf)
+{
+ uint16 crc = 0;
+
+ for(int i = 0; i < 0xA; i++)
+  crc = subq_crctab[(crc >> 8) ^ subq_buf[i]] ^ (crc << 8);
+
+ return(~crc);
+}
+
+void subq_generate(uint8 *subq_buf, const TOC &toc, int32 lba)
+{
+ int32 track = toc.first_track;
+ uint8 m, s, f;
+ int32 rel;
+
+ // Sectors before INDEX 01 of the next track still count as the previous one; the pregap
+ // of track 1 counts down to it.
+ for(int32 t = toc.last_track; t >= toc.first_track; t--)
+ {
+  if(lba >= (int32)toc.tracks[t].lba)
+  {
+   track = t;
+   break;
+  }
+ }
+
+ if(lba >= (int32)toc.tracks[100].lba)
+ {
+  subq_buf[1] = 0xAA;
+  subq_buf[2] = 0x01;
+  rel = lba - toc.tracks[100].lba;
+  subq_buf[0] = (toc.tracks[toc.last_track].control << 4) | ADR_CURPOS;
+ }
+ else
+ {
+  subq_buf[1] = U8_to_BCD(track);
+  rel = lba - (int32)toc.tracks[track].lba;
+  subq_buf[2] = (rel < 0) ? 0x00 : 0x01;
+  subq_buf[0] = (toc.tracks[track].control << 4) | ADR_CURPOS;
+ }
+
+ if(rel < 0)
+  rel = -rel;
+
+ ABA_to_AMSF(rel, &m, &s, &f);
+ subq_buf[3] = U8_to_BCD(m);
+ subq_buf[4] = U8_to_BCD(s);
+ subq_buf[5] = U8_to_BCD(f);
+
+ subq_buf[6] = 0;
+
+ LBA_to_AMSF(lba, &m, &s, &f);
+ subq_buf[7] = U8_to_BCD(m);
+ subq_buf[8] = U8_to_BCD(s);
+ subq_buf[9] = U8_to_BCD(f);
+
+ uint16 crc = subq_crc(subq_buf);
+ subq_buf[0xA] = crc >> 8;
+ subq_buf[0xB] = crc;
+}
+
+}
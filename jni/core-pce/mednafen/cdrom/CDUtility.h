@@ -0,0 +1,121 @@
+#ifndef __MDFN_CDROM_CDUTILITY_H
+#define __MDFN_CDROM_CDUTILITY_H
+
+namespace CDUtility
+{
+ // Call once at startup, before any other function in this namespace.
+ void CDUtility_Init(void);
+
+ enum
+ {
+  ADR_NOQINFO = 0x00,
+  ADR_CURPOS  = 0x01,
+  ADR_MCN     = 0x02,
+  ADR_ISRC    = 0x03
+ };
+
+ // Q subchannel control field bits, as kept in TOC_Track::control.
+ enum
+ {
+  SUBQ_CTRLF_PRE  = 0x01,	// With 50/15us pre-emphasis.
+  SUBQ_CTRLF_DCP  = 0x02,	// Digital copy permitted.
+  SUBQ_CTRLF_DATA = 0x04,	// Data track.
+  SUBQ_CTRLF_4CH  = 0x08,	// 4-channel CD-DA.
+ };
+
+ struct TOC_Track
+ {
+  uint8 adr;
+  uint8 control;
+  uint32 lba;
+ };
+
+ class TOC
+ {
+  public:
+
+  INLINE TOC()
+  {
+   Clear();
+  }
+
+  INLINE void Clear(void)
+  {
+   first_track = last_track = 0;
+   memset(tracks, 0, sizeof(tracks));
+  }
+
+  // Returns the track lba falls into, 0 when it's before the first track and 100 in the lead-out.
+  INLINE int FindTrackByLBA(uint32 LBA)
+  {
+   if(LBA >= tracks[100].lba)
+    return(100);
+
+   for(int32 track = last_track; track >= first_track; track--)
+   {
+    if(LBA >= tracks[track].lba)
+     return(track);
+   }
+
+   return(0);
+  }
+
+  uint8 first_track;
+  uint8 last_track;
+  TOC_Track tracks[100 + 1];	// [0] is unused, [100] is the lead-out.
+ };
+
+ //
+ // Address conversion.  ABA counts from the start of the 150-sector(2 second) pregap
+ // of track 1, LBA from INDEX 01 of track 1; AMSF is the minute/second/frame form of the ABA.
+ //
+ static INLINE uint32 AMSF_to_ABA(int32 m_a, int32 s_a, int32 f_a)
+ {
+  return(f_a + 75 * s_a + 75 * 60 * m_a);
+ }
+
+ static INLINE void ABA_to_AMSF(uint32 aba, uint8 *m_a, uint8 *s_a, uint8 *f_a)
+ {
+  *m_a = aba / 75 / 60;
+  *s_a = (aba - *m_a * 75 * 60) / 75;
+  *f_a = aba - (*m_a * 75 * 60) - (*s_a * 75);
+ }
+
+ static INLINE int32 ABA_to_LBA(uint32 aba)
+ {
+  return(aba - 150);
+ }
+
+ static INLINE uint32 LBA_to_ABA(int32 lba)
+ {
+  return(lba + 150);
+ }
+
+ static INLINE int32 AMSF_to_LBA(uint8 m_a, uint8 s_a, uint8 f_a)
+ {
+  return(ABA_to_LBA(AMSF_to_ABA(m_a, s_a, f_a)));
+ }
+
+ static INLINE void LBA_to_AMSF(int32 lba, uint8 *m_a, uint8 *s_a, uint8 *f_a)
+ {
+  ABA_to_AMSF(LBA_to_ABA(lba), m_a, s_a, f_a);
+ }
+
+ static INLINE uint8 U8_to_BCD(uint8 num)
+ {
+  return( ((num / 10) << 4) + (num % 10) );
+ }
+
+ static INLINE uint8 BCD_to_U8(uint8 bcd_num)
+ {
+  return( ((bcd_num >> 4) * 10) + (bcd_num & 0xF) );
+ }
+
+ // Writes the sync pattern and header of a raw mode 1 or mode 2 data sector.
+ void encode_sector_header(uint8 *buf, int32 lba, uint8 mode);
+
+ // Builds the 12-byte mode 1(current position) Q subchannel of lba, CRC included.
+ void subq_generate(uint8 *subq_buf, const TOC &toc, int32 lba);
+}
+
+#endif
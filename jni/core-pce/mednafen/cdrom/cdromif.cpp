@@ -0,0 +1,242 @@
+/* Mednafen - Multi-system Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "../mednafen.h"
+#include "cdromif.h"
+#include "CDAccess.h"
+
+#include <string.h>
+
+using namespace CDUtility;
+
+CDIF::CDIF(CDAccess *cda) : disc_cdaccess(cda)
+{
+ disc_cdaccess->Read_TOC(&disc_toc);
+
+ if(disc_toc.first_track < 1 || disc_toc.last_track > 99 || disc_toc.first_track > disc_toc.last_track)
+  throw(MDFN_Error(0, _("TOC first(%u)/last(%u) track numbers bad."), disc_toc.first_track, disc_toc.last_track));
+
+ #ifdef WANT_THREADING
+ for(unsigned i = 0; i < SBSize; i++)
+  SB[i].valid = false;
+
+ ra_lba = ra_end = 0;
+ ra_busy_lba = 0;
+ ra_busy = false;
+ ra_quit = false;
+
+ SBMutex = MDFND_CreateMutex();
+ WorkCond = MDFND_CreateCond();
+ ReadyCond = MDFND_CreateCond();
+ ReadThread = NULL;
+
+ if(SBMutex && WorkCond && ReadyCond)
+  ReadThread = MDFND_CreateThread(ReadThreadStart, this);
+
+ if(!ReadThread)
+ {
+  if(ReadyCond)
+   MDFND_DestroyCond(ReadyCond);
+  if(WorkCond)
+   MDFND_DestroyCond(WorkCond);
+  if(SBMutex)
+   MDFND_DestroyMutex(SBMutex);
+
+  throw(MDFN_Error(0, _("Error creating CD read thread.")));
+ }
+ #endif
+}
+
+CDIF::~CDIF()
+{
+ #ifdef WANT_THREADING
+ MDFND_LockMutex(SBMutex);
+ ra_quit = true;
+ MDFND_SignalCond(WorkCond);
+ MDFND_UnlockMutex(SBMutex);
+
+ MDFND_WaitThread(ReadThread, NULL);
+
+ MDFND_DestroyCond(ReadyCond);
+ MDFND_DestroyCond(WorkCond);
+ MDFND_DestroyMutex(SBMutex);
+ #endif
+
+ delete disc_cdaccess;
+}
+
+bool CDIF::ReadRawSectorDirect(uint8 *buf, uint32 lba)
+{
+ try
+ {
+  disc_cdaccess->Read_Raw_Sector(buf, lba);
+ }
+ catch(std::exception &e)
+ {
+  MDFN_PrintError(_("Sector %u read error: %s"), lba, e.what());
+  memset(buf, 0, 2352);
+  return(false);
+ }
+
+ return(true);
+}
+
+#ifdef WANT_THREADING
+int CDIF::ReadThreadStart(void *data)
+{
+ ((CDIF *)data)->ReadThreadLoop();
+ return(0);
+}
+
+void CDIF::ReadThreadLoop(void)
+{
+ MDFND_LockMutex(SBMutex);
+
+ while(!ra_quit)
+ {
+  if(ra_lba >= ra_end)
+  {
+   MDFND_WaitCond(WorkCond, SBMutex);
+   continue;
+  }
+
+  const uint32 lba = ra_lba++;
+  CacheSector *cs = &SB[lba % SBSize];
+
+  if(cs->valid && cs->lba == lba)
+   continue;
+
+  // The slot is invalid while it's filled, so nothing else looks at its data until then.
+  cs->valid = false;
+  ra_busy_lba = lba;
+  ra_busy = true;
+  MDFND_UnlockMutex(SBMutex);
+
+  const bool error = !ReadRawSectorDirect(cs->data, lba);
+
+  MDFND_LockMutex(SBMutex);
+  cs->lba = lba;
+  cs->error = error;
+  cs->valid = true;
+  ra_busy = false;
+  MDFND_SignalCond(ReadyCond);
+ }
+
+ MDFND_UnlockMutex(SBMutex);
+}
+
+// Called with SBMutex held.  Keeps the thread reading up to ReadAheadCount sectors past lba,
+// moving it there when restart is set or when it's behind lba or off somewhere else.
+void CDIF::SetReadAhead(uint32 lba, bool restart)
+{
+ uint32 end = lba + ReadAheadCount;
+
+ if(end > disc_toc.tracks[100].lba)
+  end = disc_toc.tracks[100].lba;
+
+ if(restart || ra_lba < lba || ra_lba > end)
+ {
+  ra_lba = lba;
+  ra_end = end;
+ }
+ else if(ra_end < end)
+  ra_end = end;
+
+ MDFND_SignalCond(WorkCond);
+}
+#endif
+
+bool CDIF::ReadRawSector(uint8 *buf, uint32 lba)
+{
+ if(lba >= disc_toc.tracks[100].lba)
+ {
+  memset(buf, 0, 2352);
+  return(false);
+ }
+
+ #ifdef WANT_THREADING
+ CacheSector *cs = &SB[lba % SBSize];
+ bool ret;
+
+ MDFND_LockMutex(SBMutex);
+
+ if((cs->valid && cs->lba == lba) || (ra_busy && ra_busy_lba == lba))
+  SetReadAhead(lba + 1, false);
+ else
+  SetReadAhead(lba, true);
+
+ while(!(cs->valid && cs->lba == lba))
+  MDFND_WaitCond(ReadyCond, SBMutex);
+
+ memcpy(buf, cs->data, 2352);
+ ret = !cs->error;
+
+ MDFND_UnlockMutex(SBMutex);
+
+ return(ret);
+ #else
+ return(ReadRawSectorDirect(buf, lba));
+ #endif
+}
+
+void CDIF::HintReadSector(uint32 lba)
+{
+ #ifdef WANT_THREADING
+ if(lba >= disc_toc.tracks[100].lba)
+  return;
+
+ MDFND_LockMutex(SBMutex);
+ SetReadAhead(lba, true);
+ MDFND_UnlockMutex(SBMutex);
+ #endif
+}
+
+int CDIF::ReadSector(uint8 *pBuf, uint32 lba, uint32 nSectors)
+{
+ while(nSectors--)
+ {
+  uint8 tmpbuf[2352];
+  const int track = disc_toc.FindTrackByLBA(lba);
+
+  if(track < 1 || track > 99 || !(disc_toc.tracks[track].control & SUBQ_CTRLF_DATA))
+   return(0);
+
+  if(!ReadRawSector(tmpbuf, lba))
+   return(0);
+
+  memcpy(pBuf, tmpbuf + ((tmpbuf[15] == 2) ? 24 : 16), 2048);
+  pBuf += 2048;
+  lba++;
+ }
+
+ return(1);
+}
+
+CDIF *CDIF_Open(const char *path, bool image_memcache)
+{
+ CDAccess *cda = cdaccess_open(path, image_memcache);
+
+ try
+ {
+  return new CDIF(cda);
+ }
+ catch(...)
+ {
+  delete cda;
+  throw;
+ }
+}
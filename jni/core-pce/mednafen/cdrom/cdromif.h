@@ -0,0 +1,101 @@
+/* Mednafen - Multi-system Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __MDFN_CDROM_CDROMIF_H
+#define __MDFN_CDROM_CDROMIF_H
+
+#include "CDUtility.h"
+
+typedef CDUtility::TOC CD_TOC;
+
+class CDAccess;
+
+#ifdef WANT_THREADING
+struct MDFN_Thread;
+struct MDFN_Mutex;
+struct MDFN_Cond;
+#endif
+
+// The disc as seen by the emulated drive.  With WANT_THREADING, sectors are read
+// by a background thread that runs ahead of the drive into a sector cache, so
+// seeks and CD-DA streaming don't do file I/O on the emulation thread.
+class CDIF
+{
+ public:
+
+ CDIF(CDAccess *cda);
+ ~CDIF();
+
+ inline void ReadTOC(CDUtility::TOC *read_target)
+ {
+  *read_target = disc_toc;
+ }
+
+ // Fills buf with the 2352 bytes of a raw sector, waiting only if the read thread hasn't
+ // got to it yet.  Returns false on a read error or past the lead-out.
+ bool ReadRawSector(uint8 *buf, uint32 lba);
+
+ // Moves the read thread to lba ahead of a seek, so the sectors are cached by the time
+ // the emulated seek is over.
+ void HintReadSector(uint32 lba);
+
+ // Reads the 2048-byte user data of nSectors data sectors.  Returns 0 if any of them
+ // can't be read or is an audio sector.
+ int ReadSector(uint8 *pBuf, uint32 lba, uint32 nSectors);
+
+ private:
+
+ CDAccess *disc_cdaccess;
+ CDUtility::TOC disc_toc;
+
+ #ifdef WANT_THREADING
+ enum { SBSize = 256 };		// Cache slots, indexed by lba % SBSize.
+ enum { ReadAheadCount = 128 };	// Sectors kept cached past the last one read; below SBSize.
+
+ struct CacheSector
+ {
+  uint32 lba;
+  bool valid;
+  bool error;
+  uint8 data[2352];
+ };
+
+ // All of the below is guarded by SBMutex, except the data of a slot the thread is filling.
+ CacheSector SB[SBSize];
+ uint32 ra_lba;		// Next sector the thread reads.
+ uint32 ra_end;		// The thread sleeps once ra_lba gets here.
+ uint32 ra_busy_lba;	// Sector being read outside the lock, if ra_busy.
+ bool ra_busy;
+ bool ra_quit;
+
+ MDFN_Thread *ReadThread;
+ MDFN_Mutex *SBMutex;
+ MDFN_Cond *WorkCond;	// Signalled when there's more to read or the thread has to quit.
+ MDFN_Cond *ReadyCond;	// Signalled when a sector lands in the cache.
+
+ void SetReadAhead(uint32 lba, bool restart);
+ void ReadThreadLoop(void);
+ static int ReadThreadStart(void *data);
+ #endif
+
+ bool ReadRawSectorDirect(uint8 *buf, uint32 lba);
+};
+
+// Opens a CUE sheet or an ISO image.  Throws MDFN_Error on failure.
+CDIF *CDIF_Open(const char *path, bool image_memcache);
+
+#endif
@@ -0,0 +1,854 @@
+/* Mednafen - Multi-system Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "../mednafen.h"
+#include "../state.h"
+#include "../okiadpcm.h"
+#include "pcecd.h"
+#include "scsicd.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+static unsigned int OC_Multiplier;
+
+static void (*IRQCB)(bool asserted);
+
+static double CDDAVolumeSetting;	// Max 2.0
+
+static Blip_Buffer *sbuf[2] = { NULL, NULL };
+
+static bool bBRAMEnabled;
+static uint8 _Port[15];
+static uint8 ACKStatus;
+
+static int32 ClearACKDelay;
+
+static int32 lastts;
+static int32 scsicd_ne = 0;
+
+typedef Blip_Synth<blip_med_quality, 4096> ADSynth;
+static ADSynth ADPCMSynth;
+static OKIADPCM_Decoder<OKIADPCM_MSM5205> MSM5205;
+static bool ADPCM_LPF;
+
+typedef struct
+{
+ uint8 *RAM;	// 0x10000 bytes
+
+ uint16 Addr;
+ uint16 ReadAddr;
+ uint16 WriteAddr;
+ uint16 LengthCount;
+
+ bool HalfReached;
+ bool EndReached;
+ bool Playing;
+
+ uint8 LastCmd;
+ uint32 SampleFreq;
+
+ uint8 PlayBuffer;
+ uint8 ReadBuffer;
+ int32 ReadPending;
+ int32 WritePending;
+ uint8 WritePendingValue;
+
+ uint32 PlayNibble;
+
+ int64 bigdivacc;	// Master clocks per 32087.5Hz tick, 48.16 fixed point.
+ int64 bigdiv;
+ int32 last_pcm;
+ int32 lp_state;	// Low-pass filter state, when ADPCM_LPF is set.
+} ADPCM_t;
+
+static ADPCM_t ADPCM;
+
+typedef struct
+{
+ uint8 Command;
+ int32 Volume;
+
+ int32 CycleCounter;
+ uint32 CountValue;	// What to reload CycleCounter with when it expires.
+ bool Clocked;
+} FADER_t;
+
+static FADER_t Fader;
+static int32 ADPCMFadeVolume, CDDAFadeVolume;
+
+static int16 RawPCMVolumeCache[2];
+
+static INLINE void Fader_SyncWhich(void)
+{
+ if(Fader.Command & 0x2) // ADPCM fade
+ {
+  ADPCMFadeVolume = Fader.Volume;
+  CDDAFadeVolume = 65536;
+ }
+ else	// CD-DA Fade
+ {
+  CDDAFadeVolume = Fader.Volume;
+  ADPCMFadeVolume = 65536;
+ }
+
+ ADPCMFadeVolume >>= 6;
+ SCSICD_SetCDDAVolume(0.50f * CDDAFadeVolume * CDDAVolumeSetting / 65536, 0.50f * CDDAFadeVolume * CDDAVolumeSetting / 65536);
+}
+
+static INLINE void update_irq_state(void)
+{
+ uint8 irq = _Port[2] & _Port[0x3] & (0x4 | 0x8 | 0x10 | 0x20 | 0x40);
+
+ IRQCB((bool)irq);
+}
+
+static void UpdateADPCMIRQState(void)
+{
+ _Port[0x3] &= ~0xC;
+
+ _Port[0x3] |= ADPCM.HalfReached ? 0x4 : 0x0;
+ _Port[0x3] |= ADPCM.EndReached ? 0x8 : 0x0;
+
+ update_irq_state();
+}
+
+static void CDIRQ(int type)
+{
+ if(type & 0x8000)
+ {
+  type &= 0x7FFF;
+  if(type == SCSICD_IRQ_DATA_TRANSFER_DONE)
+   _Port[0x3] &= ~0x20;
+  else if(type == SCSICD_IRQ_DATA_TRANSFER_READY)
+   _Port[0x3] &= ~0x40;
+ }
+ else if(type == SCSICD_IRQ_DATA_TRANSFER_DONE)
+ {
+  _Port[0x3] |= 0x20;
+ }
+ else if(type == SCSICD_IRQ_DATA_TRANSFER_READY)
+ {
+  _Port[0x3] |= 0x40;
+ }
+ update_irq_state();
+}
+
+static INLINE int32 CalcNextEvent(int32 base)
+{
+ int32 next_event = base;
+
+ if(next_event > scsicd_ne)
+  next_event = scsicd_ne;
+
+ if(ClearACKDelay > 0 && next_event > ClearACKDelay)
+  next_event = ClearACKDelay;
+
+ if(ADPCM.WritePending > 0 && next_event > ADPCM.WritePending)
+  next_event = ADPCM.WritePending;
+
+ if(ADPCM.ReadPending > 0 && next_event > ADPCM.ReadPending)
+  next_event = ADPCM.ReadPending;
+
+ if(ADPCM.Playing && ADPCM.bigdiv > 0)
+ {
+  int32 ad_event = (ADPCM.bigdiv + 0xFFFF) >> 16;
+
+  if(next_event > ad_event)
+   next_event = ad_event;
+ }
+
+ if(Fader.Clocked && Fader.CycleCounter > 0 && next_event > Fader.CycleCounter)
+  next_event = Fader.CycleCounter;
+
+ return(next_event);
+}
+
+bool PCECD_SetSettings(const PCECD_Settings *settings)
+{
+ CDDAVolumeSetting = settings ? settings->CDDA_Volume : 1.0;
+ Fader_SyncWhich();
+
+ ADPCMSynth.volume(0.42735f * (settings ? settings->ADPCM_Volume : 1.0));
+ ADPCM_LPF = settings ? settings->ADPCM_LPF : false;
+
+ SCSICD_SetTransferRate(126000 * (settings ? settings->CD_Speed : 1));
+
+ return(true);
+}
+
+bool PCECD_Init(const PCECD_Settings *settings, void (*irqcb)(bool), double master_clock, unsigned int ocm, Blip_Buffer *soundbuf_l, Blip_Buffer *soundbuf_r)
+{
+ lastts = 0;
+
+ OC_Multiplier = ocm;
+
+ IRQCB = irqcb;
+
+ sbuf[0] = soundbuf_l;
+ sbuf[1] = soundbuf_r;
+
+ // The 3 converts master clocks into the CPU clocks the Blip_Buffers run at.
+ SCSICD_Init(3 * OC_Multiplier, sbuf[0], sbuf[1], 126000 * settings->CD_Speed, (uint32)(master_clock * OC_Multiplier), CDIRQ);
+
+ if(!(ADPCM.RAM = (uint8 *)MDFN_malloc(0x10000, _("PCE ADPCM RAM"))))
+  return(false);
+
+ Fader.Volume = 65536;
+ PCECD_SetSettings(settings);
+
+ ADPCM.bigdivacc = (int64)((double)master_clock * OC_Multiplier * 65536 / 32087.5);
+
+ return(true);
+}
+
+void PCECD_Close(void)
+{
+ if(ADPCM.RAM)
+ {
+  MDFN_free(ADPCM.RAM);
+  ADPCM.RAM = NULL;
+ }
+ SCSICD_Close();
+}
+
+int32 PCECD_Power(uint32 timestamp)
+{
+ if((int32)timestamp != lastts)
+  (void)PCECD_Run(timestamp);
+
+ IRQCB(0);
+
+ SCSICD_Power(timestamp);
+ scsicd_ne = 0x7fffffff;
+
+ bBRAMEnabled = false;
+ memset(_Port, 0, sizeof(_Port));
+ ACKStatus = 0;
+ ClearACKDelay = 0;
+ RawPCMVolumeCache[0] = RawPCMVolumeCache[1] = 0;
+
+ memset(ADPCM.RAM, 0x00, 65536);
+
+ ADPCM.ReadPending = ADPCM.WritePending = 0;
+ ADPCM.ReadBuffer = 0;
+ ADPCM.PlayBuffer = 0;
+
+ MSM5205.SetSample(0x800);
+ MSM5205.SetSSI(0);
+
+ ADPCM.SampleFreq = 0;
+ ADPCM.bigdiv = ADPCM.bigdivacc * (16 - ADPCM.SampleFreq);
+
+ ADPCM.Addr = 0;
+ ADPCM.ReadAddr = 0;
+ ADPCM.WriteAddr = 0;
+ ADPCM.LengthCount = 0;
+ ADPCM.LastCmd = 0;
+
+ ADPCM.HalfReached = false;
+ ADPCM.EndReached = false;
+ ADPCM.Playing = false;
+ ADPCM.PlayNibble = 0;
+ ADPCM.lp_state = 0;
+
+ UpdateADPCMIRQState();
+
+ Fader.Command = 0x00;
+ Fader.Volume = 65536;
+ Fader.CycleCounter = 0;
+ Fader.CountValue = 0;
+ Fader.Clocked = false;
+ Fader_SyncWhich();
+
+ return(CalcNextEvent(0x7FFFFFFF));
+}
+
+bool PCECD_IsBRAMEnabled(void)
+{
+ return(bBRAMEnabled);
+}
+
+static INLINE uint8 read_1808(int32 timestamp, const bool PeekMode)
+{
+ uint8 ret = SCSICD_GetDB();
+
+ if(!PeekMode)
+ {
+  if(SCSICD_GetREQ() && !SCSICD_GetACK() && !SCSICD_GetCD())
+  {
+   if(SCSICD_GetIO())
+   {
+    SCSICD_SetACK(true);
+    ACKStatus = true;
+    scsicd_ne = SCSICD_Run(timestamp);
+    ClearACKDelay = 15 * 3;
+   }
+  }
+ }
+
+ return(ret);
+}
+
+uint8 PCECD_Read(uint32 timestamp, uint32 A, int32 &next_event, const bool PeekMode)
+{
+ uint8 ret = 0;
+
+ if((A & 0x18C0) == 0x18C0)
+ {
+  // BIOS ID bytes.
+  switch(A & 0x18CF)
+  {
+   case 0x18C1: ret = 0xAA; break;
+   case 0x18C2: ret = 0x55; break;
+   case 0x18C3: ret = 0x00; break;
+   case 0x18C5: ret = 0xAA; break;
+   case 0x18C6: ret = 0x55; break;
+   case 0x18C7: ret = 0x03; break;
+  }
+ }
+ else
+ {
+  PCECD_Run(timestamp);
+
+  switch(A & 0xf)
+  {
+   case 0x0:
+	ret = 0;
+	ret |= SCSICD_GetBSY() ? 0x80 : 0x00;
+	ret |= SCSICD_GetREQ() ? 0x40 : 0x00;
+	ret |= SCSICD_GetMSG() ? 0x20 : 0x00;
+	ret |= SCSICD_GetCD() ? 0x10 : 0x00;
+	ret |= SCSICD_GetIO() ? 0x08 : 0x00;
+	break;
+
+   case 0x1:
+	ret = SCSICD_GetDB();
+	break;
+
+   case 0x2:
+	ret = _Port[2];
+	break;
+
+   case 0x3:
+	bBRAMEnabled = false;
+
+	// Switches the left/right CD-DA channel seen at $1805/$1806.
+	ret = _Port[0x3];
+	if(!PeekMode)
+	 _Port[0x3] ^= 2;
+	break;
+
+   case 0x4:
+	ret = _Port[4];
+	break;
+
+   case 0x5:
+	if(_Port[0x3] & 0x2)
+	 ret = RawPCMVolumeCache[1] & 0xff;	// Right
+	else
+	 ret = RawPCMVolumeCache[0] & 0xff;	// Left
+	break;
+
+   case 0x6:
+	if(_Port[0x3] & 0x2)
+	 ret = ((uint16)RawPCMVolumeCache[1]) >> 8;	// Right
+	else
+	 ret = ((uint16)RawPCMVolumeCache[0]) >> 8;	// Left
+	break;
+
+   case 0x7:
+	ret = SCSICD_GetREQ() && !SCSICD_GetMSG() && !SCSICD_GetCD() && SCSICD_GetIO() ? 0x80 : 0x00;
+	break;
+
+   case 0x8:
+	ret = read_1808(timestamp, PeekMode);
+	break;
+
+   case 0xa:
+	if(!PeekMode)
+	 ADPCM.ReadPending = 19 * 3;
+
+	ret = ADPCM.ReadBuffer;
+	break;
+
+   case 0xb:
+	ret = _Port[0xb];
+	break;
+
+   case 0xc:
+	ret = 0x00;
+
+	ret |= (ADPCM.EndReached) ? 0x01 : 0x00;
+	ret |= (ADPCM.Playing) ? 0x08 : 0x00;
+	ret |= (ADPCM.WritePending > 0) ? 0x04 : 0x00;
+	ret |= (ADPCM.ReadPending > 0) ? 0x80 : 0x00;
+	break;
+
+   case 0xd:
+	ret = ADPCM.LastCmd;
+	break;
+  }
+ }
+
+ next_event = CalcNextEvent(0x7FFFFFFF);
+
+ return(ret);
+}
+
+int32 PCECD_Write(uint32 timestamp, uint32 physAddr, uint8 data)
+{
+ const uint8 V = data;
+
+ PCECD_Run(timestamp);
+
+ switch(physAddr & 0xf)
+ {
+  case 0x0:
+	SCSICD_SetSEL(1);
+	SCSICD_Run(timestamp);
+	SCSICD_SetSEL(0);
+	scsicd_ne = SCSICD_Run(timestamp);
+
+	// Reset irq status
+	_Port[0x3] &= ~(0x20 | 0x40);
+	update_irq_state();
+	break;
+
+  case 0x1:
+	_Port[1] = data;
+	SCSICD_SetDB(data);
+	scsicd_ne = SCSICD_Run(timestamp);
+	break;
+
+  case 0x2:
+	SCSICD_SetACK(data & 0x80);
+	scsicd_ne = SCSICD_Run(timestamp);
+	_Port[2] = data;
+	ACKStatus = (bool)(data & 0x80);
+	update_irq_state();
+	break;
+
+  case 0x3:	// read only
+	break;
+
+  case 0x4:
+	SCSICD_SetRST(data & 0x2);
+	scsicd_ne = SCSICD_Run(timestamp);
+	if(data & 0x2)
+	{
+	 _Port[0x3] &= ~0x70;
+	 update_irq_state();
+	}
+	_Port[4] = data;
+	break;
+
+  case 0x5:
+  case 0x6:
+	{
+	 int16 left, right;
+
+	 SCSICD_GetCDDAValues(left, right);
+
+	 RawPCMVolumeCache[0] = ((int64)abs(left) * CDDAFadeVolume) >> 16;
+	 RawPCMVolumeCache[1] = ((int64)abs(right) * CDDAFadeVolume) >> 16;
+	}
+	break;
+
+  case 0x7:	// $1807: D7=1 enables backup ram
+	if(data & 0x80)
+	 bBRAMEnabled = true;
+	break;
+
+  case 0x8:	// Set ADPCM address low
+	if(ADPCM.LastCmd & 0x80)
+	 break;
+
+	ADPCM.Addr &= 0xFF00;
+	ADPCM.Addr |= V;
+
+	// Length appears to be constantly latched when D4 is set(tested on a real system)
+	if(ADPCM.LastCmd & 0x10)
+	 ADPCM.LengthCount = ADPCM.Addr;
+	break;
+
+  case 0x9:	// Set ADPCM address high
+	if(ADPCM.LastCmd & 0x80)
+	 break;
+
+	ADPCM.Addr &= 0x00FF;
+	ADPCM.Addr |= V << 8;
+
+	// Length appears to be constantly latched when D4 is set(tested on a real system)
+	if(ADPCM.LastCmd & 0x10)
+	 ADPCM.LengthCount = ADPCM.Addr;
+	break;
+
+  case 0xa:
+	ADPCM.WritePending = 3 * 11;
+	ADPCM.WritePendingValue = data;
+	break;
+
+  case 0xb:	// ADPCM DMA
+	_Port[0xb] = data;
+	break;
+
+  case 0xc:	// read-only
+	break;
+
+  case 0xd:
+	if(data & 0x80)
+	{
+	 ADPCM.Addr = 0;
+	 ADPCM.ReadAddr = 0;
+	 ADPCM.WriteAddr = 0;
+	 ADPCM.LengthCount = 0;
+	 ADPCM.LastCmd = 0;
+
+	 ADPCM.Playing = false;
+	 ADPCM.HalfReached = false;
+	 ADPCM.EndReached = false;
+
+	 ADPCM.PlayNibble = 0;
+
+	 UpdateADPCMIRQState();
+
+	 MSM5205.SetSample(0x800);
+	 MSM5205.SetSSI(0);
+	 break;
+	}
+
+	if(ADPCM.Playing && !(data & 0x20))
+	 ADPCM.Playing = false;
+
+	if(!ADPCM.Playing && (data & 0x20))
+	{
+	 ADPCM.bigdiv = ADPCM.bigdivacc * (16 - ADPCM.SampleFreq);
+	 ADPCM.Playing = true;
+	 ADPCM.HalfReached = false;	// Not sure about this.
+	 ADPCM.PlayNibble = 0;
+	 MSM5205.SetSample(0x800);
+	 MSM5205.SetSSI(0);
+	}
+
+	// Length appears to be constantly latched when D4 is set(tested on a real system)
+	if(data & 0x10)
+	{
+	 ADPCM.LengthCount = ADPCM.Addr;
+	 ADPCM.EndReached = false;
+	}
+
+	// D2 and D3 control read address
+	if(!(ADPCM.LastCmd & 0x8) && (data & 0x08))
+	{
+	 if(data & 0x4)
+	  ADPCM.ReadAddr = ADPCM.Addr;
+	 else
+	  ADPCM.ReadAddr = (ADPCM.Addr - 1) & 0xFFFF;
+	}
+
+	// D0 and D1 control write address
+	if(!(ADPCM.LastCmd & 0x2) && (data & 0x2))
+	{
+	 ADPCM.WriteAddr = ADPCM.Addr;
+	 if(!(data & 0x1))
+	  ADPCM.WriteAddr = (ADPCM.WriteAddr - 1) & 0xFFFF;
+	}
+	ADPCM.LastCmd = data;
+	UpdateADPCMIRQState();
+	break;
+
+  case 0xe:	// Set ADPCM playback rate
+	ADPCM.SampleFreq = V & 0x0F;
+	break;
+
+  case 0xf:
+	Fader.Command = V;
+
+	// Cancel fade
+	if(!(V & 0x8))
+	{
+	 Fader.Volume = 65536;
+	 Fader.CycleCounter = 0;
+	 Fader.CountValue = 0;
+	 Fader.Clocked = false;
+	}
+	else
+	{
+	 Fader.CountValue = OC_Multiplier * 3 * ((V & 4) ? 273 : 655);	// 2.500s : 6.000s;
+
+	 if(!Fader.Clocked)
+	  Fader.CycleCounter = Fader.CountValue;
+
+	 Fader.Clocked = true;
+	}
+	Fader_SyncWhich();
+	break;
+ }
+
+ return(CalcNextEvent(0x7FFFFFFF));
+}
+
+static INLINE void ADPCM_PB_Run(int32 basetime, int32 run_time)
+{
+ if(!ADPCM.Playing)
+  return;
+
+ ADPCM.bigdiv -= (int64)run_time * 65536;
+
+ while(ADPCM.bigdiv <= 0)
+ {
+  const uint32 synthtime = (basetime + (int32)(ADPCM.bigdiv >> 16)) / (3 * OC_Multiplier);
+
+  ADPCM.bigdiv += ADPCM.bigdivacc * (16 - ADPCM.SampleFreq);
+
+  if(!ADPCM.PlayNibble)	// Do playback sample buffer fetch.
+  {
+   ADPCM.HalfReached = (ADPCM.LengthCount < 32768);
+   if(!ADPCM.LengthCount && !(ADPCM.LastCmd & 0x10))
+   {
+    if(ADPCM.EndReached)
+     ADPCM.HalfReached = false;
+
+    ADPCM.EndReached = true;
+
+    if(ADPCM.LastCmd & 0x40)
+     ADPCM.Playing = false;
+   }
+
+   ADPCM.PlayBuffer = ADPCM.RAM[ADPCM.ReadAddr];
+   ADPCM.ReadAddr = (ADPCM.ReadAddr + 1) & 0xFFFF;
+
+   if(ADPCM.LengthCount && !(ADPCM.LastCmd & 0x10))
+    ADPCM.LengthCount--;
+  }
+
+  if(!ADPCM.Playing)
+   break;
+
+  {
+   const uint8 nibble = (ADPCM.PlayBuffer >> (ADPCM.PlayNibble ^ 4)) & 0x0F;
+   int32 pcm = ((MSM5205.Decode(nibble) - 0x800) * ADPCMFadeVolume) >> 10;
+
+   ADPCM.PlayNibble ^= 4;
+
+   if(ADPCM_LPF)
+    pcm = ADPCM.lp_state = (ADPCM.lp_state + pcm) >> 1;
+
+   if(pcm != ADPCM.last_pcm)
+   {
+    ADPCMSynth.offset_inline(synthtime, pcm - ADPCM.last_pcm, sbuf[0]);
+    ADPCMSynth.offset_inline(synthtime, pcm - ADPCM.last_pcm, sbuf[1]);
+    ADPCM.last_pcm = pcm;
+   }
+  }
+ }
+}
+
+static INLINE void ADPCM_Run(const int32 clocks, const int32 timestamp)
+{
+ ADPCM_PB_Run(timestamp, clocks);
+
+ if(ADPCM.WritePending)
+ {
+  ADPCM.WritePending -= clocks;
+  if(ADPCM.WritePending <= 0)
+  {
+   ADPCM.HalfReached = (ADPCM.LengthCount < 32768);
+   if(!(ADPCM.LastCmd & 0x10) && ADPCM.LengthCount < 0xFFFF)
+    ADPCM.LengthCount++;
+
+   ADPCM.RAM[ADPCM.WriteAddr++] = ADPCM.WritePendingValue;
+   ADPCM.WritePending = 0;
+  }
+ }
+
+ if(!ADPCM.WritePending)
+ {
+  if(_Port[0xb] & 0x3)
+  {
+   // Run SCSICD before we examine the signals.
+   scsicd_ne = SCSICD_Run(timestamp);
+
+   if(SCSICD_GetREQ() && !SCSICD_GetACK() && !SCSICD_GetCD() && SCSICD_GetIO())
+   {
+    ADPCM.WritePending = 10 * 3;
+    ADPCM.WritePendingValue = read_1808(timestamp, false);
+   }
+  }
+ }
+
+ if(ADPCM.ReadPending)
+ {
+  ADPCM.ReadPending -= clocks;
+  if(ADPCM.ReadPending <= 0)
+  {
+   ADPCM.ReadBuffer = ADPCM.RAM[ADPCM.ReadAddr];
+   ADPCM.ReadAddr = (ADPCM.ReadAddr + 1) & 0xFFFF;
+   ADPCM.ReadPending = 0;
+
+   ADPCM.HalfReached = (ADPCM.LengthCount < 32768);
+   if(!(ADPCM.LastCmd & 0x10))
+   {
+    if(ADPCM.LengthCount)
+     ADPCM.LengthCount--;
+    else
+    {
+     ADPCM.EndReached = true;
+     ADPCM.HalfReached = false;
+
+     if(ADPCM.LastCmd & 0x40)
+      ADPCM.Playing = false;
+    }
+   }
+  }
+ }
+
+ UpdateADPCMIRQState();
+}
+
+int32 PCECD_Run(uint32 in_timestamp)
+{
+ int32 clocks = in_timestamp - lastts;
+ int32 running_ts = lastts;
+
+ while(clocks > 0)
+ {
+  int32 chunk_clocks = CalcNextEvent(clocks);
+
+  running_ts += chunk_clocks;
+
+  if(ClearACKDelay > 0)
+  {
+   ClearACKDelay -= chunk_clocks;
+   if(ClearACKDelay <= 0)
+   {
+    ACKStatus = false;
+    SCSICD_SetACK(false);
+    scsicd_ne = SCSICD_Run(running_ts);
+    if(SCSICD_GetCD())
+     _Port[0xb] &= 0xFC;	// DMA ends with the status phase.
+
+    ClearACKDelay = 0;
+   }
+  }
+
+  if(Fader.Clocked)
+  {
+   Fader.CycleCounter -= chunk_clocks;
+   while(Fader.CycleCounter <= 0)
+   {
+    if(Fader.Volume)
+     Fader.Volume--;
+
+    Fader_SyncWhich();
+
+    Fader.CycleCounter += Fader.CountValue;
+   }
+  }
+
+  ADPCM_Run(chunk_clocks, running_ts);
+
+  scsicd_ne -= chunk_clocks;
+  if(scsicd_ne <= 0)
+   scsicd_ne = SCSICD_Run(running_ts);
+
+  clocks -= chunk_clocks;
+ }
+
+ lastts = in_timestamp;
+
+ return(CalcNextEvent(0x7FFFFFFF));
+}
+
+void PCECD_ResetTS(void)
+{
+ // Bring the drive up to the end of the frame first, or the clocks since it last ran would be lost.
+ scsicd_ne = SCSICD_Run(lastts);
+ SCSICD_ResetTS();
+ lastts = 0;
+}
+
+int PCECD_StateAction(StateMem *sm, int load, int data_only)
+{
+ uint16 ADPCM_Sample = MSM5205.GetSample();
+ uint8 ADPCM_SSI = MSM5205.GetSSI();
+
+ SFORMAT StateRegs[] =
+ {
+  SFVAR(bBRAMEnabled),
+  SFVAR(ACKStatus),
+  SFVAR(ClearACKDelay),
+  SFARRAY16(RawPCMVolumeCache, 2),
+  SFARRAY(_Port, sizeof(_Port)),
+
+  SFVARN(Fader.Command, "FADER_Command"),
+  SFVARN(Fader.Volume, "FADER_Volume"),
+  SFVARN(Fader.CycleCounter, "FADER_CycleCounter"),
+  SFVARN(Fader.CountValue, "FADER_CountValue"),
+  SFVARN(Fader.Clocked, "FADER_Clocked"),
+
+  SFARRAYN(ADPCM.RAM, 0x10000, "ADPCM.RAM"),
+  SFVARN(ADPCM.bigdiv, "ADPCM.bigdiv"),
+  SFVARN(ADPCM.Addr, "ADPCM.Addr"),
+  SFVARN(ADPCM.ReadAddr, "ADPCM.ReadAddr"),
+  SFVARN(ADPCM.WriteAddr, "ADPCM.WriteAddr"),
+  SFVARN(ADPCM.LengthCount, "ADPCM.LengthCount"),
+  SFVARN(ADPCM.LastCmd, "ADPCM.LastCmd"),
+  SFVARN(ADPCM.SampleFreq, "ADPCM.SampleFreq"),
+
+  SFVARN(ADPCM.ReadPending, "ADPCM.ReadPending"),
+  SFVARN(ADPCM.ReadBuffer, "ADPCM.ReadBuffer"),
+  SFVARN(ADPCM.PlayBuffer, "ADPCM.PlayBuffer"),
+
+  SFVARN(ADPCM.WritePending, "ADPCM.WritePending"),
+  SFVARN(ADPCM.WritePendingValue, "ADPCM.WritePendingValue"),
+
+  SFVARN(ADPCM.HalfReached, "ADPCM.HalfReached"),
+  SFVARN(ADPCM.EndReached, "ADPCM.EndReached"),
+  SFVARN(ADPCM.Playing, "ADPCM.Playing"),
+
+  SFVARN(ADPCM.PlayNibble, "ADPCM.PlayNibble"),
+  SFVARN(ADPCM.lp_state, "ADPCM.lp_state"),
+
+  SFVAR(ADPCM_Sample),
+  SFVAR(ADPCM_SSI),
+  SFEND
+ };
+
+ int ret = MDFNSS_StateAction(sm, load, data_only, StateRegs, "PCECD");
+
+ ret &= SCSICD_StateAction(sm, load, data_only, "CDRM");
+
+ if(load)
+ {
+  MSM5205.SetSample(ADPCM_Sample & 0xFFF);
+  MSM5205.SetSSI((ADPCM_SSI > 48) ? 48 : ADPCM_SSI);
+
+  ADPCM.SampleFreq &= 0xF;
+  ADPCM.PlayNibble &= 4;
+
+  Fader_SyncWhich();
+  UpdateADPCMIRQState();
+
+  // Have the drive looked at on the next run.
+  scsicd_ne = 1;
+ }
+
+ return(ret);
+}
@@ -0,0 +1,35 @@
+#ifndef __PCE_CDROM_H
+#define __PCE_CDROM_H
+
+#include <blip/Blip_Buffer.h>
+
+typedef struct
+{
+	double CDDA_Volume;	// Max 2.000...
+	double ADPCM_Volume;	// Max 2.000...
+
+	unsigned int CD_Speed;
+
+	bool ADPCM_LPF;
+} PCECD_Settings;
+
+// Timestamps are in master clock cycles(times the overclock multiplier).  These return the
+// number of cycles until the next CD event.
+int32 PCECD_Run(uint32 in_timestamp);
+void PCECD_ResetTS(void);
+
+bool PCECD_Init(const PCECD_Settings *settings, void (*irqcb)(bool), double master_clock, unsigned int ocm, Blip_Buffer *soundbuf_l, Blip_Buffer *soundbuf_r);
+bool PCECD_SetSettings(const PCECD_Settings *settings);
+
+void PCECD_Close();
+
+int32 PCECD_Power(uint32 timestamp);
+
+uint8 PCECD_Read(uint32 timestamp, uint32, int32 &next_event, const bool PeekMode = false);
+int32 PCECD_Write(uint32 timestamp, uint32, uint8 data);
+
+bool PCECD_IsBRAMEnabled();
+
+int PCECD_StateAction(StateMem *sm, int load, int data_only);
+
+#endif
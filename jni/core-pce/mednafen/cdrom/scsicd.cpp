@@ -0,0 +1,1128 @@
+/* Mednafen - Multi-system Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+/*
+ The PC Engine CD-ROM drive, as seen from the SCSI bus: the bus phases, the handful of
+ standard and NEC commands the System Card BIOS and games use, data sector reads at the
+ drive's transfer rate and CD-DA playback.  Sectors come from the CDIF's read-ahead cache,
+ and every read is hinted to it as soon as the position is known.
+*/
+
+#include "../mednafen.h"
+#include "../state.h"
+#include "scsicd.h"
+#include "cdromif.h"
+#include "SimpleFIFO.h"
+
+#include <string.h>
+
+using namespace CDUtility;
+
+static uint32 CD_DATA_TRANSFER_RATE;
+static uint32 System_Clock;
+static void (*CDIRQCallback)(int);
+static Blip_Buffer *sbuf[2];
+
+static CDIF *Cur_CDIF;
+static bool TrayOpen;
+
+// Internal operation to the SCSI CD unit.  Only pass 1 or 0 to these macros!
+#define SetIOP(mask, set)	{ cd_bus.signals &= ~mask; if(set) cd_bus.signals |= mask; }
+
+#define SetBSY(set)		SetIOP(SCSICD_BSY_mask, set)
+#define SetIO(set)              SetIOP(SCSICD_IO_mask, set)
+#define SetCD(set)              SetIOP(SCSICD_CD_mask, set)
+#define SetMSG(set)             SetIOP(SCSICD_MSG_mask, set)
+#define SetREQ(set)             SetIOP(SCSICD_REQ_mask, set)
+
+scsicd_bus_t cd_bus;
+
+static SimpleFIFO<uint8> *din = NULL;
+
+static CDUtility::TOC toc;
+
+static uint32 read_sec_start;
+static uint32 read_sec;
+static uint32 read_sec_end;
+
+static int32 CDReadTimer;
+static uint32 SectorAddr;
+static uint32 SectorCount;
+
+enum
+{
+ PHASE_BUS_FREE = 0,
+ PHASE_COMMAND,
+ PHASE_DATA_IN,
+ PHASE_STATUS,
+ PHASE_MESSAGE_IN,
+};
+
+static int32 CurrentPhase;
+static void ChangePhase(const int32 new_phase);
+
+typedef struct
+{
+ bool last_RST_signal;
+
+ // The pending message to send(in the message phase)
+ uint8 message_pending;
+
+ bool status_sent, message_sent;
+
+ // Pending error codes
+ uint8 key_pending, asc_pending, ascq_pending, fru_pending;
+
+ uint8 command_buffer[256];
+ uint8 command_buffer_pos;
+
+ // false if not all pending data is in the FIFO, true if it is.
+ // Used for multiple sector CD reads.
+ bool data_transfer_done;
+
+ bool DiscChanged;
+
+ uint8 SubQBuf[0xC];	// Q subchannel of the last sector read or played.
+} scsicd_t;
+
+enum
+{
+ CDDASTATUS_PAUSED = -1,
+ CDDASTATUS_STOPPED = 0,
+ CDDASTATUS_PLAYING = 1,
+};
+
+enum
+{
+ PLAYMODE_SILENT = 0x00,
+ PLAYMODE_NORMAL,
+ PLAYMODE_INTERRUPT,
+ PLAYMODE_LOOP,
+};
+
+typedef struct
+{
+ int64 CDDADivAcc;	// System clocks per sample, 16.16 fixed point.
+ int64 CDDADiv;
+ int CDDATimeDiv;
+
+ int32 CDDAVolume[2];	// 65536 is full volume.
+ int16 RawSample[2];	// Last sample before the volume, for $1805/$1806.
+ int32 last_sample[2];	// Last level handed to the synth.
+
+ int16 CDDASectorBuffer[1176];
+ uint32 CDDAReadPos;
+
+ int8 CDDAStatus;
+ uint8 PlayMode;
+} cdda_t;
+
+static Blip_Synth<blip_good_quality, 65536> CDDASynth;
+
+static scsicd_t cd;
+static cdda_t cdda;
+
+static int32 lastts;
+static uint32 monotonic_timestamp;
+static uint32 pce_lastsapsp_timestamp;
+
+#define STATUS_GOOD		0
+#define STATUS_CHECK_CONDITION	1
+
+#define SENSEKEY_NO_SENSE		0x0
+#define SENSEKEY_NOT_READY		0x2
+#define SENSEKEY_MEDIUM_ERROR		0x3
+#define SENSEKEY_HARDWARE_ERROR		0x4
+#define SENSEKEY_ILLEGAL_REQUEST	0x5
+#define SENSEKEY_UNIT_ATTENTION		0x6
+#define SENSEKEY_ABORTED_COMMAND	0xB
+
+// NEC sub-errors(ASC), no ASCQ.
+#define NSE_NO_DISC			0x0B		// Used with SENSEKEY_NOT_READY	- This condition occurs when tray is closed with no disc present.
+#define NSE_TRAY_OPEN			0x0D		// Used with SENSEKEY_NOT_READY
+#define NSE_SEEK_ERROR			0x15
+#define NSE_HEADER_READ_ERROR		0x16		// Used with SENSEKEY_MEDIUM_ERROR
+#define NSE_NOT_AUDIO_TRACK		0x1C		// Used with SENSEKEY_MEDIUM_ERROR
+#define NSE_NOT_DATA_TRACK		0x1D		// Used with SENSEKEY_MEDIUM_ERROR
+#define NSE_INVALID_COMMAND		0x20		// Used with SENSEKEY_ILLEGAL_REQUEST
+#define NSE_INVALID_ADDRESS		0x21		// Used with SENSEKEY_ILLEGAL_REQUEST
+#define NSE_INVALID_PARAMETER		0x22		// Used with SENSEKEY_ILLEGAL_REQUEST
+#define NSE_END_OF_VOLUME		0x25		// Used with SENSEKEY_ILLEGAL_REQUEST
+#define NSE_INVALID_REQUEST_IN_CDB	0x27		// Used with SENSEKEY_ILLEGAL_REQUEST
+#define NSE_DISC_CHANGED		0x28		// Used with SENSEKEY_UNIT_ATTENTION
+#define NSE_AUDIO_NOT_PLAYING		0x2C
+
+static void VirtualReset(void)
+{
+ din->Flush();
+
+ CDReadTimer = 0;
+
+ pce_lastsapsp_timestamp = monotonic_timestamp;
+
+ SectorAddr = SectorCount = 0;
+ read_sec_start = read_sec = 0;
+ read_sec_end = ~0;
+
+ cdda.PlayMode = PLAYMODE_SILENT;
+ cdda.CDDAReadPos = 0;
+ cdda.CDDAStatus = CDDASTATUS_STOPPED;
+ cdda.CDDADiv = 0;
+ cdda.RawSample[0] = cdda.RawSample[1] = 0;
+
+ cd.status_sent = cd.message_sent = false;
+ cd.command_buffer_pos = 0;
+ cd.data_transfer_done = false;
+
+ cd_bus.DB = 0;
+
+ ChangePhase(PHASE_BUS_FREE);
+}
+
+void SCSICD_Power(scsicd_timestamp_t system_timestamp)
+{
+ memset(&cd, 0, sizeof(scsicd_t));
+ memset(&cd_bus, 0, sizeof(scsicd_bus_t));
+
+ monotonic_timestamp = system_timestamp;
+ lastts = system_timestamp;
+
+ if(Cur_CDIF && !TrayOpen)
+  Cur_CDIF->ReadTOC(&toc);
+
+ CurrentPhase = PHASE_BUS_FREE;
+
+ VirtualReset();
+}
+
+void SCSICD_SetDB(uint8 data)
+{
+ cd_bus.DB = data;
+}
+
+void SCSICD_SetACK(bool set)
+{
+ SetIOP(SCSICD_kingACK_mask, set);
+}
+
+void SCSICD_SetSEL(bool set)
+{
+ SetIOP(SCSICD_kingSEL_mask, set);
+}
+
+void SCSICD_SetRST(bool set)
+{
+ SetIOP(SCSICD_kingRST_mask, set);
+}
+
+void SCSICD_SetATN(bool set)
+{
+ SetIOP(SCSICD_kingATN_mask, set);
+}
+
+static void ChangePhase(const int32 new_phase)
+{
+ switch(new_phase)
+ {
+  case PHASE_BUS_FREE:
+		SetBSY(false);
+		SetMSG(false);
+		SetCD(false);
+		SetIO(false);
+		SetREQ(false);
+
+	        CDIRQCallback(0x8000 | SCSICD_IRQ_DATA_TRANSFER_DONE);
+		break;
+
+  case PHASE_DATA_IN:		// Us to them
+		SetBSY(true);
+	        SetMSG(false);
+	        SetCD(false);
+	        SetIO(true);
+		SetREQ(false);
+		break;
+
+  case PHASE_STATUS:		// Us to them
+		SetBSY(true);
+		SetMSG(false);
+		SetCD(true);
+		SetIO(true);
+		SetREQ(true);
+		break;
+
+  case PHASE_MESSAGE_IN:	// Us to them
+		SetBSY(true);
+		SetMSG(true);
+		SetCD(true);
+		SetIO(true);
+		SetREQ(true);
+		break;
+
+  case PHASE_COMMAND:		// Them to us
+		SetBSY(true);
+	        SetMSG(false);
+	        SetCD(true);
+	        SetIO(false);
+	        SetREQ(true);
+		break;
+ }
+ CurrentPhase = new_phase;
+}
+
+static void SendStatusAndMessage(uint8 status, uint8 message)
+{
+ // This should never ever happen, but that doesn't mean it won't. ;)
+ if(din->CanRead())
+  din->Flush();
+
+ cd.message_pending = message;
+
+ cd.status_sent = false;
+ cd.message_sent = false;
+
+ if(status == STATUS_GOOD)
+  cd_bus.DB = 0x00;
+ else
+  cd_bus.DB = 0x01;
+
+ ChangePhase(PHASE_STATUS);
+}
+
+static void DoSimpleDataIn(const uint8 *data_in, uint32 len)
+{
+ din->Write(data_in, len);
+
+ cd.data_transfer_done = true;
+
+ ChangePhase(PHASE_DATA_IN);
+}
+
+static void CommandCCError(int key, int asc = 0, int ascq = 0)
+{
+ cd.key_pending = key;
+ cd.asc_pending = asc;
+ cd.ascq_pending = ascq;
+ cd.fru_pending = 0x00;
+
+ SendStatusAndMessage(STATUS_CHECK_CONDITION, 0x00);
+}
+
+static bool IsDataSector(uint32 lba)
+{
+ const int track = toc.FindTrackByLBA(lba);
+
+ return(track >= 1 && track <= 99 && (toc.tracks[track].control & SUBQ_CTRLF_DATA));
+}
+
+/********************************************************
+*							*
+*	SCSI-2 CD Command 0x00 - TEST UNIT READY	*
+*							*
+********************************************************/
+static void DoTESTUNITREADY(const uint8 *cdb)
+{
+ SendStatusAndMessage(STATUS_GOOD, 0x00);
+}
+
+/********************************************************
+*							*
+*	SCSI-2 CD Command 0x03 - REQUEST SENSE		*
+*							*
+********************************************************/
+static void DoREQUESTSENSE(const uint8 *cdb)
+{
+ uint8 data_in[18];
+
+ memset(data_in, 0, sizeof(data_in));
+
+ data_in[0] = 0x70;
+ data_in[2] = cd.key_pending;
+ data_in[7] = 0x0A;
+ data_in[12] = cd.asc_pending;
+ data_in[13] = cd.ascq_pending;
+ data_in[14] = cd.fru_pending;
+
+ cd.key_pending = 0;
+ cd.asc_pending = 0;
+ cd.ascq_pending = 0;
+ cd.fru_pending = 0;
+
+ DoSimpleDataIn(data_in, 18);
+}
+
+/********************************************************
+*							*
+*	SCSI-2 CD Command 0x08 - READ(6)		*
+*							*
+********************************************************/
+static void DoREAD6(const uint8 *cdb)
+{
+ uint32 sa = ((cdb[1] & 0x1F) << 16) | (cdb[2] << 8) | (cdb[3] << 0);
+ uint32 sc = cdb[4];
+
+ if(!sc)
+  sc = 256;
+
+ if(sa >= toc.tracks[100].lba)
+ {
+  CommandCCError(SENSEKEY_ILLEGAL_REQUEST, NSE_END_OF_VOLUME);
+  return;
+ }
+
+ SectorAddr = sa;
+ SectorCount = sc;
+
+ Cur_CDIF->HintReadSector(sa);
+
+ // The first sector takes longer, for the seek.
+ CDReadTimer = (uint64)3 * 2048 * System_Clock / CD_DATA_TRANSFER_RATE;
+
+ cdda.CDDAStatus = CDDASTATUS_STOPPED;
+}
+
+/********************************************************
+*							*
+*	NEC CD Command 0xD8 - SAPSP			*
+*							*
+********************************************************/
+static uint32 ParsePlayPosition(const uint8 *cdb)
+{
+ switch(cdb[9] & 0xC0)
+ {
+  default:
+  case 0x00:
+	return((cdb[3] << 16) | (cdb[4] << 8) | cdb[5]);
+
+  case 0x40:
+	return(AMSF_to_LBA(BCD_to_U8(cdb[2]), BCD_to_U8(cdb[3]), BCD_to_U8(cdb[4])));
+
+  case 0x80:
+	{
+	 int track = BCD_to_U8(cdb[2]);
+
+	 if(!track)
+	  track = 1;
+	 else if(track >= toc.last_track + 1)
+	  track = 100;
+
+	 return(toc.tracks[track].lba);
+	}
+ }
+}
+
+static void DoNEC_PCE_SAPSP(const uint8 *cdb)
+{
+ const uint32 new_read_sec_start = ParsePlayPosition(cdb);
+
+ // Some games spam this command while the music plays; a repeat of the same position
+ // within a short time doesn't restart the track.
+ if(cdda.CDDAStatus == CDDASTATUS_PLAYING && new_read_sec_start == read_sec_start && ((int64)(monotonic_timestamp - pce_lastsapsp_timestamp) * 1000 / System_Clock) < 190)
+ {
+  pce_lastsapsp_timestamp = monotonic_timestamp;
+
+  SendStatusAndMessage(STATUS_GOOD, 0x00);
+  CDIRQCallback(SCSICD_IRQ_DATA_TRANSFER_DONE);
+  return;
+ }
+
+ pce_lastsapsp_timestamp = monotonic_timestamp;
+
+ read_sec = read_sec_start = new_read_sec_start;
+ read_sec_end = toc.tracks[100].lba;
+
+ cdda.CDDAReadPos = 588;
+
+ cdda.CDDAStatus = CDDASTATUS_PAUSED;
+ cdda.PlayMode = PLAYMODE_SILENT;
+
+ if(cdb[1])
+ {
+  cdda.PlayMode = PLAYMODE_NORMAL;
+  cdda.CDDAStatus = CDDASTATUS_PLAYING;
+ }
+
+ Cur_CDIF->HintReadSector(read_sec);
+
+ SendStatusAndMessage(STATUS_GOOD, 0x00);
+ CDIRQCallback(SCSICD_IRQ_DATA_TRANSFER_DONE);
+}
+
+/********************************************************
+*							*
+*	NEC CD Command 0xD9 - SAPEP			*
+*							*
+********************************************************/
+static void DoNEC_PCE_SAPEP(const uint8 *cdb)
+{
+ read_sec_end = ParsePlayPosition(cdb);
+
+ switch(cdb[1])
+ {
+	default:
+	case 0x03: cdda.PlayMode = PLAYMODE_NORMAL;
+		   cdda.CDDAStatus = CDDASTATUS_PLAYING;
+		   break;
+
+	case 0x02: cdda.PlayMode = PLAYMODE_INTERRUPT;
+		   cdda.CDDAStatus = CDDASTATUS_PLAYING;
+		   break;
+
+	case 0x01: cdda.PlayMode = PLAYMODE_LOOP;
+		   cdda.CDDAStatus = CDDASTATUS_PLAYING;
+		   break;
+
+	case 0x00: cdda.PlayMode = PLAYMODE_SILENT;
+		   cdda.CDDAStatus = CDDASTATUS_STOPPED;
+		   break;
+ }
+
+ SendStatusAndMessage(STATUS_GOOD, 0x00);
+}
+
+/********************************************************
+*							*
+*	NEC CD Command 0xDA - Pause			*
+*							*
+********************************************************/
+static void DoNEC_PCE_PAUSE(const uint8 *cdb)
+{
+ if(cdda.CDDAStatus != CDDASTATUS_STOPPED) // Hmm, should we give an error if it tries to pause and it's already paused?
+ {
+  cdda.CDDAStatus = CDDASTATUS_PAUSED;
+  SendStatusAndMessage(STATUS_GOOD, 0x00);
+ }
+ else // Definitely give an error if it tries to pause when no track is playing!
+ {
+  CommandCCError(SENSEKEY_ILLEGAL_REQUEST, NSE_AUDIO_NOT_PLAYING);
+ }
+}
+
+/********************************************************
+*							*
+*	NEC CD Command 0xDD - Read Subchannel Q		*
+*							*
+********************************************************/
+static void DoNEC_PCE_READSUBQ(const uint8 *cdb)
+{
+ uint8 data_in[10];
+
+ memset(data_in, 0x00, 10);
+
+ data_in[1] = cd.SubQBuf[0];	// Control/ADR
+ data_in[2] = cd.SubQBuf[1];	// Track
+ data_in[3] = cd.SubQBuf[2];	// Index
+ data_in[4] = cd.SubQBuf[3];	// M(rel)
+ data_in[5] = cd.SubQBuf[4];	// S(rel)
+ data_in[6] = cd.SubQBuf[5];	// F(rel)
+ data_in[7] = cd.SubQBuf[7];	// M(abs)
+ data_in[8] = cd.SubQBuf[8];	// S(abs)
+ data_in[9] = cd.SubQBuf[9];	// F(abs)
+
+ if(cdda.CDDAStatus == CDDASTATUS_PAUSED)
+  data_in[0] = 2;		// Pause
+ else if(cdda.CDDAStatus == CDDASTATUS_PLAYING)
+  data_in[0] = 0;		// Playing
+ else
+  data_in[0] = 3;		// Stopped
+
+ DoSimpleDataIn(data_in, 10);
+}
+
+/********************************************************
+*							*
+*	NEC CD Command 0xDE - Get Directory Info	*
+*							*
+********************************************************/
+static void DoNEC_PCE_GETDIRINFO(const uint8 *cdb)
+{
+ uint8 data_in[4];
+ uint32 data_in_size = 0;
+ uint8 m, s, f;
+
+ memset(data_in, 0, sizeof(data_in));
+
+ switch(cdb[1])
+ {
+  default:
+  case 0x0:
+	   data_in[0] = U8_to_BCD(toc.first_track);
+	   data_in[1] = U8_to_BCD(toc.last_track);
+
+	   data_in_size = 2;
+	   break;
+
+  case 0x1:
+	   LBA_to_AMSF(toc.tracks[100].lba, &m, &s, &f);
+
+	   data_in[0] = U8_to_BCD(m);
+	   data_in[1] = U8_to_BCD(s);
+	   data_in[2] = U8_to_BCD(f);
+
+	   data_in_size = 3;
+	   break;
+
+  case 0x2:
+	   {
+	    int track = BCD_to_U8(cdb[2]);
+
+	    if(!track)
+	     track = 1;
+	    else if(cdb[2] == 0xAA)
+	     track = 100;
+	    else if(track > 99)
+	    {
+	     CommandCCError(SENSEKEY_ILLEGAL_REQUEST, NSE_INVALID_PARAMETER);
+	     return;
+	    }
+
+	    LBA_to_AMSF(toc.tracks[track].lba, &m, &s, &f);
+
+	    data_in[0] = U8_to_BCD(m);
+	    data_in[1] = U8_to_BCD(s);
+	    data_in[2] = U8_to_BCD(f);
+	    data_in[3] = toc.tracks[track].control;
+	    data_in_size = 4;
+	   }
+	   break;
+ }
+
+ DoSimpleDataIn(data_in, data_in_size);
+}
+
+#define SCF_REQUIRES_MEDIUM	0x0001
+
+typedef struct
+{
+ uint8 cmd;
+ uint32 flags;
+ void (*func)(const uint8 *cdb);
+ const char *pretty_name;
+} SCSICH;
+
+static const uint8 RequiredCDBLen[16] =
+{
+ 6, // 0x0n
+ 6, // 0x1n
+ 10, // 0x2n
+ 10, // 0x3n
+ 10, // 0x4n
+ 10, // 0x5n
+ 10, // 0x6n
+ 6, // 0x7n
+ 10, // 0x8n
+ 6, // 0x9n
+ 12, // 0xAn
+ 12, // 0xBn
+ 10, // 0xCn
+ 10, // 0xDn
+ 10, // 0xEn
+ 6, // 0xFn
+};
+
+static const SCSICH PCECommandDefs[] =
+{
+ { 0x00, SCF_REQUIRES_MEDIUM, DoTESTUNITREADY, "Test Unit Ready" },
+ { 0x03, 0, DoREQUESTSENSE, "Request Sense" },
+ { 0x08, SCF_REQUIRES_MEDIUM, DoREAD6, "Read(6)" },
+ { 0xD8, SCF_REQUIRES_MEDIUM, DoNEC_PCE_SAPSP, "Set Audio Playback Start Position" },
+ { 0xD9, SCF_REQUIRES_MEDIUM, DoNEC_PCE_SAPEP, "Set Audio Playback End Position" },
+ { 0xDA, SCF_REQUIRES_MEDIUM, DoNEC_PCE_PAUSE, "Pause" },
+ { 0xDD, SCF_REQUIRES_MEDIUM, DoNEC_PCE_READSUBQ, "Read Subchannel Q" },
+ { 0xDE, SCF_REQUIRES_MEDIUM, DoNEC_PCE_GETDIRINFO, "Get Dir Info" },
+
+ { 0xFF, 0, 0, NULL },
+};
+
+static void ExecuteCommand(void)
+{
+ const SCSICH *cmd_info_ptr = PCECommandDefs;
+
+ while(cmd_info_ptr->pretty_name && cmd_info_ptr->cmd != cd.command_buffer[0])
+  cmd_info_ptr++;
+
+ if(cmd_info_ptr->pretty_name == NULL)	// Command not found!
+  CommandCCError(SENSEKEY_ILLEGAL_REQUEST, NSE_INVALID_COMMAND);
+ else if(TrayOpen && (cmd_info_ptr->flags & SCF_REQUIRES_MEDIUM))
+  CommandCCError(SENSEKEY_NOT_READY, NSE_TRAY_OPEN);
+ else if(!Cur_CDIF && (cmd_info_ptr->flags & SCF_REQUIRES_MEDIUM))
+  CommandCCError(SENSEKEY_NOT_READY, NSE_NO_DISC);
+ else if(cd.DiscChanged && (cmd_info_ptr->flags & SCF_REQUIRES_MEDIUM))
+ {
+  CommandCCError(SENSEKEY_UNIT_ATTENTION, NSE_DISC_CHANGED);
+  cd.DiscChanged = false;
+ }
+ else
+  cmd_info_ptr->func(cd.command_buffer);
+
+ cd.command_buffer_pos = 0;
+}
+
+static INLINE void RunCDRead(int32 run_time)
+{
+ if(CDReadTimer <= 0)
+  return;
+
+ CDReadTimer -= run_time;
+
+ if(CDReadTimer > 0)
+  return;
+
+ if(din->CanWrite() < 2048)
+ {
+  // The host hasn't taken the previous sector yet.
+  CDReadTimer += (uint64)2048 * System_Clock / CD_DATA_TRANSFER_RATE;
+  return;
+ }
+
+ uint8 tmp_read_buf[2352];
+
+ if(TrayOpen)
+ {
+  din->Flush();
+  cd.data_transfer_done = false;
+  CommandCCError(SENSEKEY_NOT_READY, NSE_TRAY_OPEN);
+ }
+ else if(!Cur_CDIF)
+ {
+  cd.data_transfer_done = false;
+  CommandCCError(SENSEKEY_NOT_READY, NSE_NO_DISC);
+ }
+ else if(SectorAddr >= toc.tracks[100].lba)
+ {
+  cd.data_transfer_done = false;
+  CommandCCError(SENSEKEY_ILLEGAL_REQUEST, NSE_END_OF_VOLUME);
+ }
+ else if(!IsDataSector(SectorAddr))
+ {
+  cd.data_transfer_done = false;
+  CommandCCError(SENSEKEY_MEDIUM_ERROR, NSE_NOT_DATA_TRACK);
+ }
+ else if(!Cur_CDIF->ReadRawSector(tmp_read_buf, SectorAddr))
+ {
+  cd.data_transfer_done = false;
+  CommandCCError(SENSEKEY_MEDIUM_ERROR, NSE_HEADER_READ_ERROR);
+ }
+ else
+ {
+  din->Write(tmp_read_buf + ((tmp_read_buf[15] == 0x2) ? 24 : 16), 2048);
+  subq_generate(cd.SubQBuf, toc, SectorAddr);
+
+  CDIRQCallback(SCSICD_IRQ_DATA_TRANSFER_READY);
+
+  SectorAddr++;
+  SectorCount--;
+
+  if(CurrentPhase != PHASE_DATA_IN)
+   ChangePhase(PHASE_DATA_IN);
+
+  if(SectorCount)
+  {
+   cd.data_transfer_done = false;
+   CDReadTimer += (uint64)2048 * System_Clock / CD_DATA_TRANSFER_RATE;
+  }
+  else
+   cd.data_transfer_done = true;
+ }
+}
+
+static INLINE void RunCDDA(uint32 system_timestamp, int32 run_time)
+{
+ if(cdda.CDDAStatus != CDDASTATUS_PLAYING)
+  return;
+
+ cdda.CDDADiv -= (int64)run_time << 16;
+
+ while(cdda.CDDADiv <= 0)
+ {
+  const uint32 synthtime = (system_timestamp + (int32)(cdda.CDDADiv >> 16)) / cdda.CDDATimeDiv;
+  int32 sample[2];
+
+  cdda.CDDADiv += cdda.CDDADivAcc;
+
+  if(cdda.CDDAReadPos >= 588)
+  {
+   if(read_sec >= read_sec_end)
+   {
+    switch(cdda.PlayMode)
+    {
+     case PLAYMODE_SILENT:
+     case PLAYMODE_NORMAL:
+	cdda.CDDAStatus = CDDASTATUS_STOPPED;
+	break;
+
+     case PLAYMODE_INTERRUPT:
+	cdda.CDDAStatus = CDDASTATUS_STOPPED;
+	CDIRQCallback(SCSICD_IRQ_DATA_TRANSFER_DONE);
+	break;
+
+     case PLAYMODE_LOOP:
+	read_sec = read_sec_start;
+	if(Cur_CDIF)
+	 Cur_CDIF->HintReadSector(read_sec);
+	break;
+    }
+   }
+
+   // Don't play past the user area of the disc.
+   if(read_sec >= toc.tracks[100].lba || TrayOpen || !Cur_CDIF)
+    cdda.CDDAStatus = CDDASTATUS_STOPPED;
+
+   if(cdda.CDDAStatus == CDDASTATUS_STOPPED)
+   {
+    cdda.RawSample[0] = cdda.RawSample[1] = 0;
+    break;
+   }
+
+   cdda.CDDAReadPos = 0;
+
+   {
+    uint8 tmpbuf[2352];
+
+    Cur_CDIF->ReadRawSector(tmpbuf, read_sec);
+
+    for(int i = 0; i < 588 * 2; i++)
+     cdda.CDDASectorBuffer[i] = MDFN_de16lsb(&tmpbuf[i * 2]);
+   }
+   subq_generate(cd.SubQBuf, toc, read_sec);
+   read_sec++;
+  }
+
+  // Data sectors and silent play aren't heard.
+  sample[0] = sample[1] = 0;
+
+  if(!(cd.SubQBuf[0] & (SUBQ_CTRLF_DATA << 4)) && cdda.PlayMode != PLAYMODE_SILENT)
+  {
+   sample[0] = cdda.CDDASectorBuffer[cdda.CDDAReadPos * 2 + 0];
+   sample[1] = cdda.CDDASectorBuffer[cdda.CDDAReadPos * 2 + 1];
+  }
+
+  for(int i = 0; i < 2; i++)
+  {
+   const int32 out = (sample[i] * cdda.CDDAVolume[i]) >> 16;
+
+   cdda.RawSample[i] = sample[i];
+
+   if(out != cdda.last_sample[i])
+   {
+    CDDASynth.offset_inline(synthtime, out - cdda.last_sample[i], sbuf[i]);
+    cdda.last_sample[i] = out;
+   }
+  }
+
+  cdda.CDDAReadPos++;
+ }
+}
+
+static void RunPhase(void)
+{
+ switch(CurrentPhase)
+ {
+  case PHASE_BUS_FREE:
+	if(SEL_signal)
+	 ChangePhase(PHASE_COMMAND);
+	break;
+
+  case PHASE_COMMAND:
+	if(REQ_signal && ACK_signal)	// Data bus is valid nowww
+	{
+	 cd.command_buffer[cd.command_buffer_pos++] = cd_bus.DB;
+	 SetREQ(false);
+	}
+
+	if(!REQ_signal && !ACK_signal && cd.command_buffer_pos)	// Received at least one byte, what should we do?
+	{
+	 if(cd.command_buffer_pos == RequiredCDBLen[cd.command_buffer[0] >> 4])
+	  ExecuteCommand();
+	 else			// Otherwise, get more data for the command!
+	  SetREQ(true);
+	}
+	break;
+
+  case PHASE_DATA_IN:
+	if(!REQ_signal && !ACK_signal)
+	{
+	 if(!din->CanRead())	// aaand we're done!
+	 {
+	  CDIRQCallback(0x8000 | SCSICD_IRQ_DATA_TRANSFER_READY);
+
+	  if(cd.data_transfer_done)
+	  {
+	   SendStatusAndMessage(STATUS_GOOD, 0x00);
+	   cd.data_transfer_done = false;
+	   CDIRQCallback(SCSICD_IRQ_DATA_TRANSFER_DONE);
+	  }
+	 }
+	 else
+	 {
+	  cd_bus.DB = din->ReadByte();
+	  SetREQ(true);
+	 }
+	}
+
+	if(REQ_signal && ACK_signal)
+	 SetREQ(false);
+	break;
+
+  case PHASE_STATUS:
+	if(REQ_signal && ACK_signal)
+	{
+	 SetREQ(false);
+	 cd.status_sent = true;
+	}
+
+	if(!REQ_signal && !ACK_signal && cd.status_sent)
+	{
+	 // Status sent, so get ready to send the message!
+	 cd.status_sent = false;
+	 cd_bus.DB = cd.message_pending;
+
+	 ChangePhase(PHASE_MESSAGE_IN);
+	}
+	break;
+
+  case PHASE_MESSAGE_IN:
+	if(REQ_signal && ACK_signal)
+	{
+	 SetREQ(false);
+	 cd.message_sent = true;
+	}
+
+	if(!REQ_signal && !ACK_signal && cd.message_sent)
+	{
+	 cd.message_sent = false;
+	 ChangePhase(PHASE_BUS_FREE);
+	}
+	break;
+ }
+}
+
+uint32 SCSICD_Run(scsicd_timestamp_t system_timestamp)
+{
+ int32 run_time = system_timestamp - lastts;
+
+ monotonic_timestamp += run_time;
+ lastts = system_timestamp;
+
+ RunCDRead(run_time);
+ RunCDDA(system_timestamp, run_time);
+
+ if(RST_signal)
+ {
+  if(!cd.last_RST_signal)
+   VirtualReset();
+ }
+ else
+ {
+  // A new phase may be able to go on at once, e.g. the first byte of a data-in phase.
+  int32 old_phase;
+
+  do
+  {
+   old_phase = CurrentPhase;
+   RunPhase();
+  } while(CurrentPhase != old_phase);
+ }
+
+ cd.last_RST_signal = RST_signal;
+
+ int32 next_time = 0x7fffffff;
+
+ if(CDReadTimer > 0 && CDReadTimer < next_time)
+  next_time = CDReadTimer;
+
+ if(cdda.CDDAStatus == CDDASTATUS_PLAYING)
+ {
+  int32 cdda_div_time = (cdda.CDDADiv + 0xFFFF) >> 16;
+
+  if(cdda_div_time > 0 && cdda_div_time < next_time)
+   next_time = cdda_div_time;
+ }
+
+ return(next_time);
+}
+
+void SCSICD_ResetTS(void)
+{
+ lastts = 0;
+}
+
+void SCSICD_GetCDDAValues(int16 &left, int16 &right)
+{
+ if(cdda.CDDAStatus)
+ {
+  left = cdda.RawSample[0];
+  right = cdda.RawSample[1];
+ }
+ else
+  left = right = 0;
+}
+
+void SCSICD_SetTransferRate(uint32 TransferRate)
+{
+ CD_DATA_TRANSFER_RATE = TransferRate;
+}
+
+void SCSICD_SetCDDAVolume(double left, double right)
+{
+ cdda.CDDAVolume[0] = 65536 * left;
+ cdda.CDDAVolume[1] = 65536 * right;
+
+ for(int i = 0; i < 2; i++)
+ {
+  if(cdda.CDDAVolume[i] > 65536)
+   cdda.CDDAVolume[i] = 65536;
+ }
+}
+
+void SCSICD_Init(int CDDATimeDiv, Blip_Buffer *leftbuf, Blip_Buffer *rightbuf, uint32 TransferRate, uint32 SystemClock, void (*IRQFunc)(int))
+{
+ Cur_CDIF = NULL;
+ TrayOpen = false;
+
+ monotonic_timestamp = 0;
+ lastts = 0;
+
+ if(!din)
+  din = new SimpleFIFO<uint8>(2048);
+
+ memset(&cdda, 0, sizeof(cdda_t));
+ cdda.CDDATimeDiv = CDDATimeDiv;
+ cdda.CDDAVolume[0] = cdda.CDDAVolume[1] = 65536;
+ CDDASynth.volume(1.0);
+
+ sbuf[0] = leftbuf;
+ sbuf[1] = rightbuf;
+
+ CD_DATA_TRANSFER_RATE = TransferRate;
+ System_Clock = SystemClock;
+ CDIRQCallback = IRQFunc;
+
+ cdda.CDDADivAcc = (int64)System_Clock * 65536 / 44100;
+}
+
+void SCSICD_Close(void)
+{
+ if(din)
+ {
+  delete din;
+  din = NULL;
+ }
+
+ Cur_CDIF = NULL;
+}
+
+void SCSICD_SetDisc(bool new_tray_open, CDIF *cdif, bool no_emu_side_effects)
+{
+ Cur_CDIF = cdif;
+
+ // Closing the tray.
+ if(TrayOpen && !new_tray_open)
+ {
+  TrayOpen = false;
+
+  if(cdif)
+  {
+   cdif->ReadTOC(&toc);
+
+   if(!no_emu_side_effects)
+   {
+    memset(cd.SubQBuf, 0, sizeof(cd.SubQBuf));
+    cd.DiscChanged = true;
+   }
+  }
+ }
+ else if(!TrayOpen && new_tray_open)	// Opening the tray
+ {
+  TrayOpen = true;
+ }
+}
+
+int SCSICD_StateAction(StateMem* sm, int load, int data_only, const char *sname)
+{
+ SFORMAT StateRegs[] =
+ {
+  SFVARN(cd_bus.DB, "DB"),
+  SFVARN(cd_bus.signals, "Signals"),
+  SFVAR(CurrentPhase),
+
+  SFVARN(cd.last_RST_signal, "last_RST"),
+  SFVARN(cd.message_pending, "message_pending"),
+  SFVARN(cd.status_sent, "status_sent"),
+  SFVARN(cd.message_sent, "message_sent"),
+  SFVARN(cd.key_pending, "key_pending"),
+  SFVARN(cd.asc_pending, "asc_pending"),
+  SFVARN(cd.ascq_pending, "ascq_pending"),
+  SFVARN(cd.fru_pending, "fru_pending"),
+
+  SFARRAYN(cd.command_buffer, 256, "command_buffer"),
+  SFVARN(cd.command_buffer_pos, "command_buffer_pos"),
+  SFVARN(cd.data_transfer_done, "data_transfer_done"),
+  SFVARN(cd.DiscChanged, "DiscChanged"),
+  SFARRAYN(cd.SubQBuf, sizeof(cd.SubQBuf), "SubQBuf"),
+
+  SFVARN(cdda.PlayMode, "PlayMode"),
+  SFARRAY16N(cdda.CDDASectorBuffer, 1176, "CDDASectorBuffer"),
+  SFVARN(cdda.CDDAReadPos, "CDDAReadPos"),
+  SFVARN(cdda.CDDAStatus, "CDDAStatus"),
+  SFVARN(cdda.CDDADiv, "CDDADiv"),
+  SFARRAY16N(cdda.RawSample, 2, "RawSample"),
+  SFVAR(read_sec_start),
+  SFVAR(read_sec),
+  SFVAR(read_sec_end),
+
+  SFVAR(CDReadTimer),
+  SFVAR(SectorAddr),
+  SFVAR(SectorCount),
+
+  SFVAR(monotonic_timestamp),
+  SFVAR(pce_lastsapsp_timestamp),
+
+  SFARRAYN(&din->data[0], din->data.size(), "din_fifo"),
+  SFVARN(din->read_pos, "din_read_pos"),
+  SFVARN(din->in_count, "din_in_count"),
+  SFEND
+ };
+
+ int ret = MDFNSS_StateAction(sm, load, data_only, StateRegs, sname);
+
+ if(load)
+ {
+  din->SaveStatePostLoad();
+  din->write_pos = (din->read_pos + din->in_count) & (din->data.size() - 1);
+
+  if(CurrentPhase < PHASE_BUS_FREE || CurrentPhase > PHASE_MESSAGE_IN)
+   CurrentPhase = PHASE_BUS_FREE;
+
+  if(cdda.CDDAReadPos > 588)
+   cdda.CDDAReadPos = 588;
+
+  if(cdda.CDDADiv > cdda.CDDADivAcc)
+   cdda.CDDADiv = cdda.CDDADivAcc;
+
+  // Point the read-ahead at wherever the drive is now.
+  if(Cur_CDIF)
+  {
+   if(CDReadTimer > 0)
+    Cur_CDIF->HintReadSector(SectorAddr);
+   else if(cdda.CDDAStatus == CDDASTATUS_PLAYING)
+    Cur_CDIF->HintReadSector(read_sec);
+  }
+ }
+
+ return(ret);
+}
@@ -46,8 +46,11 @@ void PCE_PSG::UpdateOutput_Norm(const int32 timestamp, psg_channel *ch)
  samp[0] = dbtable[ch->vl[0]][sv];
  samp[1] = dbtable[ch->vl[1]][sv];
 
- Synth.offset(timestamp, samp[0] - ch->blip_prev_samp[0], sbuf[0]);
- Synth.offset(timestamp, samp[1] - ch->blip_prev_samp[1], sbuf[1]);
+ // A zero delta adds nothing to the buffer.
+ if(samp[0] != ch->blip_prev_samp[0])
+  Synth.offset(timestamp, samp[0] - ch->blip_prev_samp[0], sbuf[0]);
+ if(samp[1] != ch->blip_prev_samp[1])
+  Synth.offset(timestamp, samp[1] - ch->blip_prev_samp[1], sbuf[1]);
 
  ch->blip_prev_samp[0] = samp[0];
  ch->blip_prev_samp[1] = samp[1];
@@ -61,8 +64,11 @@ void PCE_PSG::UpdateOutput_Noise(const int32 timestamp, psg_channel *ch)
  samp[0] = dbtable[ch->vl[0]][sv];
  samp[1] = dbtable[ch->vl[1]][sv];
 
- Synth.offset(timestamp, samp[0] - ch->blip_prev_samp[0], sbuf[0]);
- Synth.offset(timestamp, samp[1] - ch->blip_prev_samp[1], sbuf[1]);
+ // A zero delta adds nothing to the buffer.
+ if(samp[0] != ch->blip_prev_samp[0])
+  Synth.offset(timestamp, samp[0] - ch->blip_prev_samp[0], sbuf[0]);
+ if(samp[1] != ch->blip_prev_samp[1])
+  Synth.offset(timestamp, samp[1] - ch->blip_prev_samp[1], sbuf[1]);
 
  ch->blip_prev_samp[0] = samp[0];
  ch->blip_prev_samp[1] = samp[1];
@@ -74,8 +80,10 @@ void PCE_PSG::UpdateOutput_Off(const int32 timestamp, psg_channel *ch)
 
  samp[0] = samp[1] = 0;
 
- Synth.offset_inline(timestamp, samp[0] - ch->blip_prev_samp[0], sbuf[0]);
- Synth.offset_inline(timestamp, samp[1] - ch->blip_prev_samp[1], sbuf[1]);
+ if(samp[0] != ch->blip_prev_samp[0])
+  Synth.offset_inline(timestamp, samp[0] - ch->blip_prev_samp[0], sbuf[0]);
+ if(samp[1] != ch->blip_prev_samp[1])
+  Synth.offset_inline(timestamp, samp[1] - ch->blip_prev_samp[1], sbuf[1]);
 
  ch->blip_prev_samp[0] = samp[0];
  ch->blip_prev_samp[1] = samp[1];
@@ -89,8 +97,10 @@ void PCE_PSG::UpdateOutput_Accum(const int32 timestamp, psg_channel *ch)
  samp[0] = ((int32)dbtable_volonly[ch->vl[0]] * ((int32)ch->samp_accum - 496)) >> (8 + 5);
  samp[1] = ((int32)dbtable_volonly[ch->vl[1]] * ((int32)ch->samp_accum - 496)) >> (8 + 5);
 
- Synth.offset_inline(timestamp, samp[0] - ch->blip_prev_samp[0], sbuf[0]);
- Synth.offset_inline(timestamp, samp[1] - ch->blip_prev_samp[1], sbuf[1]);
+ if(samp[0] != ch->blip_prev_samp[0])
+  Synth.offset_inline(timestamp, samp[0] - ch->blip_prev_samp[0], sbuf[0]);
+ if(samp[1] != ch->blip_prev_samp[1])
+  Synth.offset_inline(timestamp, samp[1] - ch->blip_prev_samp[1], sbuf[1]);
 
  ch->blip_prev_samp[0] = samp[0];
  ch->blip_prev_samp[1] = samp[1];
@@ -152,6 +162,39 @@ void PCE_PSG::RecalcNoiseFreqCache(int chnum)
  ch->noise_freq_cache = freq;
 }
 
+void PCE_PSG::RecalcWaveRun(int chnum)
+{
+ psg_channel *ch = &channel[chnum];
+ int change = -1;
+
+ // Work backwards around the waveform from an entry that the next one differs from.
+ for(int i = 0; i < 32; i++)
+ {
+  if(ch->waveform[(i + 1) & 0x1F] != ch->waveform[i])
+  {
+   change = i;
+   break;
+  }
+ }
+
+ if(change < 0)
+  memset(ch->wave_run, 31, sizeof(ch->wave_run));
+ else
+ {
+  ch->wave_run[change] = 0;
+
+  for(int i = 1; i < 32; i++)
+  {
+   const int wi = (change - i) & 0x1F;
+   const int next = (wi + 1) & 0x1F;
+
+   ch->wave_run[wi] = (ch->waveform[next] == ch->waveform[wi]) ? (ch->wave_run[next] + 1) : 0;
+  }
+ }
+
+ ch->wave_run_dirty = false;
+}
+
 void PCE_PSG::PeekWave(const unsigned int ch, uint32 Address, uint32 Length, uint8 *Buffer)
 {
  assert(ch <= 5);
@@ -175,6 +218,7 @@ void PCE_PSG::PokeWave(const unsigned int ch, uint32 Address, uint32 Length, con
   channel[ch].samp_accum -= channel[ch].waveform[Address];
   channel[ch].waveform[Address] = *Buffer & 0x1F;
   channel[ch].samp_accum += channel[ch].waveform[Address];
+  channel[ch].wave_run_dirty = true;
   Address++;
   Buffer++;
  }
@@ -524,6 +568,7 @@ void PCE_PSG::Write(int32 timestamp, uint8 A, uint8 V)
 	     ch->samp_accum -= ch->waveform[ch->waveform_index];
              ch->waveform[ch->waveform_index] = V;
 	     ch->samp_accum += ch->waveform[ch->waveform_index];
+	     ch->wave_run_dirty = true;
 	    }
 
             if((ch->control & 0xC0) == 0x00)
@@ -654,7 +699,32 @@ inline void PCE_PSG::RunChannel(int chc, int32 timestamp, const bool LFO_On)
    ch->counter += (ch->freq_cache <= 0xA) ? 0xA : ch->freq_cache;	// Not particularly accurate, but faster.
   }
   else
+  {
    ch->counter += ch->freq_cache;
+
+   // Steps that repeat the level just output leave the output as it is, and so does every step of a silent
+   // channel or one playing noise; take them all at once.
+   if(ch->counter <= 0)
+   {
+    int32 skip = ((0 - ch->counter) / ch->freq_cache) + 1;
+
+    if(&PCE_PSG::UpdateOutput_Norm == ch->UpdateOutput && (ch->vl[0] & ch->vl[1]) != 0x1F)
+    {
+     if(ch->wave_run_dirty)
+      RecalcWaveRun(chc);
+
+     if(ch->wave_run[ch->waveform_index] < 31 && ch->wave_run[ch->waveform_index] < skip)
+      skip = ch->wave_run[ch->waveform_index];
+    }
+
+    if(skip)
+    {
+     ch->counter += skip * ch->freq_cache;
+     ch->waveform_index = (ch->waveform_index + skip) & 0x1F;
+     ch->dda = ch->waveform[ch->waveform_index];
+    }
+   }
+  }
  }
 }
 
@@ -803,6 +873,7 @@ void PCE_PSG::Power(const int32 timestamp)
   channel[ch].vl[1] = 0x1F;
 
   channel[ch].samp_accum = 0;
+  channel[ch].wave_run_dirty = true;
 
   RecalcFreqCache(ch);
   RecalcUOFunc(ch);
@@ -883,6 +954,7 @@ int PCE_PSG::StateAction(StateMem *sm, int load, int data_only)
     channel[ch].waveform[wi] &= 0x1F;
     channel[ch].samp_accum += channel[ch].waveform[wi];
    }
+   channel[ch].wave_run_dirty = true;
 
    for(int lr = 0; lr < 2; lr++)
     channel[ch].vl[lr] &= 0x1F;
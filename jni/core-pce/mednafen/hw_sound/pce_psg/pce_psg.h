@@ -27,6 +27,9 @@ struct psg_channel
 
         int samp_accum;		// The result of adding up all the samples in the waveform buffer(part of an optimization for high-frequency playback).
 
+	uint8 wave_run[32];	// How many of the steps after each waveform entry repeat its value, 31 when they all do.
+	bool wave_run_dirty;	// The waveform has changed since wave_run was calculated.
+
 	int32 blip_prev_samp[2];
 	int32 lastts;
 
@@ -150,6 +153,7 @@ class PCE_PSG
 
 	void RecalcFreqCache(int chnum);
 	void RecalcNoiseFreqCache(int chnum);
+	void RecalcWaveRun(int chnum);
 	void RunChannel(int chc, int32 timestamp, bool LFO_On);
 	double OutputVolume;
 
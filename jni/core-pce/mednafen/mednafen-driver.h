@@ -34,10 +34,11 @@ void MDFND_Sleep(uint32 ms);
 #ifdef WANT_THREADING
 /* Being threading support. */
 // Mostly based off SDL's prototypes and semantics.
-// Driver code should actually define MDFN_Thread and MDFN_Mutex.
+// Driver code should actually define MDFN_Thread, MDFN_Mutex and MDFN_Cond.
 
 struct MDFN_Thread;
 struct MDFN_Mutex;
+struct MDFN_Cond;
 
 MDFN_Thread *MDFND_CreateThread(int (*fn)(void *), void *data);
 void MDFND_WaitThread(MDFN_Thread *thread, int *status);
@@ -48,6 +49,12 @@ void MDFND_DestroyMutex(MDFN_Mutex *mutex);
 int MDFND_LockMutex(MDFN_Mutex *mutex);
 int MDFND_UnlockMutex(MDFN_Mutex *mutex);
 
+MDFN_Cond *MDFND_CreateCond(void);
+void MDFND_DestroyCond(MDFN_Cond *cond);
+// Releases mutex, which must be locked, while waiting; it's locked again on return.
+int MDFND_WaitCond(MDFN_Cond *cond, MDFN_Mutex *mutex);
+int MDFND_SignalCond(MDFN_Cond *cond);
+
 /* End threading support. */
 #endif
 
@@ -116,6 +116,15 @@ void MDFN_ResetMessages(void)
 
 
 #ifdef NEED_CD
+static std::vector<CDIF *> CDInterfaces;	// Owned here from MDFNI_LoadCD() until MDFNI_CloseGame().
+
+static void CloseCDInterfaces(void)
+{
+ for(unsigned i = 0; i < CDInterfaces.size(); i++)
+  delete CDInterfaces[i];
+ CDInterfaces.clear();
+}
+
 static void ReadM3U(std::vector<std::string> &file_list, std::string path, unsigned depth = 0)
 {
  std::vector<std::string> ret;
@@ -155,9 +164,6 @@ static void ReadM3U(std::vector<std::string> &file_list, std::string path, unsig
 MDFNGI *MDFNI_LoadCD(const char *force_module, const char *devicename)
 {
  uint8 LayoutMD5[16];
-#ifdef NEED_CD
- static std::vector<CDIF *> CDInterfaces;	// FIXME: Cleanup on error out.
-#endif
 
  MDFN_printf(_("Loading %s...\n\n"), devicename ? devicename : _("PHYSICAL CD"));
 
@@ -183,6 +189,7 @@ MDFNGI *MDFNI_LoadCD(const char *force_module, const char *devicename)
  {
   MDFND_PrintError(e.what());
   MDFN_PrintError(_("Error opening CD."));
+  CloseCDInterfaces();
   return(0);
  }
 
@@ -241,6 +248,7 @@ MDFNGI *MDFNI_LoadCD(const char *force_module, const char *devicename)
  if(!MDFNGameInfo->LoadCD)
  {
     MDFN_PrintError(_("Specified system \"%s\" doesn't support CDs!"), force_module);
+    CloseCDInterfaces();
     return(0);
  }
 
@@ -251,9 +259,7 @@ MDFNGI *MDFNI_LoadCD(const char *force_module, const char *devicename)
 
  if(!(MDFNGameInfo->LoadCD(&CDInterfaces)))
  {
-  for(unsigned i = 0; i < CDInterfaces.size(); i++)
-   delete CDInterfaces[i];
-  CDInterfaces.clear();
+  CloseCDInterfaces();
 
   MDFNGameInfo = NULL;
   return(0);
@@ -270,6 +276,21 @@ MDFNGI *MDFNI_LoadCD(const char *force_module, const char *devicename)
 // MDFN_LoadGameCheats(NULL);
  MDFNMP_InstallReadPatches();
 
+ if(!MDFNGameInfo->name && devicename)
+ {
+  char *tmp;
+
+  MDFNGameInfo->name = (UTF8 *)strdup(GetFNComponent(devicename));
+
+  for(unsigned x = 0; x < strlen((char *)MDFNGameInfo->name); x++)
+  {
+   if(MDFNGameInfo->name[x] == '_')
+    MDFNGameInfo->name[x] = ' ';
+  }
+  if((tmp = strrchr((char *)MDFNGameInfo->name, '.')))
+   *tmp = 0;
+ }
+
  return(MDFNGameInfo);
 }
 #endif
@@ -281,7 +302,7 @@ MDFNGI *MDFNI_LoadGame(const char *force_module, const char *name)
    MDFNGameInfo = MDFNGI_CORE;
 
 #ifdef NEED_CD
-	if(strlen(name) > 4 && (!strcasecmp(name + strlen(name) - 4, ".cue") || !strcasecmp(name + strlen(name) - 4, ".toc") || !strcasecmp(name + strlen(name) - 4, ".m3u")))
+	if(strlen(name) > 4 && (!strcasecmp(name + strlen(name) - 4, ".cue") || !strcasecmp(name + strlen(name) - 4, ".toc") || !strcasecmp(name + strlen(name) - 4, ".iso") || !strcasecmp(name + strlen(name) - 4, ".m3u")))
 	 return(MDFNI_LoadCD(force_module, name));
 #endif
 
@@ -352,6 +373,19 @@ MDFNGI *MDFNI_LoadGame(const char *force_module, const char *name)
    return(MDFNGameInfo);
 }
 
+void MDFNI_CloseGame(void)
+{
+ if(!MDFNGameInfo)
+  return;
+
+ MDFNGameInfo->CloseGame();
+
+#ifdef NEED_CD
+ // After CloseGame(), so the emulation code is done with the discs.
+ CloseCDInterfaces();
+#endif
+}
+
 
 bool MDFNI_InitializeModule(void)
 {
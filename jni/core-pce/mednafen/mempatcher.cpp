@@ -67,6 +67,40 @@ static bool CheatsActive = TRUE;
 bool SubCheatsOn = 0;
 std::vector<SUBCHEAT> SubCheats[8];
 
+// Active 'R' cheats, compiled down to the bytes MDFNMP_ApplyPeriodicCheats() writes each frame.
+typedef struct
+{
+ uint8 *ptr;
+ uint8 value;
+ const char *conditions;	// Set on the first byte of a cheat with conditions, which gate all "count" of its bytes.
+ uint32 count;
+} PERIODICCHEAT;
+
+static std::vector<PERIODICCHEAT> PeriodicCheats;
+
+static void AddSubCheat(const CHEATF *chit)
+{
+ for(unsigned int x = 0; x < chit->length; x++)
+ {
+  SUBCHEAT tmpsub;
+  unsigned int shiftie;
+
+  if(chit->bigendian)
+   shiftie = (chit->length - 1 - x) * 8;
+  else
+   shiftie = x * 8;
+  
+  tmpsub.addr = chit->addr + x;
+  tmpsub.value = (chit->val >> shiftie) & 0xFF;
+  if(chit->type == 'C')
+   tmpsub.compare = (chit->compare >> shiftie) & 0xFF;
+  else
+   tmpsub.compare = -1;
+  SubCheats[(chit->addr + x) & 0x7].push_back(tmpsub);
+  SubCheatsOn = 1;
+ }
+}
+
 static void RebuildSubCheats(void)
 {
  std::vector<CHEATF>::iterator chit;
@@ -80,28 +114,55 @@ static void RebuildSubCheats(void)
  for(chit = cheats.begin(); chit != cheats.end(); chit++)
  {
   if(chit->status && chit->type != 'R')
+   AddSubCheat(&*chit);
+ }
+}
+
+static void AddPeriodicCheat(const CHEATF *chit)
+{
+ const size_t first = PeriodicCheats.size();
+
+ for(unsigned int x = 0; x < chit->length; x++)
+ {
+  uint32 page = ((chit->addr + x) / PageSize) % NumPages;
+  if(RAMPtrs[page])
   {
-   for(unsigned int x = 0; x < chit->length; x++)
-   {
-    SUBCHEAT tmpsub;
-    unsigned int shiftie;
+   PERIODICCHEAT pc;
+   uint64 tmpval = chit->val;
 
-    if(chit->bigendian)
-     shiftie = (chit->length - 1 - x) * 8;
-    else
-     shiftie = x * 8;
-    
-    tmpsub.addr = chit->addr + x;
-    tmpsub.value = (chit->val >> shiftie) & 0xFF;
-    if(chit->type == 'C')
-     tmpsub.compare = (chit->compare >> shiftie) & 0xFF;
-    else
-     tmpsub.compare = -1;
-    SubCheats[(chit->addr + x) & 0x7].push_back(tmpsub);
-    SubCheatsOn = 1;
-   }
+   if(chit->bigendian)
+    tmpval >>= (chit->length - 1 - x) * 8;
+   else
+    tmpval >>= x * 8;
+
+   pc.ptr = &RAMPtrs[page][(chit->addr + x) % PageSize];
+   pc.value = tmpval;
+   pc.conditions = NULL;
+   pc.count = 1;
+   PeriodicCheats.push_back(pc);
   }
  }
+
+ if(chit->conditions && PeriodicCheats.size() > first)
+ {
+  PeriodicCheats[first].conditions = chit->conditions;
+  PeriodicCheats[first].count = PeriodicCheats.size() - first;
+ }
+}
+
+static void RebuildPeriodicCheats(void)
+{
+ std::vector<CHEATF>::iterator chit;
+
+ PeriodicCheats.clear();
+
+ if(!CheatsActive || !RAMPtrs) return;
+
+ for(chit = cheats.begin(); chit != cheats.end(); chit++)
+ {
+  if(chit->status && chit->type == 'R')
+   AddPeriodicCheat(&*chit);
+ }
 }
 
 bool MDFNMP_Init(uint32 ps, uint32 numpages)
@@ -118,6 +179,8 @@ bool MDFNMP_Init(uint32 ps, uint32 numpages)
 
 void MDFNMP_Kill(void)
 {
+ PeriodicCheats.clear();
+
  if(CheatComp)
  {
   free(CheatComp);
@@ -143,6 +206,8 @@ void MDFNMP_AddRAM(uint32 size, uint32 A, uint8 *RAM)
   if(RAM) // Don't increment the RAM pointer if we're passed a NULL pointer
    RAM += PageSize;
  }
+
+ RebuildPeriodicCheats();
 }
 
 void MDFNMP_InstallReadPatches(void)
@@ -314,6 +379,7 @@ void MDFN_LoadGameCheats(void *override_ptr)
  }
 
  RebuildSubCheats();
+ RebuildPeriodicCheats();
 
  if(!override)
  {
@@ -449,6 +515,7 @@ void MDFN_FlushGameCheats(int nosave)
  }
 */
  RebuildSubCheats();
+ RebuildPeriodicCheats();
 }
 
 int MDFNI_AddCheat(const char *name, uint32 addr, uint64 val, uint64 compare, char type, unsigned int length, bool bigendian)
@@ -469,23 +536,47 @@ int MDFNI_AddCheat(const char *name, uint32 addr, uint64 val, uint64 compare, ch
 
  savecheats = 1;
 
- MDFNMP_RemoveReadPatches();
- RebuildSubCheats();
- MDFNMP_InstallReadPatches();
+ // The new cheat only adds to what's compiled and patched already.
+ if(CheatsActive)
+ {
+  const CHEATF *chit = &cheats.back();
+
+  if(chit->type == 'R')
+  {
+   if(RAMPtrs)
+    AddPeriodicCheat(chit);
+  }
+  else
+  {
+   AddSubCheat(chit);
+
+   if(MDFNGameInfo->InstallReadPatch)
+    for(unsigned int x = 0; x < chit->length; x++)
+     MDFNGameInfo->InstallReadPatch(chit->addr + x);
+  }
+ }
 
  return(1);
 }
 
 int MDFNI_DelCheat(uint32 which)
 {
+ const bool was_sub = cheats[which].status && cheats[which].type != 'R';
+ const bool was_periodic = cheats[which].status && cheats[which].type == 'R';
+
  free(cheats[which].name);
  cheats.erase(cheats.begin() + which);
 
  savecheats=1;
 
- MDFNMP_RemoveReadPatches();
- RebuildSubCheats();
- MDFNMP_InstallReadPatches();
+ if(was_sub)
+ {
+  MDFNMP_RemoveReadPatches();
+  RebuildSubCheats();
+  MDFNMP_InstallReadPatches();
+ }
+ else if(was_periodic)
+  RebuildPeriodicCheats();
 
  return(1);
 }
@@ -633,35 +724,20 @@ static bool TestConditions(const char *string)
 
 void MDFNMP_ApplyPeriodicCheats(void)
 {
- std::vector<CHEATF>::iterator chit;
-
-
- if(!CheatsActive)
-  return;
-
  //TestConditions("2 L 0x1F00F5 == 0xDEAD");
  //if(TestConditions("1 L 0x1F0058 > 0")) //, 1 L 0xC000 == 0x01"));
- for(chit = cheats.begin(); chit != cheats.end(); chit++)
+ for(size_t i = 0; i < PeriodicCheats.size(); )
  {
-  if(chit->status && chit->type == 'R')
-  {
-   if(!chit->conditions || TestConditions(chit->conditions))
-    for(unsigned int x = 0; x < chit->length; x++)
-    {
-     uint32 page = ((chit->addr + x) / PageSize) % NumPages;
-     if(RAMPtrs[page])
-     {
-      uint64 tmpval = chit->val;
+  const PERIODICCHEAT *pc = &PeriodicCheats[i];
 
-      if(chit->bigendian)
-       tmpval >>= (chit->length - 1 - x) * 8;
-      else
-       tmpval >>= x * 8;
-
-      RAMPtrs[page][(chit->addr + x) % PageSize] = tmpval;
-     }
-   }
+  if(pc->conditions && !TestConditions(pc->conditions))
+  {
+   i += pc->count;
+   continue;
   }
+
+  *pc->ptr = pc->value;
+  i++;
  }
 }
 
@@ -870,6 +946,8 @@ int MDFNI_DecodePAR(const char *str, uint32 *a, uint8 *v, uint8 *c, char *type)
 int MDFNI_SetCheat(uint32 which, const char *name, uint32 a, uint64 v, uint64 compare, int s, char type, unsigned int length, bool bigendian)
 {
  CHEATF *next = &cheats[which];
+ const bool was_sub = next->status && next->type != 'R';
+ const bool was_periodic = next->status && next->type == 'R';
 
  if(name)
  {
@@ -891,7 +969,10 @@ int MDFNI_SetCheat(uint32 which, const char *name, uint32 a, uint64 v, uint64 co
  next->length = length;
  next->bigendian = bigendian;
 
- RebuildSubCheats();
+ if(was_sub || (s && type != 'R'))
+  RebuildSubCheats();
+ if(was_periodic || (s && type == 'R'))
+  RebuildPeriodicCheats();
  savecheats=1;
 
  return(1);
@@ -902,7 +983,11 @@ int MDFNI_ToggleCheat(uint32 which)
 {
  cheats[which].status = !cheats[which].status;
  savecheats = 1;
- RebuildSubCheats();
+
+ if(cheats[which].type == 'R')
+  RebuildPeriodicCheats();
+ else
+  RebuildSubCheats();
 
  return(cheats[which].status);
 }
@@ -1110,6 +1195,7 @@ static void SettingChanged(const char *name)
  CheatsActive = MDFN_GetSettingB("cheats");
 
  RebuildSubCheats();
+ RebuildPeriodicCheats();
 
  MDFNMP_InstallReadPatches();
 }
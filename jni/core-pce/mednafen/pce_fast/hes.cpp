@@ -158,6 +158,7 @@ int PCE_HESLoad(const uint8 *buf, uint32 size)
  for(int x = 0; x < 0x80; x++)
  {
   HuCPUFastMap[x] = rom;
+  HuCPUDirectMapR[x] = rom;
   PCERead[x] = HESROMRead;
   PCEWrite[x] = HESROMWrite;
  }
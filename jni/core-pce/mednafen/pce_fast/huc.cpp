@@ -19,11 +19,11 @@
 
 #include "pce.h"
 #include <errno.h>
-//#include "../cdrom/pcecd.h"
+#include "../cdrom/pcecd.h"
 #include <arcade_card/arcade_card.h>
 #include "../md5.h"
 #include "../file.h"
-//#include "../cdrom/cdromif.h"
+#include "../cdrom/cdromif.h"
 #include "../mempatcher.h"
 
 namespace PCE_Fast
@@ -54,7 +54,7 @@ static DECLFR(ACPhysRead)
 
 static DECLFR(SaveRAMRead)
 {
- if((!PCE_IsCD/* || PCECD_IsBRAMEnabled()*/) && (A & 8191) < 2048)
+ if((!PCE_IsCD || PCECD_IsBRAMEnabled()) && (A & 8191) < 2048)
   return(SaveRAM[A & 2047]);
  else
   return(0xFF);
@@ -62,7 +62,7 @@ static DECLFR(SaveRAMRead)
 
 static DECLFW(SaveRAMWrite)
 {
- if((!PCE_IsCD/* || PCECD_IsBRAMEnabled()*/) && (A & 8191) < 2048)
+ if((!PCE_IsCD || PCECD_IsBRAMEnabled()) && (A & 8191) < 2048)
   SaveRAM[A & 2047] = V;
 }
 
@@ -157,6 +157,7 @@ int HuCLoad(const uint8 *data, uint32 len, uint32 crc32)
  for(int x = 0x00; x < 0x80; x++)
  {
   HuCPUFastMap[x] = ROMSpace;
+  HuCPUDirectMapR[x] = ROMSpace;
   PCERead[x] = HuCRead;
  }
 
@@ -180,6 +181,7 @@ int HuCLoad(const uint8 *data, uint32 len, uint32 crc32)
   for(int x = 0x40; x < 0x44; x++)
   {
    HuCPUFastMap[x] = &PopRAM[(x & 3) * 8192] - x * 8192;
+   HuCPUDirectMapW[x] = ROMSpace;
    PCERead[x] = HuCRead;
    PCEWrite[x] = HuCRAMWrite;
   }
@@ -239,6 +241,7 @@ int HuCLoad(const uint8 *data, uint32 len, uint32 crc32)
   {
    // FIXME: PCE_FAST
    HuCPUFastMap[x] = NULL; // Make sure our reads go through our read function, and not a table lookup
+   HuCPUDirectMapR[x] = NULL;
    PCERead[x] = HuCSF2Read;
   }
   PCEWrite[0] = HuCSF2Write;
@@ -259,7 +262,7 @@ bool IsBRAMUsed(void)
 
  return(0);
 }
-/*
+
 int HuCLoadCD(const char *bios_path)
 {
  static const FileExtensionSpecStruct KnownBIOSExtensions[] =
@@ -283,6 +286,7 @@ int HuCLoadCD(const char *bios_path)
 
  fp.Close();
 
+ IsPopulous = 0;
  PCE_IsCD = 1;
  PCE_InitCD();
 
@@ -325,16 +329,20 @@ int HuCLoadCD(const char *bios_path)
  for(int x = 0; x < 0x40; x++)
  {
   HuCPUFastMap[x] = ROMSpace;
+  HuCPUDirectMapR[x] = ROMSpace;
   PCERead[x] = HuCRead;
  }
 
  for(int x = 0x68; x < 0x88; x++)
  {
   HuCPUFastMap[x] = ROMSpace;
+  HuCPUDirectMapR[x] = ROMSpace;
+  HuCPUDirectMapW[x] = ROMSpace;
   PCERead[x] = HuCRead;
   PCEWrite[x] = HuCRAMWrite;
  }
  PCEWrite[0x80] = HuCRAMWriteCDSpecial; 	// Hyper Dyne Special hack
+ HuCPUDirectMapW[0x80] = NULL;
  MDFNMP_AddRAM(262144, 0x68 * 8192, ROMSpace + 0x68 * 8192);
 
  if(PCE_ACEnabled)
@@ -353,28 +361,22 @@ int HuCLoadCD(const char *bios_path)
   for(int x = 0x40; x < 0x44; x++)
   {
    HuCPUFastMap[x] = NULL;
+   HuCPUDirectMapR[x] = NULL;
+   HuCPUDirectMapW[x] = NULL;
    PCERead[x] = ACPhysRead;
    PCEWrite[x] = ACPhysWrite;
   }
  }
 
- FILE * srp;
-
  memset(SaveRAM, 0x00, 2048);
  memcpy(SaveRAM, BRAM_Init_String, 8);	// So users don't have to manually intialize the file cabinet
 						// in the CD BIOS screen.
-
- if((srp = fopen(MDFN_MakeFName(MDFNMKF_SAV, 0, "sav").c_str(), "rb")))
- {
-  fread(SaveRAM, 2048, 1, srp);
-  fclose(srp);
- }
  PCEWrite[0xF7] = SaveRAMWrite;
  PCERead[0xF7] = SaveRAMRead;
  MDFNMP_AddRAM(2048, 0xF7 * 8192, SaveRAM);
  return(1);
 }
-*/
+
 int HuC_StateAction(StateMem *sm, int load, int data_only)
 {
  SFORMAT StateRegs[] = 
@@ -390,7 +392,7 @@ int HuC_StateAction(StateMem *sm, int load, int data_only)
 
  if(load)
   HuCSF2Latch &= 0x3;
-/*
+
  if(PCE_IsCD)
  {
   ret &= PCECD_StateAction(sm, load, data_only);
@@ -398,7 +400,7 @@ int HuC_StateAction(StateMem *sm, int load, int data_only)
   if(arcade_card)
    ret &= arcade_card->StateAction(sm, load, data_only);
  }
-*/ 
+
  return(ret);
 }
 
@@ -427,12 +429,12 @@ void HuCClose(void)
   delete arcade_card;
   arcade_card = NULL;
  }
-/*
+
  if(PCE_IsCD)
  {
   PCECD_Close();
  }
-*/
+
  if(HuCROM)
  {
   MDFN_free(HuCROM);
@@ -442,10 +444,9 @@ void HuCClose(void)
 
 void HuC_Power(void)
 {
-/*	
  if(PCE_IsCD)
   memset(ROMSpace + 0x68 * 8192, 0x00, 262144);
-*/
+
  if(arcade_card)
   arcade_card->Power();
 }
@@ -23,6 +23,8 @@ namespace PCE_Fast
 
 HuC6280 HuCPU;
 uint8 *HuCPUFastMap[0x100];
+uint8 *HuCPUDirectMapR[0x100];
+uint8 *HuCPUDirectMapW[0x100];
 
 #define HU_PC              PC_local //HuCPU.PC
 #define HU_PC_base	 HuCPU.PC_base
@@ -117,6 +119,37 @@ uint8 *HuCPUFastMap[0x100];
 // If we change this definition, we'll need to also fix HuC6280_StealCycle() in huc6280.h
 #define ADDCYC(x) { HuCPU.timestamp += x; }
 
+#ifndef HUC6280_EXTRA_CRAZY
+ #define FixPC_OP() FixPC_PC()
+#else
+ #define FixPC_OP()
+#endif
+
+// Opcode handlers in huc6280_ops.inc start with HU_OP() and end with HU_OP_END.
+// With threaded dispatch each handler fetches the next opcode and jumps to its
+// handler itself, and only falls out of the switch for interrupts and events.
+#ifdef HUC6280_THREADED
+ #define HU_OP(n)	case n: op_##n:
+ #define HU_OP_NEXT	{							\
+			 if(HuCPU.timestamp < next_event && !HU_IRQlow)	\
+			 {						\
+			  FixPC_OP();					\
+			  HU_PI = HU_P;					\
+			  HuCPU.IRQMaskDelay = HuCPU.IRQMask;		\
+			  b1 = RdAtPC();				\
+			  ADDCYC(CycTable[b1]);				\
+			  IncPC();					\
+			  goto *OpTable[b1];				\
+			 }						\
+			 break;						\
+			}
+#else
+ #define HU_OP(n)	case n:
+ #define HU_OP_NEXT	break
+#endif
+#define HU_OP_DEFAULT	default:
+#define HU_OP_END	HU_OP_NEXT
+
 static uint8 dummy_bank[8192 + 8192];  // + 8192 for PC-as-ptr safety padding
 
 #define SET_MPR(arg_i, arg_v)				\
@@ -130,6 +163,8 @@ static uint8 dummy_bank[8192 + 8192];  // + 8192 for PC-as-ptr safety padding
  }							\
  HuCPU.MPR[wmpr] = wbank;					\
  HuCPU.FastPageR[wmpr] = HuCPUFastMap[wbank] ? (HuCPUFastMap[wbank] + wbank * 8192) - wmpr * 8192 : (dummy_bank - wmpr * 8192);	\
+ HuCPU.DirectPageR[wmpr] = HuCPUDirectMapR[wbank] ? (HuCPUDirectMapR[wbank] + wbank * 8192) - wmpr * 8192 : NULL;	\
+ HuCPU.DirectPageW[wmpr] = HuCPUDirectMapW[wbank] ? (HuCPUDirectMapW[wbank] + wbank * 8192) - wmpr * 8192 : NULL;	\
 }
 
 void HuC6280_SetMPR(int i, int v)
@@ -150,6 +185,11 @@ static void HuC6280_FlushMPRCache(void)
 
 static INLINE uint8 RdMem(unsigned int A)
 {
+ const uint8 *direct = HuCPU.DirectPageR[A >> 13];
+
+ if(direct)
+  return(direct[A]);
+
  uint8 wmpr = HuCPU.MPR[A >> 13];
  return(PCERead[wmpr]((wmpr << 13) | (A & 0x1FFF)));
 }
@@ -161,6 +201,14 @@ static INLINE uint16 RdMem16(unsigned int A)
 
 static INLINE void WrMem(unsigned int A, uint8 V)
 {
+ uint8 *direct = HuCPU.DirectPageW[A >> 13];
+
+ if(direct)
+ {
+  direct[A] = V;
+  return;
+ }
+
  uint8 wmpr = HuCPU.MPR[A >> 13];
  PCEWrite[wmpr]((wmpr << 13) | (A & 0x1FFF), V);
 }
@@ -430,29 +478,29 @@ static INLINE uint8 RdOp(unsigned int A)
    redundant) on the variable "x".
 */
 
-#define RMW_A(op) {uint8 x=HU_A; op; HU_A=x; break; } /* Meh... */
-#define RMW_AB(op) {unsigned int EA; uint8 x; GetAB(EA); x=RdMem(EA); op; WrMem(EA,x); break; }
-#define RMW_ABI(reg,op) {unsigned int EA; uint8 x; GetABI(EA,reg); x=RdMem(EA); op; WrMem(EA,x); break; }
+#define RMW_A(op) {uint8 x=HU_A; op; HU_A=x; HU_OP_END; } /* Meh... */
+#define RMW_AB(op) {unsigned int EA; uint8 x; GetAB(EA); x=RdMem(EA); op; WrMem(EA,x); HU_OP_END; }
+#define RMW_ABI(reg,op) {unsigned int EA; uint8 x; GetABI(EA,reg); x=RdMem(EA); op; WrMem(EA,x); HU_OP_END; }
 #define RMW_ABX(op)	RMW_ABI(HU_X,op)
 #define RMW_ABY(op)	RMW_ABI(HU_Y,op)
-#define RMW_IND(op) { unsigned int EA; uint8 x; GetIND(EA); x = RdMem(EA); op; WrMem(EA, x); break; }
-#define RMW_IX(op)  { unsigned int EA; uint8 x; GetIX(EA); x=RdMem(EA); op; WrMem(EA,x); break; }
-#define RMW_IY(op)  { unsigned int EA; uint8 x; GetIY(EA); x=RdMem(EA); op; WrMem(EA,x); break; }
-#define RMW_ZP(op)  { uint8 EA; uint8 x; GetZP(EA); x=HU_Page1[EA]; op; HU_Page1[EA] = x; break; }
-#define RMW_ZPX(op) { uint8 EA; uint8 x; GetZPI(EA,HU_X); x=HU_Page1[EA]; op; HU_Page1[EA] = x; break;}
-
-#define LD_IM(op)	{ uint8 x; x=RdAtPC(); IncPC(); op; break; }
-#define LD_ZP(op)	{ uint8 EA; uint8 x; GetZP(EA); x=HU_Page1[EA]; op; break; }
-#define LD_ZPX(op) 	{ uint8 EA; uint8 x; GetZPI(EA,HU_X); x=HU_Page1[EA]; op; break; }
-#define LD_ZPY(op)  	{ uint8 EA; uint8 x; GetZPI(EA,HU_Y); x=HU_Page1[EA]; op; break; }
-#define LD_AB(op)	{ unsigned int EA; uint8 x; GetAB(EA); x=RdMem(EA); op; break; }
-#define LD_ABI(reg,op)  { unsigned int EA; uint8 x; GetABI(EA,reg); x=RdMem(EA); op; break; }
+#define RMW_IND(op) { unsigned int EA; uint8 x; GetIND(EA); x = RdMem(EA); op; WrMem(EA, x); HU_OP_END; }
+#define RMW_IX(op)  { unsigned int EA; uint8 x; GetIX(EA); x=RdMem(EA); op; WrMem(EA,x); HU_OP_END; }
+#define RMW_IY(op)  { unsigned int EA; uint8 x; GetIY(EA); x=RdMem(EA); op; WrMem(EA,x); HU_OP_END; }
+#define RMW_ZP(op)  { uint8 EA; uint8 x; GetZP(EA); x=HU_Page1[EA]; op; HU_Page1[EA] = x; HU_OP_END; }
+#define RMW_ZPX(op) { uint8 EA; uint8 x; GetZPI(EA,HU_X); x=HU_Page1[EA]; op; HU_Page1[EA] = x; HU_OP_END;}
+
+#define LD_IM(op)	{ uint8 x; x=RdAtPC(); IncPC(); op; HU_OP_END; }
+#define LD_ZP(op)	{ uint8 EA; uint8 x; GetZP(EA); x=HU_Page1[EA]; op; HU_OP_END; }
+#define LD_ZPX(op) 	{ uint8 EA; uint8 x; GetZPI(EA,HU_X); x=HU_Page1[EA]; op; HU_OP_END; }
+#define LD_ZPY(op)  	{ uint8 EA; uint8 x; GetZPI(EA,HU_Y); x=HU_Page1[EA]; op; HU_OP_END; }
+#define LD_AB(op)	{ unsigned int EA; uint8 x; GetAB(EA); x=RdMem(EA); op; HU_OP_END; }
+#define LD_ABI(reg,op)  { unsigned int EA; uint8 x; GetABI(EA,reg); x=RdMem(EA); op; HU_OP_END; }
 #define LD_ABX(op)	LD_ABI(HU_X,op)
 #define LD_ABY(op)	LD_ABI(HU_Y,op)
 
-#define LD_IND(op)	{ unsigned int EA; uint8 x; GetIND(EA); x=RdMem(EA); op; break; }
-#define LD_IX(op)	{ unsigned int EA; uint8 x; GetIX(EA); x=RdMem(EA); op; break; }
-#define LD_IY(op)	{ unsigned int EA; uint8 x; GetIY(EA); x=RdMem(EA); op; break; }
+#define LD_IND(op)	{ unsigned int EA; uint8 x; GetIND(EA); x=RdMem(EA); op; HU_OP_END; }
+#define LD_IX(op)	{ unsigned int EA; uint8 x; GetIX(EA); x=RdMem(EA); op; HU_OP_END; }
+#define LD_IY(op)	{ unsigned int EA; uint8 x; GetIY(EA); x=RdMem(EA); op; HU_OP_END; }
 
 #define BMT_PREHONK(pork) HuCPU.in_block_move = IBM_##pork;
 #define BMT_HONKHONK(pork) if(HuCPU.timestamp >= next_user_event) goto GetOutBMT; continue_the_##pork:
@@ -464,19 +512,19 @@ static INLINE uint8 RdOp(unsigned int A)
 #define BMT_TIN BMT_PREHONK(TIN); do { ADDCYC(HuCPU.bmt_cycles); WrMem(HuCPU.bmt_dest, RdMem(HuCPU.bmt_src)); HuCPU.bmt_src++; BMT_HONKHONK(TIN); HuCPU.bmt_length--; } while(HuCPU.bmt_length);
 
 // Block memory transfer load
-#define LD_BMT(op)	{ PUSH(HU_Y); PUSH(HU_A); PUSH(HU_X); GetAB(HuCPU.bmt_src); GetAB(HuCPU.bmt_dest); GetAB(HuCPU.bmt_length); op; HuCPU.in_block_move = 0; HU_X = POP(); HU_A = POP(); HU_Y = POP(); break; }
+#define LD_BMT(op)	{ PUSH(HU_Y); PUSH(HU_A); PUSH(HU_X); GetAB(HuCPU.bmt_src); GetAB(HuCPU.bmt_dest); GetAB(HuCPU.bmt_length); op; HuCPU.in_block_move = 0; HU_X = POP(); HU_A = POP(); HU_Y = POP(); HU_OP_END; }
 
-#define ST_ZP(r)	{uint8 EA; GetZP(EA); HU_Page1[EA] = r; break;}
-#define ST_ZPX(r)	{uint8 EA; GetZPI(EA,HU_X); HU_Page1[EA] = r; break;}
-#define ST_ZPY(r)	{uint8 EA; GetZPI(EA,HU_Y); HU_Page1[EA] = r; break;}
-#define ST_AB(r)	{unsigned int EA; GetAB(EA); WrMem(EA, r); break;}
-#define ST_ABI(reg,r)	{unsigned int EA; GetABI(EA,reg); WrMem(EA,r); break; }
+#define ST_ZP(r)	{uint8 EA; GetZP(EA); HU_Page1[EA] = r; HU_OP_END;}
+#define ST_ZPX(r)	{uint8 EA; GetZPI(EA,HU_X); HU_Page1[EA] = r; HU_OP_END;}
+#define ST_ZPY(r)	{uint8 EA; GetZPI(EA,HU_Y); HU_Page1[EA] = r; HU_OP_END;}
+#define ST_AB(r)	{unsigned int EA; GetAB(EA); WrMem(EA, r); HU_OP_END;}
+#define ST_ABI(reg,r)	{unsigned int EA; GetABI(EA,reg); WrMem(EA,r); HU_OP_END; }
 #define ST_ABX(r)	ST_ABI(HU_X,r)
 #define ST_ABY(r)	ST_ABI(HU_Y,r)
 
-#define ST_IND(r)	{unsigned int EA; GetIND(EA); WrMem(EA,r); break; }
-#define ST_IX(r)	{unsigned int EA; GetIX(EA); WrMem(EA,r); break; }
-#define ST_IY(r)	{unsigned int EA; GetIY(EA); WrMem(EA,r); break; }
+#define ST_IND(r)	{unsigned int EA; GetIND(EA); WrMem(EA,r); HU_OP_END; }
+#define ST_IX(r)	{unsigned int EA; GetIX(EA); WrMem(EA,r); HU_OP_END; }
+#define ST_IY(r)	{unsigned int EA; GetIY(EA); WrMem(EA,r); HU_OP_END; }
 
 static const uint8 CycTable[256] =
 {                             
@@ -601,6 +649,8 @@ void HuC6280_Power(void)
  {
   HuCPU.MPR[i] = 0;
   HuCPU.FastPageR[i] = NULL;
+  HuCPU.DirectPageR[i] = NULL;
+  HuCPU.DirectPageW[i] = NULL;
  }  
  HuC6280_Reset();
 }
@@ -613,6 +663,17 @@ void HuC6280_Run(int32 cycles)
 
 	LOAD_LOCALS();
 
+	#ifdef HUC6280_THREADED
+	#define HU_OP_ROW(h)	&&op_##h##0, &&op_##h##1, &&op_##h##2, &&op_##h##3, &&op_##h##4, &&op_##h##5, &&op_##h##6, &&op_##h##7,	\
+				&&op_##h##8, &&op_##h##9, &&op_##h##A, &&op_##h##B, &&op_##h##C, &&op_##h##D, &&op_##h##E, &&op_##h##F
+	static const void *const OpTable[256] =
+	{
+	 HU_OP_ROW(0x0), HU_OP_ROW(0x1), HU_OP_ROW(0x2), HU_OP_ROW(0x3), HU_OP_ROW(0x4), HU_OP_ROW(0x5), HU_OP_ROW(0x6), HU_OP_ROW(0x7),
+	 HU_OP_ROW(0x8), HU_OP_ROW(0x9), HU_OP_ROW(0xA), HU_OP_ROW(0xB), HU_OP_ROW(0xC), HU_OP_ROW(0xD), HU_OP_ROW(0xE), HU_OP_ROW(0xF)
+	};
+	#undef HU_OP_ROW
+	#endif
+
 	if(HuCPU.timestamp >= next_user_event)
 	 return;
 
@@ -692,9 +753,7 @@ void HuC6280_Run(int32 cycles)
            #include "huc6280_ops.inc"
           } 
 
-	  #ifndef HUC6280_EXTRA_CRAZY
- 	  FixPC_PC();
-	  #endif
+	  FixPC_OP();
 	 }	// end while(HuCPU.timestamp < next_event)
 
 	 while(HuCPU.timestamp >= HuCPU.timer_next_timestamp)
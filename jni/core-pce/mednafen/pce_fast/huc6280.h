@@ -5,6 +5,12 @@
 
 #define HUC6280_LAZY_FLAGS
 
+// Opcode handlers jump straight to the next one through a table of label
+// addresses(computed goto) instead of going back through the switch.
+#ifdef __GNUC__
+#define HUC6280_THREADED
+#endif
+
 namespace PCE_Fast
 {
 
@@ -23,6 +29,8 @@ typedef struct __HuC6280
 	#endif
 	uint8 MPR[9];		// 8, + 1 for PC overflow from $ffff to $10000
 	uint8 *FastPageR[9];
+	uint8 *DirectPageR[9];	// NULL where the bank needs its PCERead/PCEWrite handler
+	uint8 *DirectPageW[9];
 	uint8 *Page1;
 	//uint8 *PAGE1_W;
 	//const uint8 *PAGE1_R;
@@ -55,6 +63,11 @@ void HuC6280_ResetTS(void);
 extern HuC6280 HuCPU;
 extern uint8 *HuCPUFastMap[0x100];
 
+// Banks whose PCERead/PCEWrite handlers are plain memory accesses, indexed by
+// physical address like HuCPUFastMap.  The CPU reads and writes these inline.
+extern uint8 *HuCPUDirectMapR[0x100];
+extern uint8 *HuCPUDirectMapW[0x100];
+
 #define N_FLAG  0x80
 #define V_FLAG  0x40
 #define T_FLAG  0x20
@@ -20,13 +20,13 @@
 #include <pce_psg/pce_psg.h>
 #include "input.h"
 #include "huc.h"
-//#include "../cdrom/pcecd.h"
-//#include "../cdrom/scsicd.h"
+#include "../cdrom/pcecd.h"
+#include "../cdrom/scsicd.h"
 #include "hes.h"
 #include "tsushin.h"
 #include "arcade_card/arcade_card.h"
 #include "../mempatcher.h"
-//#include "../cdrom/cdromif.h"
+#include "../cdrom/cdromif.h"
 
 #include <scrc32.h>
 
@@ -136,19 +136,14 @@ static DECLFW(IOWrite)
 
 	       if(!PCE_IsCD)
 		break;
-/*
+
 	       if((A & 0x1E00) == 0x1A00)
 	       {
 		if(arcade_card)
 		 arcade_card->Write(A & 0x1FFF, V);
 	       }
 	       else
-	       {
-	        int32 dummy_ne;
-
-		dummy_ne = PCECD_Write(HuCPU.timestamp * 3, A, V);
-	       }
-*/	       
+		PCECD_Write(HuCPU.timestamp * 3, A, V);
 	       break;
   //case 0x1C00: break; // Expansion
   //default: printf("Eep: %04x\n", A); break;
@@ -166,8 +161,6 @@ static void PCECDIRQCB(bool asserted)
 
 bool PCE_InitCD(void)
 {
-	return false;
-/*	
  PCECD_Settings cd_settings;
  memset(&cd_settings, 0, sizeof(PCECD_Settings));
 
@@ -184,7 +177,6 @@ bool PCE_InitCD(void)
   MDFN_printf(_("ADPCM Volume: %d%%\n"), (int)(100 * cd_settings.ADPCM_Volume));
 
  return(PCECD_Init(&cd_settings, PCECDIRQCB, PCE_MASTER_CLOCK, pce_overclocked, &sbuf[0], &sbuf[1]));
-*/ 
 }
 
 
@@ -288,6 +280,8 @@ static void LoadCommonPre(void)
   MDFN_printf(_("CD-ROM speed:  %ux\n"), (unsigned int)MDFN_GetSettingUI("pce_fast.cdspeed"));
 
  memset(HuCPUFastMap, 0, sizeof(HuCPUFastMap));
+ memset(HuCPUDirectMapR, 0, sizeof(HuCPUDirectMapR));
+ memset(HuCPUDirectMapW, 0, sizeof(HuCPUDirectMapW));
  for(int x = 0; x < 0x100; x++)
  {
   PCERead[x] = PCEBusRead;
@@ -316,6 +310,9 @@ static int LoadCommon(void)
   for(int x = 0xf8; x < 0xfb; x++)
    HuCPUFastMap[x] = BaseRAM - 0xf8 * 8192;
 
+  for(int x = 0xf8; x <= 0xfb; x++)
+   HuCPUDirectMapR[x] = HuCPUDirectMapW[x] = BaseRAM - 0xf8 * 8192;
+
   PCERead[0xFF] = IOReadSGX;
  }
  else
@@ -329,6 +326,9 @@ static int LoadCommon(void)
   for(int x = 0xf8; x < 0xfb; x++)
    HuCPUFastMap[x] = BaseRAM - x * 8192;
 
+  for(int x = 0xf8; x <= 0xfb; x++)
+   HuCPUDirectMapR[x] = HuCPUDirectMapW[x] = BaseRAM - x * 8192;
+
   PCERead[0xFF] = IORead;
  }
 
@@ -343,7 +343,7 @@ static int LoadCommon(void)
  psg = new PCE_PSG(&sbuf[0], &sbuf[1], PCE_PSG::REVISION_ENHANCED);	//HUC6280A);
 
  psg->SetVolume(1.0);
-/*
+
  if(PCE_IsCD)
  {
   unsigned int cdpsgvolume = MDFN_GetSettingUI("pce_fast.cdpsgvolume");
@@ -356,7 +356,7 @@ static int LoadCommon(void)
   psg->SetVolume(0.678 * cdpsgvolume / 100);
 
  }
-*/
+
  PCEINPUT_Init();
 
  PCE_Power();
@@ -382,8 +382,6 @@ static int LoadCommon(void)
 
 static bool TestMagicCD(std::vector<CDIF *> *CDInterfaces)
 {
-	return false;
-/*	
  static const uint8 magic_test[0x20] = { 0x82, 0xB1, 0x82, 0xCC, 0x83, 0x76, 0x83, 0x8D, 0x83, 0x4F, 0x83, 0x89, 0x83, 0x80, 0x82, 0xCC,
                                          0x92, 0x98, 0x8D, 0xEC, 0x8C, 0xA0, 0x82, 0xCD, 0x8A, 0x94, 0x8E, 0xAE, 0x89, 0xEF, 0x8E, 0xD0
                                        };
@@ -440,13 +438,11 @@ static bool TestMagicCD(std::vector<CDIF *> *CDInterfaces)
  }
 
  return(ret);
-*/ 
 }
 
 static int LoadCD(std::vector<CDIF *> *CDInterfaces)
 {
-/*	
- std::string bios_path = MDFN_MakeFName(MDFNMKF_FIRMWARE, 0, MDFN_GetSettingS("pce_fast.cdbios").c_str() );
+ std::string bios_path = MDFN_GetSettingS("pce_fast.cdbios");
 
  IsHES = 0;
  IsSGX = 0;
@@ -460,8 +456,6 @@ static int LoadCD(std::vector<CDIF *> *CDInterfaces)
  SCSICD_SetDisc(false, (*CDInterfaces)[0], true);
 
  return(LoadCommon());
-*/
-	return 0; 
 }
 
 
@@ -476,6 +470,54 @@ static void CloseGame(void)
  }
 }
 
+// Both buffers are clocked and ended together, so they always hold the same number of samples;
+// reads them side by side straight into the interleaved output, the same as read_samples() would per channel.
+// A frame with more samples than fit is dropped whole rather than left to pile up in the buffers.
+static int32 ReadStereoSamples(int16 *out, int32 max_samples)
+{
+ int32 count = sbuf[0].samples_avail();
+
+ if(count > max_samples)
+ {
+  sbuf[0].remove_samples(count);
+  sbuf[1].remove_samples(count);
+  return(0);
+ }
+
+ if(count)
+ {
+  const int bass = BLIP_READER_BASS(sbuf[0]);
+  BLIP_READER_BEGIN(left, sbuf[0]);
+  BLIP_READER_BEGIN(right, sbuf[1]);
+
+  for(int32 n = count; n; --n)
+  {
+   blip_long l = BLIP_READER_READ(left);
+   blip_long r = BLIP_READER_READ(right);
+
+   if((int16)l != l)
+    l = 0x7FFF - (l >> 24);
+   if((int16)r != r)
+    r = 0x7FFF - (r >> 24);
+
+   out[0] = l;
+   out[1] = r;
+   out += 2;
+
+   BLIP_READER_NEXT(left, bass);
+   BLIP_READER_NEXT(right, bass);
+  }
+
+  BLIP_READER_END(left, sbuf[0]);
+  BLIP_READER_END(right, sbuf[1]);
+
+  sbuf[0].remove_samples(count);
+  sbuf[1].remove_samples(count);
+ }
+
+ return(count);
+}
+
 static void Emulate(EmulateSpecStruct *espec)
 {
  INPUT_Frame();
@@ -541,23 +583,21 @@ static void Emulate(EmulateSpecStruct *espec)
   }
  }
  VDC_RunFrame(espec->surface, &espec->DisplayRect, espec->LineWidths, IsHES ? 1 : espec->skip);
-/*
+
  if(PCE_IsCD)
- {
-  int32 dummy_ne;
+  PCECD_Run(HuCPU.timestamp * 3);
 
-  dummy_ne = PCECD_Run(HuCPU.timestamp * 3);
- }
-*/
  psg->EndFrame(HuCPU.timestamp / pce_overclocked);
 
+ for(int y = 0; y < 2; y++)
+  sbuf[y].end_frame(HuCPU.timestamp / pce_overclocked);
+
  if(espec->SoundBuf)
+  espec->SoundBufSize = ReadStereoSamples(espec->SoundBuf, espec->SoundBufMaxSize);
+ else
  {
   for(int y = 0; y < 2; y++)
-  {
-   sbuf[y].end_frame(HuCPU.timestamp / pce_overclocked);
-   espec->SoundBufSize = sbuf[y].read_samples(espec->SoundBuf + y, espec->SoundBufMaxSize, 1);
-  }
+   sbuf[y].remove_samples(sbuf[y].samples_avail());
  }
 
  espec->MasterCycles = HuCPU.timestamp * 3;
@@ -565,10 +605,9 @@ static void Emulate(EmulateSpecStruct *espec)
  INPUT_FixTS();
 
  HuC6280_ResetTS();
-/*
+
  if(PCE_IsCD)
   PCECD_ResetTS();
-*/  
 }
 
 static int StateAction(StateMem *sm, int load, int data_only)
@@ -614,14 +653,9 @@ void PCE_Power(void)
  VDC_Power();
  psg->Power(HuCPU.timestamp / pce_overclocked);
  HuC_Power();
-/*
- if(PCE_IsCD)
- {
-  int32 dummy_ne;
 
-  dummy_ne = PCECD_Power(HuCPU.timestamp * 3);
- }
-*/ 
+ if(PCE_IsCD)
+  PCECD_Power(HuCPU.timestamp * 3);
 }
 
 static void DoSimpleCommand(int cmd)
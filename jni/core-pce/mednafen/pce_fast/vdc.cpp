@@ -29,10 +29,20 @@ The spectrum peaked at 15734 Hz.  21477272.727272... / 3 / 15734 = 455.00(CPU cy
 #include "../video.h"
 #include "vdc.h"
 #include "huc.h"
-//#include "../cdrom/pcecd.h"
+#include "../cdrom/pcecd.h"
 #include <trio/trio.h>
 #include <math.h>
 
+// The BG/sprite and SuperGrafx VPC mixers work on 8 pixels at a time where the target
+// has NEON or SSE2.  Define VDC_NO_SIMD to force the scalar loops.
+#if !defined(VDC_NO_SIMD) && defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define VDC_NEON 1
+#elif !defined(VDC_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define VDC_SSE2 1
+#endif
+
 namespace PCE_Fast
 {
 
@@ -116,14 +126,37 @@ static INLINE void FixTileCache(vdc_t *which_vdc, uint16 A)
  }
 }
 
-static INLINE void CheckFixSpriteTileCache(vdc_t *which_vdc, uint16 no, uint32 special)
+// Converts VRAM words first through last after a block of writes, each BG tile line once rather than once per
+// bitplane word, and marks the sprite pattern lines they fall in as stale.
+static void FixTileCacheRange(vdc_t *which_vdc, uint32 first, uint32 last)
+{
+ for(uint32 A = first; A <= last; A++)
+ {
+  if(!(A & 0x8) || (A - 8) < first)
+   FixTileCache(which_vdc, A);
+
+  which_vdc->spr_tile_dirty[A >> 6] |= 1 << (A & 0xF);
+ }
+}
+
+// Sprite pattern lines are converted as they're drawn; a VRAM write only marks its line in spr_tile_dirty, and
+// a change of CG mode marks the whole pattern.
+static INLINE void CheckFixSpriteTileCache(vdc_t *which_vdc, uint16 no, uint32 y, uint32 special)
 {
  if(special != 0x4 && special != 0x5)
   special = 0;
 
- if((special | 0x80) == which_vdc->spr_tile_clean[no])
+ if((special | 0x80) != which_vdc->spr_tile_clean[no])
+ {
+  which_vdc->spr_tile_clean[no] = special | 0x80;
+  which_vdc->spr_tile_dirty[no] = 0xFFFF;
+ }
+
+ if(!(which_vdc->spr_tile_dirty[no] & (1 << y)))
   return;
 
+ which_vdc->spr_tile_dirty[no] &= ~(1 << y);
+
  //printf("Oops: %d, %d, %d\n", no, special | 0x100, which_vdc->spr_tile_clean[no]);
  if((no * 64) >= VRAM_Size)
  {
@@ -134,46 +167,38 @@ static INLINE void CheckFixSpriteTileCache(vdc_t *which_vdc, uint16 no, uint32 s
  }
  else if(special)
  {
-  for(int y = 0; y < 16; y++)
-  {
-   uint8 *tc = which_vdc->spr_tile_cache[no][y];
+  uint8 *tc = which_vdc->spr_tile_cache[no][y];
 
-   uint32 bitplane0 = which_vdc->VRAM[y + 0x00 + no * 0x40 + ((special & 1) << 5)];
-   uint32 bitplane1 = which_vdc->VRAM[y + 0x10 + no * 0x40 + ((special & 1) << 5)];
+  uint32 bitplane0 = which_vdc->VRAM[y + 0x00 + no * 0x40 + ((special & 1) << 5)];
+  uint32 bitplane1 = which_vdc->VRAM[y + 0x10 + no * 0x40 + ((special & 1) << 5)];
 
-   for(int x = 0; x < 16; x++)
-   {
-    uint32 raw_pixel;
-    raw_pixel = ((bitplane0 >> x) & 1) << 0;
-    raw_pixel |= ((bitplane1 >> x) & 1) << 1;
-    tc[x] = raw_pixel;
-   }
+  for(int x = 0; x < 16; x++)
+  {
+   uint32 raw_pixel;
+   raw_pixel = ((bitplane0 >> x) & 1) << 0;
+   raw_pixel |= ((bitplane1 >> x) & 1) << 1;
+   tc[x] = raw_pixel;
   }
  }
  else
  {
-  for(int y = 0; y < 16; y++)
-  {
-   uint8 *tc = which_vdc->spr_tile_cache[no][y];
+  uint8 *tc = which_vdc->spr_tile_cache[no][y];
 
-   uint32 bitplane0 = which_vdc->VRAM[y + 0x00 + no * 0x40];
-   uint32 bitplane1 = which_vdc->VRAM[y + 0x10 + no * 0x40];
-   uint32 bitplane2 = which_vdc->VRAM[y + 0x20 + no * 0x40];
-   uint32 bitplane3 = which_vdc->VRAM[y + 0x30 + no * 0x40];
+  uint32 bitplane0 = which_vdc->VRAM[y + 0x00 + no * 0x40];
+  uint32 bitplane1 = which_vdc->VRAM[y + 0x10 + no * 0x40];
+  uint32 bitplane2 = which_vdc->VRAM[y + 0x20 + no * 0x40];
+  uint32 bitplane3 = which_vdc->VRAM[y + 0x30 + no * 0x40];
 
-   for(int x = 0; x < 16; x++)
-   {
-    uint32 raw_pixel;
-    raw_pixel = ((bitplane0 >> x) & 1) << 0;
-    raw_pixel |= ((bitplane1 >> x) & 1) << 1;
-    raw_pixel |= ((bitplane2 >> x) & 1) << 2;
-    raw_pixel |= ((bitplane3 >> x) & 1) << 3;
-    tc[x] = raw_pixel;
-   }
+  for(int x = 0; x < 16; x++)
+  {
+   uint32 raw_pixel;
+   raw_pixel = ((bitplane0 >> x) & 1) << 0;
+   raw_pixel |= ((bitplane1 >> x) & 1) << 1;
+   raw_pixel |= ((bitplane2 >> x) & 1) << 2;
+   raw_pixel |= ((bitplane3 >> x) & 1) << 3;
+   tc[x] = raw_pixel;
   }
  }
-
- which_vdc->spr_tile_clean[no] = special | 0x80;
 }
 
 
@@ -329,6 +354,9 @@ DECLFW(VDC_Write_ST)
 
 static void DoDMA(vdc_t *vdc)
 {
+    // The tile caches are brought up to date once for the span of VRAM written, after the transfers.
+    uint32 written_first = VRAM_Size, written_last = 0;
+
     // Assuming one cycle for reads, one cycle for write, with DMA?
      for(int i = 0; i < 455; i++)
      {
@@ -344,8 +372,11 @@ static void DoDMA(vdc_t *vdc)
        if(vdc->DESR < VRAM_Size)
        {
         vdc->VRAM[vdc->DESR] = vdc->DMAReadBuffer;
-        FixTileCache(vdc, vdc->DESR);
-	vdc->spr_tile_clean[vdc->DESR >> 6] = 0;
+
+        if(vdc->DESR < written_first)
+         written_first = vdc->DESR;
+        if(vdc->DESR > written_last)
+         written_last = vdc->DESR;
        }
 
        //if(vdc->DCR & 0xC) 
@@ -368,6 +399,9 @@ static void DoDMA(vdc_t *vdc)
       }
       vdc->DMAReadWrite ^= 1;
      } // for()
+
+     if(written_first <= written_last)
+      FixTileCacheRange(vdc, written_first, written_last);
 }
 
 DECLFW(VDC_Write)
@@ -433,7 +467,7 @@ DECLFW(VDC_Write)
 
  			 vdc->VRAM[vdc->MAWR] = (V << 8) | vdc->write_latch;
 			 FixTileCache(vdc, vdc->MAWR);
-		         vdc->spr_tile_clean[vdc->MAWR >> 6] = 0;
+		         vdc->spr_tile_dirty[vdc->MAWR >> 6] |= 1 << (vdc->MAWR & 0xF);
 			} 
 			else
 			{
@@ -612,76 +646,103 @@ static void DrawBG(const vdc_t *vdc, const uint32 count, uint8 *target)
 static const unsigned int sprite_height_tab[4] = { 16, 32, 64, 64 };
 static const unsigned int sprite_height_no_mask[4] = { ~0U, ~2U, ~6U, ~6U };
 
-static INLINE void RebuildSATCache(vdc_t *vdc)
+// Decodes SAT entry i into one SAT_Cache entry, or two for a 32-pixel-wide sprite, returning how many.
+static INLINE int DecodeSATEntry(const vdc_t *vdc, int i, SAT_Cache_t *sat_ptr)
 {
- SAT_Cache_t *sat_ptr = vdc->SAT_Cache;
+ const uint16 SATR0 = vdc->SAT[i * 4 + 0x0];
+ const uint16 SATR1 = vdc->SAT[i * 4 + 0x1];
+ const uint16 SATR2 = vdc->SAT[i * 4 + 0x2];
+ const uint16 SATR3 = vdc->SAT[i * 4 + 0x3];
+
+ int16 y;
+ uint16 height;
+ uint16 x;
+ uint16 no;
+ uint16 flags;
+ bool cgmode;
+ uint32 width;
+
+ y = (int16)(SATR0 & 0x3FF) - 0x40;
+ x = SATR1 & 0x3FF;
+ no = (SATR2 >> 1) & 0x3FF;
+ flags = (SATR3);
+ cgmode = SATR2 & 0x1;
+
+ width = ((flags >> 8) & 1);
+ flags &= ~0x100;
+
+ height = sprite_height_tab[(flags >> 12) & 3];
+ no &= sprite_height_no_mask[(flags >> 12) & 3];
+
+ no = ((no & ~width) | 0) ^ ((flags & SPRF_HFLIP) ? width : 0);
+
+ sat_ptr->y = y;
+ sat_ptr->height = height;
+ sat_ptr->x = x;
+ sat_ptr->no = no;
+ sat_ptr->flags = flags;
+ sat_ptr->cgmode = cgmode;
+
+ if(width)
+ {
+  no = ((no & ~width) | 1) ^ ((flags & SPRF_HFLIP) ? width : 0);
+  x += 16;
 
- vdc->SAT_Cache_Valid = 0;
+  *(sat_ptr + 1) = *sat_ptr;
 
- for(int i = 0; i < 64; i++)
- {
-  const uint16 SATR0 = vdc->SAT[i * 4 + 0x0];
-  const uint16 SATR1 = vdc->SAT[i * 4 + 0x1];
-  const uint16 SATR2 = vdc->SAT[i * 4 + 0x2];
-  const uint16 SATR3 = vdc->SAT[i * 4 + 0x3];
-
-  int16 y;
-  uint16 height;
-  uint16 x;
-  uint16 no;
-  uint16 flags;
-  bool cgmode;
-  uint32 width;
-
-  y = (int16)(SATR0 & 0x3FF) - 0x40;
-  x = SATR1 & 0x3FF;
-  no = (SATR2 >> 1) & 0x3FF;
-  flags = (SATR3);
-  cgmode = SATR2 & 0x1;
-
-  width = ((flags >> 8) & 1);
-  flags &= ~0x100;
-
-  height = sprite_height_tab[(flags >> 12) & 3];
-  no &= sprite_height_no_mask[(flags >> 12) & 3];
-
-  no = ((no & ~width) | 0) ^ ((flags & SPRF_HFLIP) ? width : 0);
-
-  sat_ptr->y = y;
-  sat_ptr->height = height;
-  sat_ptr->x = x;
-  sat_ptr->no = no;
-  sat_ptr->flags = flags;
-  sat_ptr->cgmode = cgmode;
-
-  sat_ptr++;
-  vdc->SAT_Cache_Valid++;
-
-  if(width)
-  {
-   no = ((no & ~width) | 1) ^ ((flags & SPRF_HFLIP) ? width : 0);
-   x += 16;
+  (sat_ptr + 1)->no = no;
+  (sat_ptr + 1)->x = x;
 
-   *sat_ptr = *(sat_ptr - 1);
+  return(2);
+ }
 
-   sat_ptr->no = no;
-   sat_ptr->x = x;
+ return(1);
+}
 
-   sat_ptr++;
-   vdc->SAT_Cache_Valid++;
-  }
+static INLINE void RebuildSATCache(vdc_t *vdc)
+{
+ vdc->SAT_Cache_Valid = 0;
+
+ for(int i = 0; i < 64; i++)
+ {
+  vdc->SAT_Cache_Index[i] = vdc->SAT_Cache_Valid;
+  vdc->SAT_Cache_Valid += DecodeSATEntry(vdc, i, &vdc->SAT_Cache[vdc->SAT_Cache_Valid]);
  }
 }
 
 static INLINE void DoSATDMA(vdc_t *vdc)
 {
+ bool rebuild = !vdc->SAT_Cache_Valid;
+
  if(vdc->SATB > (VRAM_Size - 0x100))
   VDC_UNDEFINED("Unmapped VRAM SATB DMA read");
 
- for(int i = 0; i < 256; i++)
-  vdc->SAT[i] = vdc->VRAM[(vdc->SATB + i) & 0xFFFF];
+ // Only entries that changed are decoded again, in place; the cache is rebuilt when one changes width, which moves
+ // the entries after it.
+ for(int i = 0; i < 64; i++)
+ {
+  const uint16 old_width = vdc->SAT[i * 4 + 0x3] & 0x100;
+  bool changed = false;
+
+  for(int w = 0; w < 4; w++)
+  {
+   const uint16 word = vdc->VRAM[(vdc->SATB + i * 4 + w) & 0xFFFF];
+
+   changed |= (word != vdc->SAT[i * 4 + w]);
+   vdc->SAT[i * 4 + w] = word;
+  }
+
+  if(changed && !rebuild)
+  {
+   if((vdc->SAT[i * 4 + 0x3] & 0x100) != old_width)
+    rebuild = true;
+   else
+    DecodeSATEntry(vdc, i, &vdc->SAT_Cache[vdc->SAT_Cache_Index[i]]);
+  }
+ }
 
- RebuildSATCache(vdc);
+ if(rebuild)
+  RebuildSATCache(vdc);
 }
 
 
@@ -747,7 +808,7 @@ static void DrawSprites(vdc_t *vdc, const int32 end, uint16 *spr_linebuf)
    SpriteList[active_sprites].sub_y = (y_offset & 15);
 
 
-   CheckFixSpriteTileCache(vdc, no, (vdc->MWR & 0xC) | cgmode);
+   CheckFixSpriteTileCache(vdc, no, y_offset & 15, (vdc->MWR & 0xC) | cgmode);
 
    SpriteList[active_sprites].flags |= i ? 0 : SPRF_SPRITE0;
 
@@ -855,10 +916,54 @@ static void DrawSprites(vdc_t *vdc, const int32 end, uint16 *spr_linebuf)
 
 void (*MixBGSPR)(const uint32 count, const uint8 *bg_linebuf, const uint16 *spr_linebuf, uint32 *target) = NULL;
 
+#if defined(VDC_NEON)
+// Palette cache indices of 8 pixels: the sprite pixel where it has priority(bit 15) or the
+// BG pixel is transparent, else the BG pixel.
+static INLINE void MixBGSPR_Select8(const uint8 *bg_linebuf, const uint16 *spr_linebuf, uint16 *pixels)
+{
+ const uint16x8_t bg = vmovl_u8(vld1_u8(bg_linebuf));
+ const uint16x8_t spr = vld1q_u16(spr_linebuf);
+ const uint16x8_t use_spr = vorrq_u16(vceqq_u16(vandq_u16(bg, vdupq_n_u16(0x0F)), vdupq_n_u16(0)), vreinterpretq_u16_s16(vshrq_n_s16(vreinterpretq_s16_u16(spr), 15)));
+
+ vst1q_u16(pixels, vandq_u16(vbslq_u16(use_spr, spr, bg), vdupq_n_u16(0x1FF)));
+}
+#elif defined(VDC_SSE2)
+static INLINE void MixBGSPR_Select8(const uint8 *bg_linebuf, const uint16 *spr_linebuf, uint16 *pixels)
+{
+ const __m128i bg = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)bg_linebuf), _mm_setzero_si128());
+ const __m128i spr = _mm_loadu_si128((const __m128i *)spr_linebuf);
+ const __m128i use_spr = _mm_or_si128(_mm_cmpeq_epi16(_mm_and_si128(bg, _mm_set1_epi16(0x0F)), _mm_setzero_si128()), _mm_srai_epi16(spr, 15));
+ const __m128i pixel = _mm_or_si128(_mm_and_si128(use_spr, spr), _mm_andnot_si128(use_spr, bg));
+
+ _mm_storeu_si128((__m128i *)pixels, _mm_and_si128(pixel, _mm_set1_epi16(0x1FF)));
+}
+#endif
+
 template<typename T>
 void MixBGSPR_Generic(const uint32 count_in, const uint8 *bg_linebuf_in, const uint16 *spr_linebuf_in, T *target_in)
 {
- for(unsigned int x = 0; x < count_in; x++)
+ unsigned int x = 0;
+
+ #if defined(VDC_NEON) || defined(VDC_SSE2)
+ // Priority is resolved 8 pixels at a time; the palette lookups stay scalar, there being no gather.
+ for(; (x + 8) <= count_in; x += 8)
+ {
+  MDFN_ALIGN(16) uint16 pixels[8];
+
+  MixBGSPR_Select8(bg_linebuf_in + x, spr_linebuf_in + x, pixels);
+
+  target_in[x + 0] = vce.color_table_cache[pixels[0]];
+  target_in[x + 1] = vce.color_table_cache[pixels[1]];
+  target_in[x + 2] = vce.color_table_cache[pixels[2]];
+  target_in[x + 3] = vce.color_table_cache[pixels[3]];
+  target_in[x + 4] = vce.color_table_cache[pixels[4]];
+  target_in[x + 5] = vce.color_table_cache[pixels[5]];
+  target_in[x + 6] = vce.color_table_cache[pixels[6]];
+  target_in[x + 7] = vce.color_table_cache[pixels[7]];
+ }
+ #endif
+
+ for(; x < count_in; x++)
  {
   const uint32 bg_pixel = bg_linebuf_in[x];
   const uint32 spr_pixel = spr_linebuf_in[x];
@@ -993,7 +1098,92 @@ void MixNone(const uint32 count, T *target)
   target[x] = bg_color;
 }
 
-//static void MixVPC(const uint32 count, const uint32 *lb0, const uint32 *lb1, uint32 *target) NO_INLINE;
+#if defined(VDC_NEON)
+typedef uint32x4_t vpc_vec_t;
+
+#define VPCVecSet(x)		vdupq_n_u32(x)
+#define VPCVecLoad(p)		vld1q_u32(p)
+#define VPCVecAnd(a, b)		vandq_u32(a, b)
+#define VPCVecOr(a, b)		vorrq_u32(a, b)
+#define VPCVecXor(a, b)		veorq_u32(a, b)
+#define VPCVecShr2(a)		vshrq_n_u32(a, 2)
+#define VPCVecIsZero(a)		vceqq_u32(a, vdupq_n_u32(0))
+#define VPCVecSelect(m, a, b)	vbslq_u32(m, a, b)		// m ? a : b
+
+static INLINE void VPCVecStore(uint32 *target, vpc_vec_t a, vpc_vec_t b)
+{
+ vst1q_u32(target, a);
+ vst1q_u32(target + 4, b);
+}
+
+static INLINE void VPCVecStore(uint16 *target, vpc_vec_t a, vpc_vec_t b)
+{
+ vst1q_u16(target, vcombine_u16(vmovn_u32(a), vmovn_u32(b)));
+}
+#elif defined(VDC_SSE2)
+typedef __m128i vpc_vec_t;
+
+#define VPCVecSet(x)		_mm_set1_epi32(x)
+#define VPCVecLoad(p)		_mm_loadu_si128((const __m128i *)(p))
+#define VPCVecAnd(a, b)		_mm_and_si128(a, b)
+#define VPCVecOr(a, b)		_mm_or_si128(a, b)
+#define VPCVecXor(a, b)		_mm_xor_si128(a, b)
+#define VPCVecShr2(a)		_mm_srli_epi32(a, 2)
+#define VPCVecIsZero(a)		_mm_cmpeq_epi32(a, _mm_setzero_si128())
+#define VPCVecSelect(m, a, b)	_mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b))
+
+static INLINE void VPCVecStore(uint32 *target, vpc_vec_t a, vpc_vec_t b)
+{
+ _mm_storeu_si128((__m128i *)target, a);
+ _mm_storeu_si128((__m128i *)(target + 4), b);
+}
+
+static INLINE void VPCVecStore(uint16 *target, vpc_vec_t a, vpc_vec_t b)
+{
+ // Sign extending the low halves keeps them in range for the signed pack.
+ _mm_storeu_si128((__m128i *)target, _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16)));
+}
+#endif
+
+#if defined(VDC_NEON) || defined(VDC_SSE2)
+// vpc_mix_inner.inc for 4 pixels.
+static INLINE vpc_vec_t MixVPC_Vec4(const uint8 pb, vpc_vec_t vdc1_pixel, vpc_vec_t vdc2_pixel, const vpc_vec_t am)
+{
+ if((pb >> 2) == 1)
+  vdc1_pixel = VPCVecOr(vdc1_pixel, VPCVecAnd(VPCVecShr2(VPCVecAnd(VPCVecXor(vdc2_pixel, vdc1_pixel), vdc2_pixel)), am));
+
+ return(VPCVecSelect(VPCVecIsZero(VPCVecAnd(vdc1_pixel, am)), vdc1_pixel, vdc2_pixel));
+}
+#endif
+
+// Mixes a run of pixels that all use the priority setting pb.
+template<typename T>
+static INLINE void MixVPC_Run(const uint8 pb, const uint32 count, const uint32 *lb0, const uint32 *lb1, T *target)
+{
+	int x = 0;
+
+	#if defined(VDC_NEON) || defined(VDC_SSE2)
+	// Setting 2 is left to the scalar loop, which logs it.
+	if((pb >> 2) != 2)
+	{
+	 const vpc_vec_t am = VPCVecSet(amask);
+	 const vpc_vec_t bg = VPCVecSet(vce.color_table_cache[0]);
+
+	 for(; (x + 8) <= (int)count; x += 8)
+	 {
+	  const vpc_vec_t a = MixVPC_Vec4(pb, (pb & 1) ? VPCVecLoad(lb0 + x) : bg, (pb & 2) ? VPCVecLoad(lb1 + x) : bg, am);
+	  const vpc_vec_t b = MixVPC_Vec4(pb, (pb & 1) ? VPCVecLoad(lb0 + x + 4) : bg, (pb & 2) ? VPCVecLoad(lb1 + x + 4) : bg, am);
+
+	  VPCVecStore(target + x, a, b);
+	 }
+	}
+	#endif
+
+	for(; x < (int)count; x++)
+	{
+	 #include "vpc_mix_inner.inc"
+	}
+}
 
 template<typename T>
 static void MixVPC(const uint32 count, const uint32 *lb0, const uint32 *lb1, T *target)
@@ -1001,72 +1191,37 @@ static void MixVPC(const uint32 count, const uint32 *lb0, const uint32 *lb1, T *
 	static const int prio_select[4] = { 1, 1, 0, 0 };
 	static const int prio_shift[4] = { 4, 0, 4, 0 };
 
-	// Windowing disabled.
-	if(vpc.winwidths[0] <= 0x40 && vpc.winwidths[1] <= 0x40)
-	{
-	 const uint8 pb = (vpc.priority[prio_select[0]] >> prio_shift[0]) & 0xF;
+	// Pixels left of both window edges are in both windows, those between the edges in
+	// one of them, and the rest in neither; each of these runs has a single priority setting.
+	int32 edge[2];
 
-	 switch(pb)
-	 {
-	  default:
-	  	  //printf("%02x\n", pb);
-		  for(int x = 0; x < (int)count; x++)
-		  {	 
-		   #include "vpc_mix_inner.inc"
-		  }
-		  break;
-
-	  case 0x3:
-		  for(int x = 0; x < (int)count; x++)
-		  {	 
-		   #include "vpc_mix_inner.inc"
-		  }
-		  break;
-
-	  case 0x7:
-		  for(int x = 0; x < (int)count; x++)
-		  {	 
-		   #include "vpc_mix_inner.inc"
-		  }
-		  break;
-
-	  case 0xB:
-		  for(int x = 0; x < (int)count; x++)
-		  {	 
-		   #include "vpc_mix_inner.inc"
-		  }
-		  break;
-
-	  case 0xF:
-		  for(int x = 0; x < (int)count; x++)
-		  {	 
-		   #include "vpc_mix_inner.inc"
-		  }
-		  break;
-	 }
+	for(int w = 0; w < 2; w++)
+	{
+	 edge[w] = vpc.winwidths[w] - 0x40;
 
-	 //switch(pb & 0xF)
-	 //{
-	 // case 0x0: for(int x = 0; x < (int)count; x++)
-	 //	    { 
-	 //	     #include "vpc_mix_inner.inc"
-	 //	    }
-	 //	    break;
-         //}
+	 if(edge[w] < 0)
+	  edge[w] = 0;
+	 else if(edge[w] > (int32)count)
+	  edge[w] = count;
 	}
-	else for(int x = 0; x < (int)count; x++)
-	{    
-	 int in_window = 0;
 
-	 if(x < (vpc.winwidths[0] - 0x40))
-	  in_window |= 1;
+	const int32 near_edge = (edge[0] < edge[1]) ? edge[0] : edge[1];
+	const int32 far_edge = (edge[0] < edge[1]) ? edge[1] : edge[0];
+	const int run_window[3] = { 3, (edge[0] > edge[1]) ? 1 : 2, 0 };
+	const int32 run_start[4] = { 0, near_edge, far_edge, (int32)count };
 
-	 if(x < (vpc.winwidths[1] - 0x40))
-	  in_window |= 2;
+	for(int run = 0; run < 3; run++)
+	{
+	 const int32 start = run_start[run];
+	 const int32 run_count = run_start[run + 1] - start;
 
-	 uint8 pb = (vpc.priority[prio_select[in_window]] >> prio_shift[in_window]) & 0xF;
+	 if(run_count > 0)
+	 {
+	  const int in_window = run_window[run];
+	  const uint8 pb = (vpc.priority[prio_select[in_window]] >> prio_shift[in_window]) & 0xF;
 
-	 #include "vpc_mix_inner.inc"
+	  MixVPC_Run(pb, run_count, lb0 + start, lb1 + start, target + start);
+	 }
 	}
 }
 
@@ -1443,13 +1598,7 @@ void VDC_RunFrame(MDFN_Surface *surface, MDFN_Rect *DisplayRect, MDFN_Rect *Line
   HuC6280_Run(455 - line_leadin1 - 2);
 
   if(PCE_IsCD)
-  {
-/*  	
-   int32 dummy_ne;
-
-   dummy_ne = PCECD_Run(HuCPU.timestamp * 3);
-*/   
-  }
+   PCECD_Run(HuCPU.timestamp * 3);
   for(int chip = 0; chip < VDC_TotalChips; chip++)
   {
    vdc = vdc_chips[chip];
@@ -1593,7 +1742,7 @@ void VDC_Init(int sgx)
 
  MixBGSPR = MixBGSPR_Generic<uint32>;
 
- #ifdef ARCH_X86
+ #if defined(ARCH_X86) && !defined(VDC_SSE2)
  // FIXME: cmov
  MixBGSPR = MixBGSPR_x86;
  #endif
@@ -1706,11 +1855,7 @@ int VDC_StateAction(StateMem *sm, int load, int data_only)
 
   if(load)
   {
-   for(int x = 0; x < VRAM_Size; x++)
-   {
-    FixTileCache(vdc, x);
-    vdc->spr_tile_clean[x >> 6] = 0;
-   }
+   FixTileCacheRange(vdc, 0, VRAM_Size - 1);
    for(int x = 0; x < 512; x++)
     FixPCache(x);
    RebuildSATCache(vdc);
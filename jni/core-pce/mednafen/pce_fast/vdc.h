@@ -98,6 +98,7 @@ typedef struct
 
         int SAT_Cache_Valid;          // 64 through 128, depending on the number of 32-pixel-wide sprites.
         SAT_Cache_t SAT_Cache[128];     //64];
+        uint8 SAT_Cache_Index[64];      // First SAT_Cache entry of each SAT entry.
 
 	uint16 SAT[0x100];
 
@@ -105,6 +106,7 @@ typedef struct
         uint64 bg_tile_cache[65536][8]; 	// Tile, y, x
         uint8 spr_tile_cache[1024][16][16];	// Tile, y, x
         uint8 spr_tile_clean[1024];     //VRAM_Size / 64];
+        uint16 spr_tile_dirty[1024];    // Lines of each sprite pattern changed in VRAM since they were cached.
 } vdc_t;
 
 extern vdc_t *vdc_chips[2];
@@ -18,6 +18,7 @@
 #include "mednafen.h"
 
 #include <string.h>
+#include <algorithm>
 
 #include <trio/trio.h>
 #include "driver.h"
@@ -118,37 +119,48 @@ int smem_read32le(StateMem *st, uint32 *b)
 }
 
 
-static bool ValidateSFStructure(SFORMAT *sf)
+// Grows the buffer once so that len more bytes fit at the current position
+static bool smem_reserve(StateMem *st, uint32 len)
 {
- SFORMAT *saved_sf = sf;
-
- while(sf->size || sf->name)
+ if((len + st->loc) > st->malloced)
  {
-  SFORMAT *sub_sf = saved_sf;
-  while(sub_sf->size || sub_sf->name)
-  {
-   if(sf != sub_sf)
-   {
-    if(!strncmp(sf->name, sub_sf->name, 32))
-    {
-     printf("Duplicate state variable name: %.32s\n", sf->name);
-    }
-   }
-   sub_sf++;
-  }
+  uint8 *data = (uint8 *)realloc(st->data, len + st->loc);
 
-  sf++;
+  if(!data)
+   return(0);
+
+  st->data = data;
+  st->malloced = len + st->loc;
  }
  return(1);
 }
 
+/* The SFORMAT tables are rebuilt on the stack by every StateAction call, so
+   each section keeps a flattened copy of its table, an index sorted by
+   variable name and the size of its saved chunk. The index is reused for as
+   long as the live table flattens to the same entries, which in practice
+   means it is built once per loaded game. */
+typedef struct
+{
+ SFORMAT sf;
+ std::string record;	// Length-prefixed name, as stored in a chunk
+} SFIndexEntry;
 
-static bool SubWrite(StateMem *st, SFORMAT *sf, const char *name_prefix = NULL)
+typedef struct
 {
- // FIXME?  It's kind of slow, and we definitely don't want it on with state rewinding...
- ValidateSFStructure(sf);
+ char section[32];
+ std::vector<SFIndexEntry> entries;	// In table order
+ std::vector<uint32> sorted;		// Entry numbers sorted by name
+ uint32 save_size;			// Chunk size, excluding the section header
+} SFIndex;
 
- while(sf->size || sf->name)	// Size can sometimes be zero, so also check for the text name.  These two should both be zero only at the end of a struct.
+static std::vector<SFIndex *> sf_indexes;
+static std::vector<SFORMAT *> sf_flat;
+static std::vector<uint8> sf_found;
+
+static void FlattenSF(SFORMAT *sf, std::vector<SFORMAT *> &flat)
+{
+ while(sf->size || sf->name) // Size can sometimes be zero, so also check for the text name.  These two should both be zero only at the end of a struct.
  {
   if(!sf->size || !sf->v)
   {
@@ -156,30 +168,139 @@ static bool SubWrite(StateMem *st, SFORMAT *sf, const char *name_prefix = NULL)
    continue;
   }
 
-  if(sf->size == (uint32)~0)		/* Link to another struct.	*/
+  if(sf->size == (uint32)~0)            /* Link to another SFORMAT structure. */
+   FlattenSF((SFORMAT *)sf->v, flat);
+  else
   {
-   if(!SubWrite(st, (SFORMAT *)sf->v, name_prefix))
-    return(0);
+   assert(sf->name);
+   flat.push_back(sf);
+  }
 
-   sf++;
-   continue;
+  sf++;
+ }
+}
+
+struct compare_sfentry
+{
+ const SFIndex *index;
+
+ bool operator()(uint32 a, uint32 b) const
+ {
+  return(strcmp(index->entries[a].record.c_str() + 1, index->entries[b].record.c_str() + 1) < 0);
+ }
+};
+
+static void BuildSFIndex(SFIndex *index)
+{
+ index->entries.resize(sf_flat.size());
+ index->sorted.resize(sf_flat.size());
+ index->save_size = 0;
+
+ for(uint32 i = 0; i < sf_flat.size(); i++)
+ {
+  SFIndexEntry *entry = &index->entries[i];
+  size_t slen = strlen(sf_flat[i]->name);
+
+  if(slen >= 255)
+  {
+   printf("Warning:  state variable name possibly too long: %s %d\n", sf_flat[i]->name, (int)slen);
+   slen = 255;
   }
 
-  int32 bytesize = sf->size;
+  entry->sf = *sf_flat[i];
+  entry->record.assign(1, (char)slen);
+  entry->record.append(sf_flat[i]->name, slen);
 
-   char nameo[1 + 256];
-   int slen;
+  // Bools are saved as one byte per element
+  index->save_size += entry->record.size() + 4 + entry->sf.size;
+  index->sorted[i] = i;
+ }
 
-   slen = trio_snprintf(nameo + 1, 256, "%s%s", name_prefix ? name_prefix : "", sf->name);
-   nameo[0] = slen;
+ compare_sfentry cmp = { index };
+ std::sort(index->sorted.begin(), index->sorted.end(), cmp);
 
-   if(slen >= 255)
-   {
-    printf("Warning:  state variable name possibly too long: %s %s %s %d\n", sf->name, name_prefix, nameo, slen);
-    slen = 255;
-   }
+ for(uint32 i = 1; i < index->sorted.size(); i++)
+ {
+  if(!cmp(index->sorted[i - 1], index->sorted[i]))
+   printf("Duplicate save state variable in internal emulator structures(CLUB THE PROGRAMMERS WITH BREADSTICKS): %s\n", index->entries[index->sorted[i]].record.c_str() + 1);
+ }
+}
+
+static SFIndex *GetSFIndex(const char *sname, SFORMAT *sf)
+{
+ SFIndex *index = NULL;
+
+ sf_flat.clear();
+ FlattenSF(sf, sf_flat);
+
+ for(uint32 i = 0; i < sf_indexes.size(); i++)
+ {
+  if(!strncmp(sf_indexes[i]->section, sname, sizeof(sf_indexes[i]->section) - 1))
+  {
+   index = sf_indexes[i];
+   break;
+  }
+ }
+
+ if(index && index->entries.size() == sf_flat.size())
+ {
+  uint32 i;
+
+  for(i = 0; i < sf_flat.size(); i++)
+  {
+   const SFORMAT *live = sf_flat[i];
+   const SFIndexEntry *entry = &index->entries[i];
+
+   if(live->v != entry->sf.v || live->size != entry->sf.size || live->flags != entry->sf.flags ||
+      strcmp(live->name, entry->record.c_str() + 1))
+    break;
+  }
+
+  if(i == sf_flat.size())
+   return(index);
+ }
 
-   smem_write(st, nameo, 1 + nameo[0]);
+ if(!index)
+ {
+  index = new SFIndex;
+  strncpy(index->section, sname, sizeof(index->section) - 1);
+  index->section[sizeof(index->section) - 1] = 0;
+  sf_indexes.push_back(index);
+ }
+
+ BuildSFIndex(index);
+
+ return(index);
+}
+
+// Returns the entry number of the named variable, or -1
+static int32 FindSFEntry(const SFIndex *index, const char *name)
+{
+ uint32 lo = 0, hi = index->sorted.size();
+
+ while(lo < hi)
+ {
+  uint32 mid = (lo + hi) >> 1;
+  uint32 e = index->sorted[mid];
+  int c = strcmp(index->entries[e].record.c_str() + 1, name);
+
+  if(!c)
+   return(e);
+
+  if(c < 0)
+   lo = mid + 1;
+  else
+   hi = mid;
+ }
+ return(-1);
+}
+
+static void WriteStateVar(StateMem *st, const SFIndexEntry *entry)
+{
+ const SFORMAT *sf = &entry->sf;
+ int32 bytesize = sf->size;
+
+   smem_write(st, (void *)entry->record.data(), entry->record.size());
    smem_write32le(st, bytesize);
 
    /* Flip the byte order... */
@@ -223,16 +344,11 @@ static bool SubWrite(StateMem *st, SFORMAT *sf, const char *name_prefix = NULL)
 	  Endian_A16_LE_to_NE(sf->v, bytesize / sizeof(uint16));
   else if(sf->flags & RLSB)
 	  Endian_V_LE_to_NE(sf->v, bytesize);
-  sf++; 
- }
-
- return(TRUE);
 }
 
 static int WriteStateChunk(StateMem *st, const char *sname, SFORMAT *sf)
 {
- int32 data_start_pos;
- int32 end_pos;
+ SFIndex *index = GetSFIndex(sname, sf);
 
  uint8 sname_tmp[32];
 
@@ -242,58 +358,17 @@ static int WriteStateChunk(StateMem *st, const char *sname, SFORMAT *sf)
  if(strlen(sname) > 32)
 	 printf("Warning: section name is too long: %s\n", sname);
 
- smem_write(st, sname_tmp, 32);
-
- smem_write32le(st, 0);                // We'll come back and write this later.
-
- data_start_pos = smem_tell(st);
-
- if(!SubWrite(st, sf))
+ // The chunk size is known up front, so the buffer grows at most once
+ if(!smem_reserve(st, 32 + 4 + index->save_size))
   return(0);
 
- end_pos = smem_tell(st);
-
- smem_seek(st, data_start_pos - 4, SEEK_SET);
- smem_write32le(st, end_pos - data_start_pos);
- smem_seek(st, end_pos, SEEK_SET);
-
- return(end_pos - data_start_pos);
-}
-
-struct compare_cstr
-{
- bool operator()(const char *s1, const char *s2) const
- {
-  return(strcmp(s1, s2) < 0);
- }
-};
-
-typedef std::map<const char *, SFORMAT *, compare_cstr> SFMap_t;
-
-static void MakeSFMap(SFORMAT *sf, SFMap_t &sfmap)
-{
- while(sf->size || sf->name) // Size can sometimes be zero, so also check for the text name.  These two should both be zero only at the end of a struct.
- {
-  if(!sf->size || !sf->v)
-  {
-   sf++;
-   continue;
-  }
-
-  if(sf->size == (uint32)~0)            /* Link to another SFORMAT structure. */
-   MakeSFMap((SFORMAT *)sf->v, sfmap);
-  else
-  {
-   assert(sf->name);
-
-   if(sfmap.find(sf->name) != sfmap.end())
-    printf("Duplicate save state variable in internal emulator structures(CLUB THE PROGRAMMERS WITH BREADSTICKS): %s\n", sf->name);
+ smem_write(st, sname_tmp, 32);
+ smem_write32le(st, index->save_size);
 
-   sfmap[sf->name] = sf;
-  }
+ for(uint32 i = 0; i < index->entries.size(); i++)
+  WriteStateVar(st, &index->entries[i]);
 
-  sf++;
- }
+ return(index->save_size);
 }
 
 // Fast raw chunk reader
@@ -328,15 +403,15 @@ static void DOReadChunk(StateMem *st, SFORMAT *sf)
  }
 }
 
-static int ReadStateChunk(StateMem *st, SFORMAT *sf, int size)
+static int ReadStateChunk(StateMem *st, const char *sname, SFORMAT *sf, int size)
 {
  int temp;
 
  {
-  SFMap_t sfmap;
-  SFMap_t sfmap_found;	// Used for identifying variables that are missing in the save state.
+  SFIndex *index = GetSFIndex(sname, sf);
+  uint32 next = 0;	// Saved chunks normally list variables in table order
 
-  MakeSFMap(sf, sfmap);
+  sf_found.assign(index->entries.size(), 0);	// Used for identifying variables that are missing in the save state.
 
   temp = smem_tell(st);
   while(smem_tell(st) < (temp + size))
@@ -360,15 +435,20 @@ static int ReadStateChunk(StateMem *st, SFORMAT *sf, int size)
 
    smem_read32le(st, &recorded_size);
 
-   SFMap_t::iterator sfmit;
+   int32 e = -1;
 
-   sfmit = sfmap.find((char *)toa + 1);
+   if(next < index->entries.size() && !strcmp(index->entries[next].record.c_str() + 1, (char *)toa + 1))
+    e = next;
+   else
+    e = FindSFEntry(index, (char *)toa + 1);
 
-   if(sfmit != sfmap.end())
+   if(e >= 0)
    {
-    SFORMAT *tmp = sfmit->second;
+    SFORMAT *tmp = &index->entries[e].sf;
     uint32 expected_size = tmp->size;	// In bytes
 
+    next = e + 1;
+
     if(recorded_size != expected_size)
     {
      printf("Variable in save state wrong size: %s.  Need: %d, got: %d\n", toa + 1, expected_size, recorded_size);
@@ -380,7 +460,7 @@ static int ReadStateChunk(StateMem *st, SFORMAT *sf, int size)
     }
     else
     {
-     sfmap_found[tmp->name] = tmp;
+     sf_found[e] = 1;
 
      smem_read(st, (uint8 *)tmp->v, expected_size);
 
@@ -413,11 +493,11 @@ static int ReadStateChunk(StateMem *st, SFORMAT *sf, int size)
    }
   } // while(...)
 
-  for(SFMap_t::const_iterator it = sfmap.begin(); it != sfmap.end(); it++)
+  for(uint32 i = 0; i < index->entries.size(); i++)
   {
-   if(sfmap_found.find(it->second->name) == sfmap_found.end())
+   if(!sf_found[i])
    {
-    printf("Variable missing from save state: %s\n", it->second->name);
+    printf("Variable missing from save state: %s\n", index->entries[i].record.c_str() + 1);
    }
   }
 
@@ -455,7 +535,7 @@ int MDFNSS_StateAction(void *st_p, int load, int data_only, std::vector <SSDescr
                // Yay, we found the section
                if(!strncmp(sname, section->name, 32))
                {
-                  if(!ReadStateChunk(st, section->sf, tmp_size))
+                  if(!ReadStateChunk(st, section->name, section->sf, tmp_size))
                   {
                      printf("Error reading chunk: %s\n", section->name);
                      return(0);
@@ -513,9 +593,14 @@ int MDFNSS_SaveSM(void *st_p, int, int, const void*, const void*, const void*)
         uint8 header[32];
 	int neowidth = 0, neoheight = 0;
 
+	static uint32 last_size = 0;	// Presizes the buffer from the previous save
+
 	memset(header, 0, sizeof(header));
 	memcpy(header, header_magic, 8);
 
+	if(!smem_reserve(st, last_size))
+	 return(0);
+
 	MDFN_en32lsb(header + 16, MEDNAFEN_VERSION_NUMERIC);
 	MDFN_en32lsb(header + 24, neowidth);
 	MDFN_en32lsb(header + 28, neoheight);
@@ -528,6 +613,8 @@ int MDFNSS_SaveSM(void *st_p, int, int, const void*, const void*, const void*)
 	smem_seek(st, 16 + 4, SEEK_SET);
 	smem_write32le(st, sizy);
 
+	last_size = sizy;
+
 	return(1);
 }
 
@@ -437,4 +437,26 @@ int MDFND_UnlockMutex(MDFN_Mutex *lock)
    return 0;
 }
 
+MDFN_Cond *MDFND_CreateCond()
+{
+   return (MDFN_Cond*)scond_new();
+}
+
+void MDFND_DestroyCond(MDFN_Cond *cond)
+{
+   scond_free((scond_t*)cond);
+}
+
+int MDFND_WaitCond(MDFN_Cond *cond, MDFN_Mutex *lock)
+{
+   scond_wait((scond_t*)cond, (slock_t*)lock);
+   return 0;
+}
+
+int MDFND_SignalCond(MDFN_Cond *cond)
+{
+   scond_signal((scond_t*)cond);
+   return 0;
+}
+
 #endif
@@ -216,6 +216,16 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
 		io = (io >> 31) ^ 0x7FFF;\
 }
 
+/* Interpolation and FIR products are computed 4-wide where the target has
+   NEON or SSE2. Define SPC_DSP_NO_SIMD to force the scalar reference code. */
+#if !defined (SPC_DSP_NO_SIMD) && defined (__ARM_NEON__)
+	#include <arm_neon.h>
+	#define SPC_DSP_NEON 1
+#elif !defined (SPC_DSP_NO_SIMD) && defined (__SSE2__)
+	#include <emmintrin.h>
+	#define SPC_DSP_SSE2 1
+#endif
+
 /* Access global DSP register */
 #define REG(n)      dsp_m.regs [R_##n]
 
@@ -278,6 +288,59 @@ static short gauss [512] =
 
 /* Gaussian interpolation */
 
+#if SPC_DSP_NEON || SPC_DSP_SSE2
+
+/* The four gaussian points used for each fractional position, stored
+   contiguously in the order they are applied so they load as one vector */
+static short gauss_interp [256] [4] __attribute__((aligned(8)));
+
+static void dsp_init_gauss_interp (void)
+{
+	int offset;
+
+	for ( offset = 0; offset < 256; offset++ )
+	{
+		gauss_interp [offset] [0] = gauss [255 - offset];
+		gauss_interp [offset] [1] = gauss [511 - offset];
+		gauss_interp [offset] [2] = gauss [256 + offset];
+		gauss_interp [offset] [3] = gauss [      offset];
+	}
+}
+
+static INLINE int dsp_interpolate( dsp_voice_t *v )
+{
+	int out, p [4];
+	int const *in;
+	short const *g;
+
+	g  = gauss_interp [v->interp_pos >> 4 & 0xFF];
+	in = &v->buf [(v->interp_pos >> 12) + v->buf_pos];
+
+	/* Samples are always in 16-bit range, so narrowing them is lossless */
+#if SPC_DSP_NEON
+	vst1q_s32( p, vshrq_n_s32( vmull_s16( vld1_s16( g ), vmovn_s32( vld1q_s32( in ) ) ), 11 ) );
+#else
+	{
+		__m128i s, gv, lo, hi;
+		s  = _mm_loadu_si128( (__m128i const*) in );
+		s  = _mm_packs_epi32( s, s );
+		gv = _mm_loadl_epi64( (__m128i const*) g );
+		lo = _mm_mullo_epi16( s, gv );
+		hi = _mm_mulhi_epi16( s, gv );
+		_mm_storeu_si128( (__m128i*) p, _mm_srai_epi32( _mm_unpacklo_epi16( lo, hi ), 11 ) );
+	}
+#endif
+
+	out = (int16_t) (p [0] + p [1] + p [2]);
+	out += p [3];
+
+	CLAMP16( out );
+	out &= ~1;
+	return out;
+}
+
+#else
+
 static INLINE int dsp_interpolate( dsp_voice_t *v )
 {
 	int offset, out, *in;
@@ -300,6 +363,8 @@ static INLINE int dsp_interpolate( dsp_voice_t *v )
 	return out;
 }
 
+#endif
+
 /* Counters */
 
 /* 30720 =  2048 * 5 * 3 */
@@ -774,6 +839,71 @@ static void dsp_voice_V9_V6_V3( dsp_voice_t* const v )
 	ECHO_FIR( 0 ) [ch] = ECHO_FIR( 8 ) [ch] = s >> 1; \
 }
 
+static INLINE void dsp_update_fir_coef (void)
+{
+	int i;
+
+	for ( i = 0; i < ECHO_HIST_SIZE; i++ )
+		dsp_m.fir_coef [i] [0] = dsp_m.fir_coef [i] [1] = (int8_t) dsp_m.regs [R_FIR + i * 0x10];
+}
+
+/* Sum of FIR points first to first + count - 1 (count <= 4, first + 3 < 8)
+   for both channels. Each product is still shifted individually, matching
+   CALC_FIR exactly. */
+
+static INLINE void dsp_echo_fir( int first, int count, int out [2] )
+{
+#if SPC_DSP_NEON || SPC_DSP_SSE2
+	/* Lanes of taps beyond count are cleared so the coefficients and history
+	   can always be loaded four taps wide. History values are 15-bit. */
+	static short const fir_mask [5] [8] __attribute__((aligned(16))) =
+	{
+		{  0,  0,  0,  0,  0,  0,  0,  0 },
+		{ -1, -1,  0,  0,  0,  0,  0,  0 },
+		{ -1, -1, -1, -1,  0,  0,  0,  0 },
+		{ -1, -1, -1, -1, -1, -1,  0,  0 },
+		{ -1, -1, -1, -1, -1, -1, -1, -1 }
+	};
+	int const *h = ECHO_FIR( first + 1 );
+	short const *c = dsp_m.fir_coef [first];
+
+#if SPC_DSP_NEON
+	int16x8_t cv;
+	int32x4_t lo, hi, sum;
+
+	cv  = vandq_s16( vld1q_s16( c ), vld1q_s16( fir_mask [count] ) );
+	lo  = vshrq_n_s32( vmull_s16( vmovn_s32( vld1q_s32( h ) ), vget_low_s16( cv ) ), 6 );
+	hi  = vshrq_n_s32( vmull_s16( vmovn_s32( vld1q_s32( h + 4 ) ), vget_high_s16( cv ) ), 6 );
+	sum = vaddq_s32( lo, hi );
+	vst1_s32( out, vadd_s32( vget_low_s32( sum ), vget_high_s32( sum ) ) );
+#else
+	__m128i cv, hv, plo, phi, sum;
+
+	cv  = _mm_and_si128( _mm_loadu_si128( (__m128i const*) c ),
+			_mm_load_si128( (__m128i const*) fir_mask [count] ) );
+	hv  = _mm_packs_epi32( _mm_loadu_si128( (__m128i const*) h ),
+			_mm_loadu_si128( (__m128i const*) (h + 4) ) );
+	plo = _mm_mullo_epi16( hv, cv );
+	phi = _mm_mulhi_epi16( hv, cv );
+	sum = _mm_add_epi32( _mm_srai_epi32( _mm_unpacklo_epi16( plo, phi ), 6 ),
+			_mm_srai_epi32( _mm_unpackhi_epi16( plo, phi ), 6 ) );
+	sum = _mm_add_epi32( sum, _mm_srli_si128( sum, 8 ) );
+	out [0] = _mm_cvtsi128_si32( sum );
+	out [1] = _mm_cvtsi128_si32( _mm_srli_si128( sum, 4 ) );
+#endif
+#else
+	int i, l = 0, r = 0;
+
+	for ( i = first; i < first + count; i++ )
+	{
+		l += CALC_FIR( i, 0 );
+		r += CALC_FIR( i, 1 );
+	}
+	out [0] = l;
+	out [1] = r;
+#endif
+}
+
 static INLINE void dsp_echo_22 (void)
 {
 	int l, r;
@@ -794,26 +924,24 @@ static INLINE void dsp_echo_22 (void)
 
 static INLINE void dsp_echo_23 (void)
 {
-	int l, r;
+	int fir [2];
 
-	l = (((dsp_m.echo_hist_pos [1 + 1]) [0] * (int8_t) dsp_m.regs [R_FIR + 1 * 0x10]) >> 6) + (((dsp_m.echo_hist_pos [2 + 1]) [0] * (int8_t) dsp_m.regs [R_FIR + 2 * 0x10]) >> 6);
-	r = (((dsp_m.echo_hist_pos [1 + 1]) [1] * (int8_t) dsp_m.regs [R_FIR + 1 * 0x10]) >> 6) + (((dsp_m.echo_hist_pos [2 + 1]) [1] * (int8_t) dsp_m.regs [R_FIR + 2 * 0x10]) >> 6);
+	dsp_echo_fir( 1, 2, fir );
 
-	dsp_m.t_echo_in [0] += l;
-	dsp_m.t_echo_in [1] += r;
+	dsp_m.t_echo_in [0] += fir [0];
+	dsp_m.t_echo_in [1] += fir [1];
 
 	ECHO_READ(1);
 }
 
 static INLINE void dsp_echo_24 (void)
 {
-	int l, r;
+	int fir [2];
 
-	l = (((dsp_m.echo_hist_pos [3 + 1]) [0] * (int8_t) dsp_m.regs [R_FIR + 3 * 0x10]) >> 6) + (((dsp_m.echo_hist_pos [4 + 1]) [0] * (int8_t) dsp_m.regs [R_FIR + 4 * 0x10]) >> 6) + (((dsp_m.echo_hist_pos [5 + 1]) [0] * (int8_t) dsp_m.regs [R_FIR + 5 * 0x10]) >> 6);
-	r = (((dsp_m.echo_hist_pos [3 + 1]) [1] * (int8_t) dsp_m.regs [R_FIR + 3 * 0x10]) >> 6) + (((dsp_m.echo_hist_pos [4 + 1]) [1] * (int8_t) dsp_m.regs [R_FIR + 4 * 0x10]) >> 6) + (((dsp_m.echo_hist_pos [5 + 1]) [1] * (int8_t) dsp_m.regs [R_FIR + 5 * 0x10]) >> 6);
+	dsp_echo_fir( 3, 3, fir );
 
-	dsp_m.t_echo_in [0] += l;
-	dsp_m.t_echo_in [1] += r;
+	dsp_m.t_echo_in [0] += fir [0];
+	dsp_m.t_echo_in [1] += fir [1];
 }
 
 static INLINE void dsp_echo_25 (void)
@@ -1162,6 +1290,7 @@ static void dsp_reset (void)
 	dsp_m.new_kon = dsp_m.regs[R_KON];
 	dsp_m.t_dir   = dsp_m.regs[R_DIR];
 	dsp_m.t_esa   = dsp_m.regs[R_ESA];
+	dsp_update_fir_coef();
 	
 	dsp_soft_reset_common();
 }
@@ -1171,6 +1300,9 @@ static void dsp_reset (void)
 static void dsp_init( void* ram_64k )
 {
 	dsp_m.ram = (uint8_t*) ram_64k;
+#if SPC_DSP_NEON || SPC_DSP_SSE2
+	dsp_init_gauss_interp();
+#endif
 	dsp_set_output( 0, 0 );
 	dsp_reset();
 }
@@ -1234,6 +1366,7 @@ static void dsp_copy_state( unsigned char** io, dsp_copy_func_t copy )
 	
 	/* DSP registers */
 	spc_copier_copy(&copier, dsp_m.regs, REGISTER_COUNT );
+	dsp_update_fir_coef();
 	
 	/* Internal state */
 	
@@ -1437,6 +1570,9 @@ static INLINE void spc_dsp_write( int data, int time )
 		case V_OUTX:
 			dsp_m.outx_buf = (uint8_t) data;
 			break;
+		case 0x0F: /* FIR coefficients */
+			dsp_m.fir_coef [addr >> 4] [0] = dsp_m.fir_coef [addr >> 4] [1] = (int8_t) data;
+			break;
 		case 0x0C:
 			if ( addr == R_KON )
 				dsp_m.new_kon = (uint8_t) data;
@@ -334,6 +334,10 @@ typedef struct
 	int t_echo_out [2];
 	int t_echo_in  [2];
 
+	/* FIR coefficients sign-extended and duplicated for left/right,
+	   kept in sync with the registers for the vectorized FIR */
+	short fir_coef [ECHO_HIST_SIZE] [2];
+
 	dsp_voice_t voices [VOICE_COUNT];
 
 	/* non-emulation state */
@@ -58,6 +58,7 @@ LOCAL_SRC_FILES := \
 	snes9x.cpp \
 	spc7110.cpp \
 	srtc.cpp \
+	stream.cpp \
 	tile.cpp
 
 LOCAL_C_INCLUDES := $(LOCAL_PATH)/../engine $(LOCAL_PATH)/apu $(LOCAL_PATH)/apu/bapu
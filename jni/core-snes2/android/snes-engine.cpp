@@ -9,6 +9,7 @@
 #include "cpuexec.h"
 #include "srtc.h"
 #include "apu.h"
+#include "fixed_resampler.h"
 #include "ppu.h"
 #include "snapshot.h"
 #include "controls.h"
@@ -329,16 +330,28 @@ bool SNESEngine::loadNvm(const char *file)
 
 bool SNESEngine::saveSnapshot(const char *file)
 {
-	if(S9xFreezeGame(file) == TRUE)
-		return true;
-	else
+	// freeze into RAM first so the file is written in a single pass
+	uint32 size = S9xFreezeSize();
+	uint8 *buffer = (uint8 *)malloc(size);
+	if(!buffer)
 		return false;
+
+	bool rv = S9xFreezeGameMem(buffer, size) == TRUE && writeFile(file, buffer, size);
+	free(buffer);
+
+	return rv;
 }
 
 bool SNESEngine::loadSnapshot(const char *file)
 {
-	int rv = S9xUnfreezeGame(file);
-	if(rv != TRUE)
+	void *buffer;
+	int size;
+	if(!readFile(file, &buffer, &size))
+		return false;
+
+	int rv = S9xUnfreezeGameMem((const uint8 *)buffer, size);
+	free(buffer);
+	if(rv != SUCCESS)
 		return false;
 
 	return true;
@@ -469,12 +482,8 @@ void SNESEngine::runFrame(cEmuBitmap *curBitmap, t_emuInputState ctrlState, shor
 	if(soundBuffer)
 	{
 		S9xFinalizeSamples();
-		int sampleCount = S9xGetSampleCount();
+		int sampleCount = S9xDrainSamples(soundBuffer, mRomInfo.soundMaxBytesPerFrame / sizeof(short));
 //		LOGI("sampleCount = %d\n", sampleCount);
-		if(S9xMixSamples((uint8_t *)soundBuffer, sampleCount) == 0)
-		{
-			LOGE("S9xMixSamples failed\n");
-		}
 		*soundSampleByteCount = sampleCount * sizeof(short);
 	}
 
@@ -497,10 +506,29 @@ void SNESEngine::runFrame(cEmuBitmap *curBitmap, t_emuInputState ctrlState, shor
 
 }
 
+static bool getBoolFromString(const char *str)
+{
+	if(!strcasecmp(str, PLUGINOPT_TRUE))
+		return true;
+	else
+		return false;
+}
+
 bool SNESEngine::setOption(const char *name, const char *value)
 {
 	// NOTE: most games on SNES run at 256x224 which already accounts for TV overscan and represents the full image viewable onscreen. The SNES also supports 256x240 which allows for
 	// graphics to be drawn in the overscan area, but I'm not aware of any games that actually use it. Therefore at this time, we dont need to worry about overscan processing with SNES
+	if(!strcasecmp(name, PLUGINOPT_SNES_FAST_SMP))
+	{
+		// opcode-granular SMP execution; games sensitive to SPC700 bus timing must keep the cycle accurate core
+		S9xAPUSetCycleAccurate(getBoolFromString(value) ? FALSE : TRUE);
+		return true;
+	}
+	else if(!strcasecmp(name, PLUGINOPT_SNES_HQ_RESAMPLER))
+	{
+		S9xSetSoundResamplerQuality(getBoolFromString(value) ? FixedResampler::QUALITY_HERMITE : FixedResampler::QUALITY_LINEAR);
+		return true;
+	}
 	return false;
 }
 
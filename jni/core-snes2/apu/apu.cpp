@@ -180,7 +180,7 @@
 #include "apu.h"
 #include "snapshot.h"
 #include "display.h"
-#include "hermite_resampler.h"
+#include "fixed_resampler.h"
 
 #include "snes/snes.hpp"
 
@@ -214,7 +214,8 @@ namespace spc
 	static uint8		*landing_buffer = NULL;
 	static uint8		*shrink_buffer  = NULL;
 
-	static Resampler	*resampler      = NULL;
+	static FixedResampler	*resampler      = NULL;
+	static int			resampler_quality = FixedResampler::QUALITY_HERMITE;
 
 	static int32		reference_time;
 	static uint32		remainder;
@@ -339,6 +340,29 @@ bool8 S9xMixSamples (uint8 *buffer, int sample_count)
 	return (TRUE);
 }
 
+/* Consumer-side read of 16-bit stereo samples. Only the read end of the
+   ring is touched, so the host may call this from its own audio thread
+   while the emulation thread keeps landing samples. Returns the number
+   of samples copied, at most max_samples. */
+int S9xDrainSamples (short *buffer, int max_samples)
+{
+	int	sample_count;
+
+	if (Settings.Mute)
+		return (0);
+
+	sample_count = MIN(spc::resampler->avail(), max_samples) & ~1;
+	if (sample_count <= 0)
+		return (0);
+
+	spc::resampler->read(buffer, sample_count);
+
+	if (Settings.ReverseStereo)
+		ReverseStereo((uint8 *) buffer, sample_count);
+
+	return (sample_count);
+}
+
 int S9xGetSampleCount (void)
 {
 	return (spc::resampler->avail() >> (Settings.Stereo ? 0 : 1));
@@ -445,12 +469,13 @@ bool8 S9xInitSound (int buffer_ms, int lag_ms)
 	   arguments. Use 2x in the resampler for buffer leveling with SoundSync */
 	if (!spc::resampler)
 	{
-		spc::resampler = new HermiteResampler(spc::buffer_size >> (Settings.SoundSync ? 0 : 1));
+		spc::resampler = new FixedResampler(spc::buffer_size >> (Settings.SoundSync ? 0 : 1));
 		if (!spc::resampler)
 		{
 			delete[] spc::landing_buffer;
 			return (FALSE);
 		}
+		spc::resampler->quality(spc::resampler_quality);
 	}
 	else
 		spc::resampler->resize(spc::buffer_size >> (Settings.SoundSync ? 0 : 1));
@@ -469,6 +494,13 @@ void S9xSetSoundControl (uint8 voice_switch)
 	SNES::dsp.spc_dsp.set_stereo_switch (voice_switch << 8 | voice_switch);
 }
 
+void S9xSetSoundResamplerQuality (int quality)
+{
+	spc::resampler_quality = quality;
+	if (spc::resampler)
+		spc::resampler->quality(quality);
+}
+
 void S9xSetSoundMute (bool8 mute)
 {
 	Settings.Mute = mute;
@@ -580,6 +612,11 @@ void S9xAPUTimingSetSpeedup (int ticks)
 	UpdatePlaybackRate();
 }
 
+void S9xAPUSetCycleAccurate (bool8 enable)
+{
+	SNES::smp->set_cycle_accurate(enable);
+}
+
 void S9xResetAPU (void)
 {
 	spc::reference_time = 0;
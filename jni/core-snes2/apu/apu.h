@@ -197,6 +197,7 @@ void S9xAPUEndScanline (void);
 void S9xAPUSetReferenceTime (int32);
 void S9xAPUTimingSetSpeedup (int);
 void S9xAPUAllowTimeOverflow (bool);
+void S9xAPUSetCycleAccurate (bool8);
 void S9xAPULoadState (uint8 *);
 void S9xAPULoadBlarggState(uint8 *oldblock);
 void S9xAPUSaveState (uint8 *);
@@ -210,10 +211,12 @@ bool8 S9xSyncSound (void);
 int S9xGetSampleCount (void);
 void S9xSetSoundControl (uint8);
 void S9xSetSoundMute (bool8);
+void S9xSetSoundResamplerQuality (int);
 void S9xLandSamples (void);
 void S9xFinalizeSamples (void);
 void S9xClearSamples (void);
 bool8 S9xMixSamples (uint8 *, int);
+int S9xDrainSamples (short *, int);
 void S9xSetSamplesAvailableCallback (apu_callback, void *);
 
 #endif
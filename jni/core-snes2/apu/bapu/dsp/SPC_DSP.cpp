@@ -51,6 +51,16 @@ static BOOST::uint8_t const initial_regs [SPC_DSP::register_count] =
 		io = (io >> 31) ^ 0x7FFF;\
 }
 
+// Interpolation and FIR products are computed 4-wide where the target has
+// NEON or SSE2. Define SPC_DSP_NO_SIMD to force the scalar reference code.
+#if !defined (SPC_DSP_NO_SIMD) && defined (__ARM_NEON__)
+	#include <arm_neon.h>
+	#define SPC_DSP_NEON 1
+#elif !defined (SPC_DSP_NO_SIMD) && defined (__SSE2__)
+	#include <emmintrin.h>
+	#define SPC_DSP_SSE2 1
+#endif
+
 // Access global DSP register
 #define REG(n)      m.regs [r_##n]
 
@@ -126,6 +136,52 @@ static short const gauss [512] =
 1299,1300,1300,1301,1302,1302,1303,1303,1303,1304,1304,1304,1304,1304,1305,1305,
 };
 
+#if SPC_DSP_NEON || SPC_DSP_SSE2
+
+// The four gaussian points used for each fractional position, stored
+// contiguously in the order they are applied so they load as one vector
+static short gauss_interp [256] [4] __attribute__((aligned(8)));
+
+static void init_gauss_interp()
+{
+	for ( int offset = 0; offset < 256; offset++ )
+	{
+		gauss_interp [offset] [0] = gauss [255 - offset];
+		gauss_interp [offset] [1] = gauss [511 - offset];
+		gauss_interp [offset] [2] = gauss [256 + offset];
+		gauss_interp [offset] [3] = gauss [      offset];
+	}
+}
+
+inline int SPC_DSP::interpolate( voice_t const* v )
+{
+	short const* g = gauss_interp [v->interp_pos >> 4 & 0xFF];
+	int const* in = &v->buf [(v->interp_pos >> 12) + v->buf_pos];
+
+	// Samples are always in 16-bit range, so narrowing them is lossless
+	int p [4];
+	#if SPC_DSP_NEON
+		int32x4_t prod = vmull_s16( vld1_s16( g ), vmovn_s32( vld1q_s32( in ) ) );
+		vst1q_s32( p, vshrq_n_s32( prod, 11 ) );
+	#else
+		__m128i s  = _mm_loadu_si128( (__m128i const*) in );
+		s          = _mm_packs_epi32( s, s );
+		__m128i gv = _mm_loadl_epi64( (__m128i const*) g );
+		__m128i lo = _mm_mullo_epi16( s, gv );
+		__m128i hi = _mm_mulhi_epi16( s, gv );
+		_mm_storeu_si128( (__m128i*) p, _mm_srai_epi32( _mm_unpacklo_epi16( lo, hi ), 11 ) );
+	#endif
+
+	int out = (int16_t) (p [0] + p [1] + p [2]);
+	out += p [3];
+
+	CLAMP16( out );
+	out &= ~1;
+	return out;
+}
+
+#else
+
 inline int SPC_DSP::interpolate( voice_t const* v )
 {
 	// Make pointers into gaussian based on fractional position between samples
@@ -146,6 +202,8 @@ inline int SPC_DSP::interpolate( voice_t const* v )
 	return out;
 }
 
+#endif
+
 
 //// Counters
 
@@ -610,6 +668,63 @@ inline void SPC_DSP::echo_read( int ch )
 	ECHO_FIR( 0 ) [ch] = ECHO_FIR( 8 ) [ch] = s >> 1;
 }
 
+inline void SPC_DSP::update_fir_coef()
+{
+	for ( int i = 0; i < echo_hist_size; i++ )
+		m.fir_coef [i] [0] = m.fir_coef [i] [1] = (int8_t) REG(fir + i * 0x10);
+}
+
+// Sum of FIR points first to first + count - 1 (count <= 4, first + 3 < 8)
+// for both channels. Each product is still shifted individually, matching
+// CALC_FIR exactly.
+inline void SPC_DSP::echo_fir( int first, int count, int out [2] )
+{
+#if SPC_DSP_NEON || SPC_DSP_SSE2
+	// Lanes of taps beyond count are cleared so the coefficients and history
+	// can always be loaded four taps wide. History values are 15-bit.
+	static short const fir_mask [5] [8] __attribute__((aligned(16))) =
+	{
+		{  0,  0,  0,  0,  0,  0,  0,  0 },
+		{ -1, -1,  0,  0,  0,  0,  0,  0 },
+		{ -1, -1, -1, -1,  0,  0,  0,  0 },
+		{ -1, -1, -1, -1, -1, -1,  0,  0 },
+		{ -1, -1, -1, -1, -1, -1, -1, -1 }
+	};
+	int const* h = ECHO_FIR( first + 1 );
+	short const* c = m.fir_coef [first];
+
+	#if SPC_DSP_NEON
+		int16x8_t cv  = vandq_s16( vld1q_s16( c ), vld1q_s16( fir_mask [count] ) );
+		int32x4_t lo  = vshrq_n_s32( vmull_s16( vmovn_s32( vld1q_s32( h ) ), vget_low_s16( cv ) ), 6 );
+		int32x4_t hi  = vshrq_n_s32( vmull_s16( vmovn_s32( vld1q_s32( h + 4 ) ), vget_high_s16( cv ) ), 6 );
+		int32x4_t sum = vaddq_s32( lo, hi );
+		vst1_s32( out, vadd_s32( vget_low_s32( sum ), vget_high_s32( sum ) ) );
+	#else
+		__m128i cv  = _mm_and_si128( _mm_loadu_si128( (__m128i const*) c ),
+				_mm_load_si128( (__m128i const*) fir_mask [count] ) );
+		__m128i hv  = _mm_packs_epi32( _mm_loadu_si128( (__m128i const*) h ),
+				_mm_loadu_si128( (__m128i const*) (h + 4) ) );
+		__m128i plo = _mm_mullo_epi16( hv, cv );
+		__m128i phi = _mm_mulhi_epi16( hv, cv );
+		__m128i sum = _mm_add_epi32( _mm_srai_epi32( _mm_unpacklo_epi16( plo, phi ), 6 ),
+				_mm_srai_epi32( _mm_unpackhi_epi16( plo, phi ), 6 ) );
+		sum = _mm_add_epi32( sum, _mm_srli_si128( sum, 8 ) );
+		out [0] = _mm_cvtsi128_si32( sum );
+		out [1] = _mm_cvtsi128_si32( _mm_srli_si128( sum, 4 ) );
+	#endif
+#else
+	int l = 0;
+	int r = 0;
+	for ( int i = first; i < first + count; i++ )
+	{
+		l += CALC_FIR( i, 0 );
+		r += CALC_FIR( i, 1 );
+	}
+	out [0] = l;
+	out [1] = r;
+#endif
+}
+
 ECHO_CLOCK( 22 )
 {
 	// History
@@ -628,21 +743,21 @@ ECHO_CLOCK( 22 )
 }
 ECHO_CLOCK( 23 )
 {
-	int l = CALC_FIR( 1, 0 ) + CALC_FIR( 2, 0 );
-	int r = CALC_FIR( 1, 1 ) + CALC_FIR( 2, 1 );
+	int fir [2];
+	echo_fir( 1, 2, fir );
 
-	m.t_echo_in [0] += l;
-	m.t_echo_in [1] += r;
+	m.t_echo_in [0] += fir [0];
+	m.t_echo_in [1] += fir [1];
 
 	echo_read( 1 );
 }
 ECHO_CLOCK( 24 )
 {
-	int l = CALC_FIR( 3, 0 ) + CALC_FIR( 4, 0 ) + CALC_FIR( 5, 0 );
-	int r = CALC_FIR( 3, 1 ) + CALC_FIR( 4, 1 ) + CALC_FIR( 5, 1 );
+	int fir [2];
+	echo_fir( 3, 3, fir );
 
-	m.t_echo_in [0] += l;
-	m.t_echo_in [1] += r;
+	m.t_echo_in [0] += fir [0];
+	m.t_echo_in [1] += fir [1];
 }
 ECHO_CLOCK( 25 )
 {
@@ -820,6 +935,9 @@ void SPC_DSP::run( int clocks_remain )
 void SPC_DSP::init( void* ram_64k )
 {
 	m.ram = (uint8_t*) ram_64k;
+	#if SPC_DSP_NEON || SPC_DSP_SSE2
+		init_gauss_interp();
+	#endif
 	mute_voices( 0 );
 	disable_surround( false );
 	set_output( 0, 0 );
@@ -883,6 +1001,7 @@ void SPC_DSP::load( uint8_t const regs [register_count] )
 	m.new_kon = REG(kon);
 	m.t_dir   = REG(dir);
 	m.t_esa   = REG(esa);
+	update_fir_coef();
 
 	soft_reset_common();
 }
@@ -939,6 +1058,7 @@ void SPC_DSP::copy_state( unsigned char** io, copy_func_t copy )
 
 	// DSP registers
 	copier.copy( m.regs, register_count );
+	update_fir_coef();
 
 	// Internal state
 
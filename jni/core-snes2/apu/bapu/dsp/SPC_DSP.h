@@ -188,6 +188,10 @@ private:
 		int t_echo_out [2];
 		int t_echo_in  [2];
 
+		// FIR coefficients sign-extended and duplicated for left/right,
+		// kept in sync with the registers for the vectorized FIR
+		short fir_coef [echo_hist_size] [2];
+
 		voice_t voices [voice_count];
 
 		// non-emulation state
@@ -231,6 +235,8 @@ private:
 	void voice_V9_V6_V3( voice_t* const );
 
 	void echo_read( int ch );
+	void update_fir_coef();
+	void echo_fir( int first, int count, int out [2] );
 	int  echo_output( int ch );
 	void echo_write( int ch );
 	void echo_22();
@@ -271,6 +277,10 @@ inline void SPC_DSP::write( int addr, int data )
 		m.outx_buf = (uint8_t) data;
 		break;
 
+	case 0x0F: // FIR coefficients
+		m.fir_coef [addr >> 4] [0] = m.fir_coef [addr >> 4] [1] = (int8_t) data;
+		break;
+
 	case 0x0C:
 		if ( addr == r_kon )
 			m.new_kon = (uint8_t) data;
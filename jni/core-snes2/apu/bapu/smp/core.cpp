@@ -49,6 +49,29 @@ void SMP::op_write(uint16 addr, uint8 data) {
   apuram[addr] = data;  //all writes go to RAM, even MMIO writes
 }
 
+//opcode-granular variants used by op_step_fast(): bus accesses only count
+//clocks, timers and the DSP clock are advanced once per instruction
+void SMP::op_io_fast() {
+  op_clocks++;
+}
+
+void SMP::op_io_fast(unsigned clocks) {
+  op_clocks += clocks;
+}
+
+uint8 SMP::op_read_fast(uint16 addr) {
+  op_clocks++;
+  if((addr & 0xfff0) == 0x00f0) return mmio_read(addr);
+  if(addr >= 0xffc0 && status.iplrom_enable) return iplrom[addr & 0x3f];
+  return apuram[addr];
+}
+
+void SMP::op_write_fast(uint16 addr, uint8 data) {
+  op_clocks++;
+  if((addr & 0xfff0) == 0x00f0) mmio_write(addr, data);
+  apuram[addr] = data;
+}
+
 void SMP::op_step() {
   #define op_readpc() op_read(regs.pc++)
   #define op_readdp(addr) op_read((regs.p.p << 8) + addr)
@@ -115,6 +138,34 @@ void SMP::op_step() {
   #endif // defined(CYCLE_ACCURATE)
 }
 
+void SMP::op_step_fast() {
+  #define op_io op_io_fast
+  #define op_read op_read_fast
+  #define op_write op_write_fast
+
+  op_clocks = 0;
+
+  //a split opcode may still be pending when switching over from op_step()
+  if(opcode_cycle == 0)
+    opcode_number = op_readpc();
+
+  do {
+    switch(opcode_number) {
+      #include "core/oppseudo_misc.cpp"
+      #include "core/oppseudo_mov.cpp"
+      #include "core/oppseudo_pc.cpp"
+      #include "core/oppseudo_read.cpp"
+      #include "core/oppseudo_rmw.cpp"
+    }
+  } while(opcode_cycle);
+
+  tick(op_clocks);
+
+  #undef op_io
+  #undef op_read
+  #undef op_write
+}
+
 const unsigned SMP::cycle_count_table[256] = {
   #define c 12
 //0 1 2 3   4 5 6 7   8 9 A B   C D E F
@@ -41,7 +41,17 @@ void SMP::synchronize_dsp() {
 }
 
 void SMP::enter() {
-  while(clock < 0) op_step();
+  if(cycle_accurate) {
+    while(clock < 0) op_step();
+  } else {
+    while(clock < 0) op_step_fast();
+  }
+}
+
+//when disabled, whole instructions are executed per step and the timers and
+//DSP clock are only advanced once the instruction has completed
+void SMP::set_cycle_accurate(bool enable) {
+  cycle_accurate = enable;
 }
 
 void SMP::power() {
@@ -149,6 +159,8 @@ void SMP::serialize(serializer &s) {
 
 SMP::SMP() {
   apuram = new uint8[64 * 1024];
+  cycle_accurate = true;
+  op_clocks = 0;
 }
 
 SMP::~SMP() {
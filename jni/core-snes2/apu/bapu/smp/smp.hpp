@@ -14,6 +14,7 @@ public:
   void mmio_write(unsigned addr, unsigned data);
 
   void enter();
+  void set_cycle_accurate(bool enable);
   void power();
   void reset();
 
@@ -102,6 +103,15 @@ public:
   debugvirtual alwaysinline uint8 op_read(uint16 addr);
   debugvirtual alwaysinline void op_write(uint16 addr, uint8 data);
   debugvirtual alwaysinline void op_step();
+
+  //opcode-granular execution, see set_cycle_accurate()
+  bool cycle_accurate;
+  unsigned op_clocks;
+  alwaysinline void op_io_fast();
+  alwaysinline void op_io_fast(unsigned clocks);
+  alwaysinline uint8 op_read_fast(uint16 addr);
+  alwaysinline void op_write_fast(uint16 addr, uint8 data);
+  void op_step_fast();
   static const unsigned cycle_count_table[256];
   uint64 cycle_table_cpu[256];
   unsigned cycle_table_dsp[256];
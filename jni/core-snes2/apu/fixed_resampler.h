@@ -0,0 +1,197 @@
+/* Fixed-point resampler with linear or 4-point hermite interpolation */
+
+#ifndef __FIXED_RESAMPLER_H
+#define __FIXED_RESAMPLER_H
+
+#include "resampler.h"
+
+#undef CLAMP
+#undef SHORT_CLAMP
+#define CLAMP(x, low, high) (((x) > (high)) ? (high) : (((x) < (low)) ? (low) : (x)))
+#define SHORT_CLAMP(n) ((short) CLAMP((n), -32768, 32767))
+
+class FixedResampler : public Resampler
+{
+    public:
+        enum
+        {
+            QUALITY_LINEAR  = 0,
+            QUALITY_HERMITE = 1
+        };
+
+    protected:
+
+        /* Positions are 16.16 fixed point in units of input frames */
+        enum { FRAC_ONE = 1 << 16 };
+
+        int    r_step;
+        int    r_frac;
+        int    r_quality;
+        int    r_left[4], r_right[4];
+
+        /* 4-point hermite with mu in Q15, computed in 32 bits:
+           a0 * b + a3 * c stays below 2^30 and the tangent terms below 2^29 */
+        static inline int
+        hermite (int mu, int a, int b, int c, int d)
+        {
+            int mu2, mu3, a0, a1, a2, a3;
+
+            mu2 = (mu * mu) >> 15;
+            mu3 = (mu2 * mu) >> 15;
+
+            a0 = 2 * mu3 - 3 * mu2 + 32768;
+            a1 =     mu3 - 2 * mu2 + mu;
+            a2 =     mu3 -     mu2;
+            a3 = 3 * mu2 - 2 * mu3;
+
+            return (a0 * b + a3 * c + ((a1 * (c - a) + a2 * (d - b)) >> 1) + 16384) >> 15;
+        }
+
+        static inline int
+        linear (int mu, int b, int c)
+        {
+            return b + (((c - b) * mu) >> 15);
+        }
+
+        inline void
+        shift_in (int s_left, int s_right)
+        {
+            r_left [0] = r_left [1];
+            r_left [1] = r_left [2];
+            r_left [2] = r_left [3];
+            r_left [3] = s_left;
+
+            r_right[0] = r_right[1];
+            r_right[1] = r_right[2];
+            r_right[2] = r_right[3];
+            r_right[3] = s_right;
+        }
+
+        /* At a ratio of exactly 1:1 every output frame lands on an input
+           frame, so samples are copied straight out of the ring. The ratio
+           only changes through time_ratio (), which clears the history. */
+        void
+        read_unity (short *data, int num_samples)
+        {
+            int start = read_offset ();
+            int bytes = MIN (num_samples << 1, space_filled ()) & ~3;
+            int first = MIN (bytes, buffer_size - start);
+
+            memcpy (data, buffer + start, first);
+            if (bytes > first)
+                memcpy ((unsigned char *) data + first, buffer, bytes - first);
+
+            read_commit (bytes);
+        }
+
+    public:
+        FixedResampler (int num_samples) : Resampler (num_samples)
+        {
+            r_step = FRAC_ONE;
+            r_quality = QUALITY_HERMITE;
+            clear ();
+        }
+
+        ~FixedResampler ()
+        {
+        }
+
+        void
+        time_ratio (double ratio)
+        {
+            r_step = (int) (ratio * FRAC_ONE + 0.5);
+            clear ();
+        }
+
+        void
+        quality (int level)
+        {
+            r_quality = level;
+        }
+
+        void
+        clear (void)
+        {
+            ring_buffer::clear ();
+            r_frac = 0;
+            r_left [0] = r_left [1] = r_left [2] = r_left [3] = 0;
+            r_right[0] = r_right[1] = r_right[2] = r_right[3] = 0;
+        }
+
+        void
+        read (short *data, int num_samples)
+        {
+            if (r_step == FRAC_ONE && r_frac == 0)
+            {
+                read_unity (data, num_samples);
+                return;
+            }
+
+            int i_position = read_offset () >> 1;
+            int max_samples = buffer_size >> 1;
+            int max_consumed = space_filled () >> 1;
+            short *internal_buffer = (short *) buffer;
+            int o_position = 0;
+            int consumed = 0;
+
+            while (o_position < num_samples && consumed < max_consumed)
+            {
+                if (r_quality == QUALITY_HERMITE)
+                {
+                    while (r_frac < FRAC_ONE && o_position < num_samples)
+                    {
+                        int mu = r_frac >> 1;
+                        int l = hermite (mu, r_left [0], r_left [1], r_left [2], r_left [3]);
+                        int r = hermite (mu, r_right[0], r_right[1], r_right[2], r_right[3]);
+                        data[o_position]     = SHORT_CLAMP (l);
+                        data[o_position + 1] = SHORT_CLAMP (r);
+
+                        o_position += 2;
+
+                        r_frac += r_step;
+                    }
+                }
+                else
+                {
+                    while (r_frac < FRAC_ONE && o_position < num_samples)
+                    {
+                        int mu = r_frac >> 1;
+                        data[o_position]     = (short) linear (mu, r_left [1], r_left [2]);
+                        data[o_position + 1] = (short) linear (mu, r_right[1], r_right[2]);
+
+                        o_position += 2;
+
+                        r_frac += r_step;
+                    }
+                }
+
+                if (r_frac >= FRAC_ONE)
+                {
+                    shift_in (internal_buffer[i_position], internal_buffer[i_position + 1]);
+
+                    r_frac -= FRAC_ONE;
+
+                    i_position += 2;
+                    if (i_position >= max_samples)
+                        i_position -= max_samples;
+                    consumed += 2;
+                }
+            }
+
+            read_commit (consumed << 1);
+        }
+
+        inline int
+        avail (void)
+        {
+            int frames = space_filled () >> 2;
+
+            if (r_step == FRAC_ONE && r_frac == 0)
+                return frames * 2;
+
+            long long span = (long long) frames * FRAC_ONE - r_frac;
+            return (span > 0) ? (int) (span / r_step) * 2 : 0;
+        }
+};
+
+#endif /* __FIXED_RESAMPLER_H */
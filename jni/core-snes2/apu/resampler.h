@@ -32,18 +32,6 @@ class Resampler : public ring_buffer
             return true;
         }
 
-        inline int
-        space_empty (void)
-        {
-            return buffer_size - size;
-        }
-    
-        inline int
-        space_filled (void)
-        {
-            return size;
-        }
-        
         inline int
         max_write (void)
         {
@@ -8,14 +8,71 @@
 #undef MIN
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
+/* The buffer is lock-free for a single producer (push) and a single consumer
+   (pull, or a resampler reading in place), so the host may drain samples on
+   its own audio thread. clear (), resize () and cache_silence () reset both
+   ends and must not run concurrently with either side. */
+
+static inline int
+ring_load_acquire (volatile int *p)
+{
+    int value = *p;
+    __sync_synchronize ();
+    return value;
+}
+
+static inline void
+ring_store_release (volatile int *p, int value)
+{
+    __sync_synchronize ();
+    *p = value;
+}
+
 class ring_buffer
 {
 protected:
-    int size;
     int buffer_size;
-    int start;
     unsigned char *buffer;
 
+    /* Positions run over [0, 2 * buffer_size) so that a full buffer can be
+       told apart from an empty one. write_pos is only advanced by the
+       producer and read_pos only by the consumer. */
+    volatile int write_pos;
+    volatile int read_pos;
+
+    inline int
+    filled (int w, int r)
+    {
+        int n = w - r;
+        return (n < 0) ? n + (buffer_size << 1) : n;
+    }
+
+    inline int
+    offset (int pos)
+    {
+        return (pos >= buffer_size) ? pos - buffer_size : pos;
+    }
+
+    inline int
+    advance (int pos, int bytes)
+    {
+        pos += bytes;
+        return (pos >= (buffer_size << 1)) ? pos - (buffer_size << 1) : pos;
+    }
+
+    /* Consumer-side access for readers working directly on the buffer */
+    inline int
+    read_offset (void)
+    {
+        return offset (read_pos);
+    }
+
+    inline void
+    read_commit (int bytes)
+    {
+        ring_store_release (&read_pos, advance (read_pos, bytes));
+    }
+
 public:
     ring_buffer (int buffer_size)
     {
@@ -23,8 +80,8 @@ public:
         buffer = new unsigned char[this->buffer_size];
         memset (buffer, 0, this->buffer_size);
 
-        size = 0;
-        start = 0;
+        write_pos = 0;
+        read_pos = 0;
     }
 
     ~ring_buffer (void)
@@ -38,7 +95,7 @@ public:
         if (space_empty () < bytes)
             return false;
 
-        int end = (start + size) % buffer_size;
+        int end = offset (write_pos);
         int first_write_size = MIN (bytes, buffer_size - end);
 
         memcpy (buffer + end, src, first_write_size);
@@ -46,7 +103,7 @@ public:
         if (bytes > first_write_size)
             memcpy (buffer, src + first_write_size, bytes - first_write_size);
 
-        size += bytes;
+        ring_store_release (&write_pos, advance (write_pos, bytes));
 
         return true;
     }
@@ -57,13 +114,14 @@ public:
         if (space_filled () < bytes)
             return false;
 
+        int start = offset (read_pos);
+
         memcpy (dst, buffer + start, MIN (bytes, buffer_size - start));
 
         if (bytes > (buffer_size - start))
             memcpy (dst + (buffer_size - start), buffer, bytes - (buffer_size - start));
 
-        start = (start + bytes) % buffer_size;
-        size -= bytes;
+        read_commit (bytes);
 
         return true;
     }
@@ -71,20 +129,20 @@ public:
     inline int
     space_empty (void)
     {
-        return buffer_size - size;
+        return buffer_size - filled (write_pos, ring_load_acquire (&read_pos));
     }
 
     inline int
     space_filled (void)
     {
-        return size;
+        return filled (ring_load_acquire (&write_pos), read_pos);
     }
 
     void
     clear (void)
     {
-        start = 0;
-        size = 0;
+        write_pos = 0;
+        read_pos = 0;
         memset (buffer, 0, buffer_size);
     }
 
@@ -96,15 +154,15 @@ public:
         buffer = new unsigned char[buffer_size];
         memset (buffer, 0, this->buffer_size);
 
-        size = 0;
-        start = 0;
+        write_pos = 0;
+        read_pos = 0;
     }
 
     inline void
     cache_silence (void)
     {
         clear ();
-        size = buffer_size;
+        write_pos = buffer_size;
     }
 };
 
@@ -185,6 +185,7 @@
 #include "fxemu.h"
 #include "sdd1.h"
 #include "srtc.h"
+#include "stream.h"
 #include "snapshot.h"
 #include "controls.h"
 #include "movie.h"
@@ -1142,13 +1143,13 @@ static FreezeData	SnapMovie[] =
 	INT_ENTRY(6, MovieInputDataSize)
 };
 
-static int UnfreezeBlock (STREAM, const char *, uint8 *, int);
-static int UnfreezeBlockCopy (STREAM, const char *, uint8 **, int);
-static int UnfreezeStruct (STREAM, const char *, void *, FreezeData *, int, int);
-static int UnfreezeStructCopy (STREAM, const char *, uint8 **, FreezeData *, int, int);
+static int UnfreezeBlock (Stream *, const char *, uint8 *, int);
+static int UnfreezeBlockCopy (Stream *, const char *, uint8 **, int);
+static int UnfreezeStruct (Stream *, const char *, void *, FreezeData *, int, int);
+static int UnfreezeStructCopy (Stream *, const char *, uint8 **, FreezeData *, int, int);
 static void UnfreezeStructFromCopy (void *, FreezeData *, int, uint8 *, int);
-static void FreezeBlock (STREAM, const char *, uint8 *, int);
-static void FreezeStruct (STREAM, const char *, void *, FreezeData *, int);
+static void FreezeBlock (Stream *, const char *, uint8 *, int);
+static void FreezeStruct (Stream *, const char *, void *, FreezeData *, int);
 
 
 void S9xResetSaveTimer (bool8 dontsave)
@@ -1268,7 +1269,39 @@ bool8 S9xUnfreezeGame (const char *filename)
 	return (FALSE);
 }
 
+uint32 S9xFreezeSize (void)
+{
+	memStream	stream((uint8 *) NULL, 0);
+
+	S9xFreezeToStream(&stream);
+
+	return (stream.pos());
+}
+
+bool8 S9xFreezeGameMem (uint8 *buf, uint32 bufSize)
+{
+	memStream	stream(buf, bufSize);
+
+	S9xFreezeToStream(&stream);
+
+	return (stream.pos() <= bufSize);
+}
+
+int S9xUnfreezeGameMem (const uint8 *buf, uint32 bufSize)
+{
+	memStream	stream(buf, bufSize);
+
+	return (S9xUnfreezeFromStream(&stream));
+}
+
 void S9xFreezeToStream (STREAM stream)
+{
+	fStream	fs(stream);
+
+	S9xFreezeToStream(&fs);
+}
+
+void S9xFreezeToStream (Stream *stream)
 {
 	char	buffer[1024];
 	uint8	*soundsnapshot = new uint8[SPC_SAVE_STATE_BLOCK_SIZE];
@@ -1276,10 +1309,10 @@ void S9xFreezeToStream (STREAM stream)
 	S9xSetSoundMute(TRUE);
 
 	sprintf(buffer, "%s:%04d\n", SNAPSHOT_MAGIC, SNAPSHOT_VERSION);
-	WRITE_STREAM(buffer, strlen(buffer), stream);
+	stream->write(buffer, strlen(buffer));
 
 	sprintf(buffer, "NAM:%06d:%s%c", (int) strlen(Memory.ROMFilename) + 1, Memory.ROMFilename, 0);
-	WRITE_STREAM(buffer, strlen(buffer) + 1, stream);
+	stream->write(buffer, strlen(buffer) + 1);
 
 	FreezeStruct(stream, "CPU", &CPU, SnapCPU, COUNT(SnapCPU));
 
@@ -1416,13 +1449,20 @@ void S9xFreezeToStream (STREAM stream)
 }
 
 int S9xUnfreezeFromStream (STREAM stream)
+{
+	fStream	fs(stream);
+
+	return (S9xUnfreezeFromStream(&fs));
+}
+
+int S9xUnfreezeFromStream (Stream *stream)
 {
 	int		result = SUCCESS;
 	int		version, len;
 	char	buffer[PATH_MAX + 1];
 
 	len = strlen(SNAPSHOT_MAGIC) + 1 + 4 + 1;
-	if (READ_STREAM(buffer, len, stream) != len)
+	if (stream->read(buffer, len) != len)
 		return (WRONG_FORMAT);
 
 	if (strncmp(buffer, SNAPSHOT_MAGIC, strlen(SNAPSHOT_MAGIC)) != 0)
@@ -1848,7 +1888,7 @@ static int FreezeSize (int size, int type)
 	}
 }
 
-static void FreezeStruct (STREAM stream, const char *name, void *base, FreezeData *fields, int num_fields)
+static void FreezeStruct (Stream *stream, const char *name, void *base, FreezeData *fields, int num_fields)
 {
 	int	len = 0;
 	int	i, j;
@@ -1970,7 +2010,7 @@ static void FreezeStruct (STREAM stream, const char *name, void *base, FreezeDat
 	delete [] block;
 }
 
-static void FreezeBlock (STREAM stream, const char *name, uint8 *block, int size)
+static void FreezeBlock (Stream *stream, const char *name, uint8 *block, int size)
 {
 	char	buffer[20];
 
@@ -1989,24 +2029,24 @@ static void FreezeBlock (STREAM stream, const char *name, uint8 *block, int size
 
 	buffer[11] = 0;
 
-	WRITE_STREAM(buffer, 11, stream);
-	WRITE_STREAM(block, size, stream);
+	stream->write(buffer, 11);
+	stream->write(block, size);
 }
 
-static int UnfreezeBlock (STREAM stream, const char *name, uint8 *block, int size)
+static int UnfreezeBlock (Stream *stream, const char *name, uint8 *block, int size)
 {
 	char	buffer[20];
 	int		len = 0, rem = 0;
-	long	rewind = FIND_STREAM(stream);
+	size_t	rewind = stream->pos();
 
-	size_t	l = READ_STREAM(buffer, 11, stream);
+	size_t	l = stream->read(buffer, 11);
 	buffer[l] = 0;
 
 	if (l != 11 || strncmp(buffer, name, 3) != 0 || buffer[3] != ':')
 	{
 	err:
 		fprintf(stdout, "absent: %s(%d); next: '%.11s'\n", name, size, buffer);
-		REVERT_STREAM(stream, FIND_STREAM(stream) - l, 0);
+		stream->revert(stream->pos() - l);
 		return (WRONG_FORMAT);
 	}
 
@@ -2031,20 +2071,20 @@ static int UnfreezeBlock (STREAM stream, const char *name, uint8 *block, int siz
 
 	ZeroMemory(block, size);
 
-	if (READ_STREAM(block, len, stream) != len)
+	if (stream->read(block, len) != len)
 	{
-		REVERT_STREAM(stream, rewind, 0);
+		stream->revert(rewind);
 		return (WRONG_FORMAT);
 	}
 
 	if (rem)
 	{
 		char	*junk = new char[rem];
-		len = READ_STREAM(junk, rem, stream);
+		len = stream->read(junk, rem);
 		delete [] junk;
 		if (len != rem)
 		{
-			REVERT_STREAM(stream, rewind, 0);
+			stream->revert(rewind);
 			return (WRONG_FORMAT);
 		}
 	}
@@ -2052,7 +2092,7 @@ static int UnfreezeBlock (STREAM stream, const char *name, uint8 *block, int siz
 	return (SUCCESS);
 }
 
-static int UnfreezeBlockCopy (STREAM stream, const char *name, uint8 **block, int size)
+static int UnfreezeBlockCopy (Stream *stream, const char *name, uint8 **block, int size)
 {
 	int	result;
 
@@ -2069,7 +2109,7 @@ static int UnfreezeBlockCopy (STREAM stream, const char *name, uint8 **block, in
 	return (SUCCESS);
 }
 
-static int UnfreezeStruct (STREAM stream, const char *name, void *base, FreezeData *fields, int num_fields, int version)
+static int UnfreezeStruct (Stream *stream, const char *name, void *base, FreezeData *fields, int num_fields, int version)
 {
 	int		result;
 	uint8	*block = NULL;
@@ -2088,7 +2128,7 @@ static int UnfreezeStruct (STREAM stream, const char *name, void *base, FreezeDa
 	return (SUCCESS);
 }
 
-static int UnfreezeStructCopy (STREAM stream, const char *name, uint8 **block, FreezeData *fields, int num_fields, int version)
+static int UnfreezeStructCopy (Stream *stream, const char *name, uint8 **block, FreezeData *fields, int num_fields, int version)
 {
 	int	len = 0;
 
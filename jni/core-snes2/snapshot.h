@@ -190,11 +190,18 @@
 #define NOT_A_MOVIE_SNAPSHOT	(-5)
 #define SNAPSHOT_INCONSISTENT	(-6)
 
+class Stream;
+
 void S9xResetSaveTimer (bool8);
 bool8 S9xFreezeGame (const char *);
 bool8 S9xUnfreezeGame (const char *);
+uint32 S9xFreezeSize (void);
+bool8 S9xFreezeGameMem (uint8 *, uint32);
+int	 S9xUnfreezeGameMem (const uint8 *, uint32);
 void S9xFreezeToStream (STREAM);
+void S9xFreezeToStream (Stream *);
 int	 S9xUnfreezeFromStream (STREAM);
+int	 S9xUnfreezeFromStream (Stream *);
 bool8 S9xSPCDump (const char *);
 
 #endif
@@ -99,11 +99,24 @@ typedef struct
 #define PLUGINOPT_GB_HWTYPE			"gameset_gb_hwtype"
 #define PLUGINOPT_GB_PALETTE		"gameset_gb_palette"
 
+// GBA plugin specific
+#define PLUGINOPT_GBA_IDLE_SKIP		"gameset_gba_idle_skip"
+#define PLUGINOPT_GBA_RECOMPILER	"gameset_gba_recompiler"
+
 // SMS plugin specific
 #define PLUGINOPT_SMS_ENABLE_FM		"gameset_sms_enable_fm"
 
+// Genesis plugin specific
+#define PLUGINOPT_GENESIS_Z80_IDLE_SKIP	"gameset_genesis_z80_idle_skip"
+
+// SNES plugin specific
+#define PLUGINOPT_SNES_FAST_SMP		"gameset_snes_fast_smp"
+#define PLUGINOPT_SNES_HQ_RESAMPLER	"gameset_snes_hq_resampler"
+
 // PCE plugin specific
 #define PLUGINOPT_PCE_ENABLE_6BUTTON "gameset_pce_enable_6_button"
+#define PLUGINOPT_PCE_AUTO_FRAMESKIP "gameset_pce_auto_frameskip"
+#define PLUGINOPT_PCE_LOAD_SOUND_RATE "gameset_pce_load_sound_rate" // applied at the next ROM load
 
 // NES plugin specific
 #define PLUGINOPT_NES_ENABLE_VAUSFILTER "gameset_nes_enable_vausfilter"